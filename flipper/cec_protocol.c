@@ -0,0 +1,468 @@
+#include "cec_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint16_t cec_protocol_crc16_update(uint16_t crc, uint8_t byte) {
+    crc ^= (uint16_t)byte << 8;
+    for(uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+size_t cec_protocol_frame_encode(
+    uint8_t opcode, uint8_t seq, const uint8_t* payload, size_t payload_length, uint8_t* out, size_t out_size) {
+    size_t length = payload_length + 2;
+    if(payload_length > CEC_FRAME_MAX_PAYLOAD || length + 5 > out_size) {
+        return 0;
+    }
+    
+    out[0] = CEC_FRAME_SYNC;
+    out[1] = length & 0xFF;
+    out[2] = length >> 8;
+    out[3] = opcode;
+    out[4] = seq;
+    if(payload_length > 0) {
+        memcpy(&out[5], payload, payload_length);
+    }
+    
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 1; i < length + 3; i++) {
+        crc = cec_protocol_crc16_update(crc, out[i]);
+    }
+    out[length + 3] = crc & 0xFF;
+    out[length + 4] = crc >> 8;
+    
+    return length + 5;
+}
+
+void cec_protocol_frame_decoder_reset(CECFrameDecoder* decoder) {
+    decoder->state = CECFrameStateSync;
+    decoder->length = 0;
+    decoder->received = 0;
+}
+
+CECFrameEvent cec_protocol_frame_decoder_feed(CECFrameDecoder* decoder, uint8_t byte) {
+    CECFrameEvent event = CECFrameEventNone;
+    
+    switch(decoder->state) {
+    case CECFrameStateSync:
+        if(byte == CEC_FRAME_SYNC) {
+            decoder->crc = 0xFFFF;
+            decoder->state = CECFrameStateLengthLow;
+        }
+        break;
+    case CECFrameStateLengthLow:
+        decoder->length = byte;
+        decoder->crc = cec_protocol_crc16_update(decoder->crc, byte);
+        decoder->state = CECFrameStateLengthHigh;
+        break;
+    case CECFrameStateLengthHigh:
+        decoder->length |= (uint16_t)byte << 8;
+        decoder->crc = cec_protocol_crc16_update(decoder->crc, byte);
+        if(decoder->length < 2 || decoder->length > CEC_FRAME_MAX_PAYLOAD + 2) {
+            cec_protocol_frame_decoder_reset(decoder);
+        } else {
+            decoder->received = 0;
+            decoder->state = CECFrameStateBody;
+        }
+        break;
+    case CECFrameStateBody:
+        if(decoder->received == 0) {
+            decoder->opcode = byte;
+        } else if(decoder->received == 1) {
+            decoder->seq = byte;
+            decoder->payload_length = 0;
+            event = CECFrameEventHeader;
+        } else {
+            decoder->payload_length++;
+            event = CECFrameEventPayload;
+        }
+        decoder->crc = cec_protocol_crc16_update(decoder->crc, byte);
+        if(++decoder->received == decoder->length) {
+            decoder->state = CECFrameStateCrcLow;
+        }
+        break;
+    case CECFrameStateCrcLow:
+        decoder->crc_received = byte;
+        decoder->state = CECFrameStateCrcHigh;
+        break;
+    case CECFrameStateCrcHigh:
+        decoder->crc_received |= (uint16_t)byte << 8;
+        decoder->state = CECFrameStateSync;
+        if(decoder->crc_received == decoder->crc) {
+            return CECFrameEventComplete;
+        }
+        decoder->crc_errors++;
+        return CECFrameEventCrcError;
+    }
+    return event;
+}
+
+// Alternating bits and both idle levels, so a rate that is almost right still fails
+static const uint8_t cec_protocol_baud_unit[] = {0x55, 0xAA, 0x00, 0xFF};
+
+void cec_protocol_baud_request(CECRequest* request, CECBaudAction action, uint32_t rate) {
+    request->opcode = CECOpBaud;
+    request->data[0] = action;
+    for(size_t i = 0; i < 4; i++) {
+        request->data[1 + i] = rate >> (8 * i);
+    }
+    request->length = 5;
+    if(action == CECBaudVerify) {
+        for(size_t i = 0; i < CEC_BAUD_PATTERN_SIZE; i++) {
+            request->data[request->length++] = cec_protocol_baud_unit[i % sizeof(cec_protocol_baud_unit)];
+        }
+    }
+}
+
+void cec_protocol_key_request(CECRequest* request, CECKeyAction action, uint8_t key, uint8_t destination) {
+    request->opcode = CECOpKey;
+    request->data[0] = action;
+    request->data[1] = key;
+    request->data[2] = destination;
+    request->length = 3;
+}
+
+void cec_protocol_watch_request(CECRequest* request, bool on) {
+    request->opcode = CECOpWatch;
+    request->data[0] = on;
+    request->length = 1;
+}
+
+bool cec_protocol_event_parse(const uint8_t* payload, size_t length, CECEvent* event) {
+    if(length < 2) {
+        return false;
+    }
+    memset(event, 0, sizeof(*event));
+    event->type = payload[0];
+    event->logical = payload[1] & 0x0F;
+    switch(event->type) {
+    case CECEventPower:
+        if(length < 3) {
+            return false;
+        }
+        event->power = payload[2];
+        return true;
+    case CECEventSource:
+        if(length < 4) {
+            return false;
+        }
+        event->physical = (payload[2] << 8) | payload[3];
+        return true;
+    case CECEventDevice: {
+        size_t name_length = length - 2 < sizeof(event->name) - 1 ? length - 2 : sizeof(event->name) - 1;
+        memcpy(event->name, &payload[2], name_length);
+        return true;
+    }
+    case CECEventGone:
+        return true;
+    case CECEventReady:
+        if(length < 3) {
+            return false;
+        }
+        event->adapter_ok = payload[2] != 0;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool cec_protocol_baud_pattern_matches(const uint8_t* data, size_t length) {
+    if(length != CEC_BAUD_PATTERN_SIZE) {
+        return false;
+    }
+    for(size_t i = 0; i < length; i++) {
+        if(data[i] != cec_protocol_baud_unit[i % sizeof(cec_protocol_baud_unit)]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void cec_protocol_build_json(const CECRequest* request, uint8_t seq, char* buffer, size_t buffer_size) {
+    char cec_command[CEC_REQUEST_MAX_DATA * 3 + 4];
+    
+    switch(request->opcode) {
+    case CECOpPing:
+        snprintf(
+            buffer, buffer_size, "{\"command\":\"PING\",\"proto\":%d,\"id\":%u}", CEC_PROTOCOL_VERSION, seq);
+        return;
+    case CECOpScan:
+        snprintf(buffer, buffer_size, "{\"command\":\"SCAN\",\"id\":%u}", seq);
+        return;
+    case CECOpDiscover:
+        snprintf(
+            buffer,
+            buffer_size,
+            "{\"command\":\"DISCOVER\",\"full\":%s,\"id\":%u}",
+            request->length && (request->data[0] & CECDiscoverFull) ? "true" : "false",
+            seq);
+        return;
+    case CECOpStatus:
+        snprintf(
+            buffer,
+            buffer_size,
+            "{\"command\":\"STATUS\",\"refresh\":%s,\"id\":%u}",
+            request->length && (request->data[0] & CECStatusRefresh) ? "true" : "false",
+            seq);
+        return;
+    case CECOpStats:
+        snprintf(
+            buffer,
+            buffer_size,
+            "{\"command\":\"STATS\",\"reset\":%s,\"id\":%u}",
+            request->length && (request->data[0] & CECStatsReset) ? "true" : "false",
+            seq);
+        return;
+    case CECOpDisplayLogs:
+        snprintf(buffer, buffer_size, "{\"command\":\"DISPLAY_LOGS_ON_HDMI\",\"id\":%u}", seq);
+        return;
+    case CECOpClearLog:
+        snprintf(buffer, buffer_size, "{\"command\":\"CLEAR_FLIPPER_LOG\",\"id\":%u}", seq);
+        return;
+    case CECOpPowerOn:
+        snprintf(cec_command, sizeof(cec_command), "on %x", request->length ? request->data[0] : 0);
+        break;
+    case CECOpPowerOff:
+        snprintf(cec_command, sizeof(cec_command), "standby %x", request->length ? request->data[0] : 0);
+        break;
+    case CECOpVolumeUp:
+        snprintf(cec_command, sizeof(cec_command), "volup");
+        break;
+    case CECOpVolumeDown:
+        snprintf(cec_command, sizeof(cec_command), "voldown");
+        break;
+    case CECOpMute:
+        snprintf(cec_command, sizeof(cec_command), "mute");
+        break;
+    case CECOpTx: {
+        size_t pos = snprintf(cec_command, sizeof(cec_command), "tx ");
+        for(uint8_t i = 0; i < request->length; i++) {
+            pos += snprintf(&cec_command[pos], sizeof(cec_command) - pos, i ? ":%02X" : "%02X", request->data[i]);
+        }
+        break;
+    }
+    default: {
+        // Raw command text inside a JSON string: quotes and backslashes escaped,
+        // control characters, which no cec-client command has, sent as spaces
+        size_t pos = 0;
+        for(uint8_t i = 0; i < request->length && request->data[i]; i++) {
+            char c = request->data[i];
+            if(c == '"' || c == '\\') {
+                cec_command[pos++] = '\\';
+            } else if((uint8_t)c < 0x20) {
+                c = ' ';
+            }
+            cec_command[pos++] = c;
+        }
+        cec_command[pos] = '\0';
+        break;
+    }
+    }
+    
+    snprintf(
+        buffer, buffer_size, "{\"command\":\"CUSTOM\",\"cec_command\":\"%s\",\"id\":%u}", cec_command, seq);
+}
+
+void cec_protocol_json_reset(CECJsonScanner* json) {
+    memset(json, 0, sizeof(*json));
+}
+
+// Append decoded string bytes: result text goes to text, anything else to the short value
+static void cec_protocol_json_emit(CECJsonScanner* json, const char* bytes, size_t count, char* text, size_t* text_length) {
+    for(size_t i = 0; i < count; i++) {
+        if(json->in_result) {
+            // Failure results start with ❌ (UTF-8 E2 9D 8C)
+            static const char failed[] = "\xE2\x9D\x8C";
+            if(json->result_length < 3) {
+                json->result_failed = (json->result_length == 0 || json->result_failed) &&
+                                      bytes[i] == failed[json->result_length];
+                json->result_length++;
+            }
+            text[(*text_length)++] = bytes[i];
+        } else if(json->value_length < sizeof(json->value) - 1) {
+            json->value[json->value_length++] = bytes[i];
+        }
+    }
+}
+
+// Encode a \u escape as UTF-8, joining surrogate pairs
+static void cec_protocol_json_emit_unicode(CECJsonScanner* json, char* text, size_t* text_length) {
+    uint32_t code = json->unicode;
+    if(code >= 0xD800 && code <= 0xDBFF) {
+        json->surrogate = code;
+        return;
+    }
+    if(code >= 0xDC00 && code <= 0xDFFF) {
+        if(!json->surrogate) {
+            return;
+        }
+        code = 0x10000 + (((uint32_t)json->surrogate - 0xD800) << 10) + (code - 0xDC00);
+    }
+    json->surrogate = 0;
+    
+    char bytes[4];
+    size_t count;
+    if(code < 0x80) {
+        bytes[0] = code;
+        count = 1;
+    } else if(code < 0x800) {
+        bytes[0] = 0xC0 | (code >> 6);
+        bytes[1] = 0x80 | (code & 0x3F);
+        count = 2;
+    } else if(code < 0x10000) {
+        bytes[0] = 0xE0 | (code >> 12);
+        bytes[1] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[2] = 0x80 | (code & 0x3F);
+        count = 3;
+    } else {
+        bytes[0] = 0xF0 | (code >> 18);
+        bytes[1] = 0x80 | ((code >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[3] = 0x80 | (code & 0x3F);
+        count = 4;
+    }
+    cec_protocol_json_emit(json, bytes, count, text, text_length);
+}
+
+// A key/value pair is complete
+static void cec_protocol_json_field(CECJsonScanner* json) {
+    json->key[json->key_length] = '\0';
+    json->value[json->value_length] = '\0';
+    
+    if(strcmp(json->key, "status") == 0) {
+        json->has_status = true;
+        json->status_success = strcmp(json->value, "success") == 0;
+    } else if(strcmp(json->key, "partial") == 0) {
+        json->partial = strcmp(json->value, "true") == 0;
+    } else if(strcmp(json->key, "id") == 0) {
+        json->id = (uint8_t)atoi(json->value);
+    } else if(strcmp(json->key, "proto") == 0) {
+        json->proto = (uint8_t)atoi(json->value);
+    }
+    json->key_length = 0;
+    json->value_length = 0;
+    json->in_result = false;
+}
+
+bool cec_protocol_json_feed(CECJsonScanner* json, uint8_t byte, char* text, size_t* text_length) {
+    *text_length = 0;
+    
+    if(byte == '\n' || byte == '\r') {
+        if(json->state == CECJsonStateScalar) {
+            cec_protocol_json_field(json);
+        }
+        json->state = CECJsonStateKeyWait;
+        json->depth = 0;
+        return json->started;
+    }
+    if(byte != ' ' && byte != '\t') {
+        json->started = true;
+    }
+    
+    switch(json->state) {
+    case CECJsonStateKeyWait:
+        if(byte == '"') {
+            json->key_length = 0;
+            json->state = CECJsonStateKey;
+        }
+        break;
+    case CECJsonStateKey:
+        if(byte == '"') {
+            json->state = CECJsonStateColon;
+        } else if(json->key_length < sizeof(json->key) - 1) {
+            json->key[json->key_length++] = byte;
+        }
+        break;
+    case CECJsonStateColon:
+        if(byte == ':') {
+            json->state = CECJsonStateValueWait;
+        }
+        break;
+    case CECJsonStateValueWait:
+        if(byte == '"') {
+            json->key[json->key_length] = '\0';
+            json->in_result = strcmp(json->key, "result") == 0;
+            json->state = CECJsonStateString;
+        } else if(byte == '{' || byte == '[') {
+            // Nested keys such as a display's "status" must not overwrite the line's own
+            json->depth = 1;
+            json->state = CECJsonStateNested;
+        } else if(byte != ' ' && byte != '\t') {
+            json->value[json->value_length++] = byte;
+            json->state = CECJsonStateScalar;
+        }
+        break;
+    case CECJsonStateString:
+        if(byte == '\\') {
+            json->state = CECJsonStateEscape;
+        } else if(byte == '"') {
+            cec_protocol_json_field(json);
+            json->state = CECJsonStateKeyWait;
+        } else {
+            char c = byte;
+            cec_protocol_json_emit(json, &c, 1, text, text_length);
+        }
+        break;
+    case CECJsonStateEscape: {
+        char c = byte;
+        json->state = CECJsonStateString;
+        if(byte == 'u') {
+            json->unicode = 0;
+            json->unicode_digits = 0;
+            json->state = CECJsonStateUnicode;
+            break;
+        } else if(byte == 'n') {
+            c = '\n';
+        } else if(byte == 't' || byte == 'r') {
+            c = ' ';
+        }
+        cec_protocol_json_emit(json, &c, 1, text, text_length);
+        break;
+    }
+    case CECJsonStateUnicode: {
+        uint8_t digit = (byte >= '0' && byte <= '9') ? byte - '0' :
+                        (byte >= 'a' && byte <= 'f') ? byte - 'a' + 10 :
+                        (byte >= 'A' && byte <= 'F') ? byte - 'A' + 10 : 0;
+        json->unicode = (json->unicode << 4) | digit;
+        if(++json->unicode_digits == 4) {
+            cec_protocol_json_emit_unicode(json, text, text_length);
+            json->state = CECJsonStateString;
+        }
+        break;
+    }
+    case CECJsonStateScalar:
+        if(byte == ',' || byte == '}') {
+            cec_protocol_json_field(json);
+            json->state = CECJsonStateKeyWait;
+        } else if(byte != ' ' && json->value_length < sizeof(json->value) - 1) {
+            json->value[json->value_length++] = byte;
+        }
+        break;
+    case CECJsonStateNested:
+        if(byte == '"') {
+            json->state = CECJsonStateNestedString;
+        } else if(byte == '{' || byte == '[') {
+            if(json->depth < UINT8_MAX) {
+                json->depth++;
+            }
+        } else if((byte == '}' || byte == ']') && --json->depth == 0) {
+            json->state = CECJsonStateKeyWait;
+        }
+        break;
+    case CECJsonStateNestedString:
+        if(byte == '\\') {
+            json->state = CECJsonStateNestedEscape;
+        } else if(byte == '"') {
+            json->state = CECJsonStateNested;
+        }
+        break;
+    case CECJsonStateNestedEscape:
+        json->state = CECJsonStateNestedString;
+        break;
+    }
+    return false;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// UART wire protocol, mirrored in rpi/uart_protocol.py. Framing, reply
+// parsing and request building only; nothing here depends on Furi, so the
+// same code also builds on the host (tools/Makefile).
+
+#define CEC_PROTOCOL_VERSION 3
+#define CEC_FRAME_SYNC 0xA5
+#define CEC_FRAME_MAX_PAYLOAD 512
+#define CEC_FRAME_OVERHEAD 7  // sync + length + opcode + seq + crc
+#define CEC_REQUEST_MAX_DATA 64
+
+typedef enum {
+    // Requests (Flipper -> Pi)
+    CECOpPing = 0x01,
+    CECOpScan = 0x02,
+    CECOpStatus = 0x03,       // data: optional flags (CECStatusRefresh)
+    CECOpPowerOn = 0x04,      // data: logical address
+    CECOpPowerOff = 0x05,     // data: logical address
+    CECOpTx = 0x06,           // data: raw CEC frame
+    CECOpVolumeUp = 0x07,
+    CECOpVolumeDown = 0x08,
+    CECOpMute = 0x09,
+    CECOpCustom = 0x0A,       // data: cec-client command text
+    CECOpDisplayLogs = 0x0B,
+    CECOpClearLog = 0x0C,
+    CECOpDiscover = 0x0D,     // data: optional flags (CECDiscoverFull)
+    CECOpSequence = 0x0E,     // data: recipe from the vendor profile
+    CECOpStats = 0x0F,        // data: optional flags (CECStatsReset)
+    CECOpBaud = 0x10,         // data: CECBaudAction + rate (4, LE) [+ verify pattern]
+    CECOpKey = 0x11,          // data: CECKeyAction + UI command code [+ destination]; never answered
+    CECOpWatch = 0x12,        // data: 1 to receive CECOpEvent frames, 0 to stop; never answered
+    // Responses (Pi -> Flipper)
+    CECOpResult = 0x80,       // payload: status byte + result text
+    CECOpResultPart = 0x81,   // same payload, more replies follow for this seq
+    CECOpEvent = 0x82,        // payload: CECEventType + logical address [+ data]; unsolicited, seq 0
+} CECOpcode;
+
+#define CECStatusRefresh 0x01 // Ask the TV rather than the Pi's bus state
+#define CECDiscoverFull 0x01  // Forget known devices and query everything
+#define CECStatsReset 0x01    // Clear the Pi's latency histograms
+
+// UART rate switch: PROPOSE is answered at the old rate, then both ends move
+// and VERIFY carries a pattern the Pi echoes at the new one
+#define CEC_BAUD_DEFAULT 115200
+#define CEC_BAUD_PATTERN_SIZE 32
+
+typedef enum {
+    CECBaudPropose = 0x00,
+    CECBaudVerify = 0x01,
+} CECBaudAction;
+
+// Held remote key: DOWN on press, REPEAT while the button repeats, UP on
+// release. The Pi paces the CEC repeats itself and releases the key when
+// the repeats stop arriving.
+typedef enum {
+    CECKeyDown = 0x00,
+    CECKeyRepeat = 0x01,
+    CECKeyUp = 0x02,
+} CECKeyAction;
+
+#define CEC_KEY_DEST_AUTO 0x0F  // Pi picks: audio system for volume keys, TV otherwise
+
+// Bus changes the Pi pushes after CECOpWatch, starting with what it already knows,
+// and CECEventReady, which it sends once at startup whether watched or not
+typedef enum {
+    CECEventPower = 0x01,      // data: CEC power status
+    CECEventSource = 0x02,     // data: physical address (2, BE); address CEC_EVENT_NO_DEVICE if unknown
+    CECEventDevice = 0x03,     // data: OSD name, may be empty; again when the name changes
+    CECEventGone = 0x04,
+    CECEventReady = 0x05,      // data: 1 if the CEC adapter opened; address CEC_EVENT_NO_DEVICE
+} CECEventType;
+
+#define CEC_EVENT_NO_DEVICE 0x0F
+#define CEC_EVENT_NAME_SIZE 15      // CEC OSD names are at most 14 characters
+#define CEC_EVENT_MAX_PAYLOAD (2 + CEC_EVENT_NAME_SIZE - 1)
+
+typedef struct {
+    uint8_t type;              // CECEventType
+    uint8_t logical;
+    uint8_t power;             // CECEventPower
+    bool adapter_ok;           // CECEventReady
+    uint16_t physical;         // CECEventSource
+    char name[CEC_EVENT_NAME_SIZE];  // CECEventDevice, NUL terminated
+} CECEvent;
+
+typedef enum {
+    CECStatusOk = 0x00,
+    CECStatusError = 0x01,
+} CECStatus;
+
+// One request as handed to the UART layer
+typedef struct {
+    uint8_t opcode;
+    uint8_t length;
+    uint8_t data[CEC_REQUEST_MAX_DATA];
+} CECRequest;
+
+typedef enum {
+    CECFrameStateSync,
+    CECFrameStateLengthLow,
+    CECFrameStateLengthHigh,
+    CECFrameStateBody,
+    CECFrameStateCrcLow,
+    CECFrameStateCrcHigh,
+} CECFrameState;
+
+typedef enum {
+    CECFrameEventNone,
+    CECFrameEventHeader,       // opcode and seq are known, the payload follows
+    CECFrameEventPayload,      // One payload byte, the payload_length-th
+    CECFrameEventComplete,     // CRC matched
+    CECFrameEventCrcError,     // Frame dropped, undo whatever its payload was used for
+} CECFrameEvent;
+
+// Incremental frame decoder fed one byte at a time; the payload is handed
+// out byte by byte and never buffered
+typedef struct {
+    CECFrameState state;
+    uint16_t length;           // opcode + seq + payload bytes announced by the header
+    uint16_t received;
+    uint16_t crc;
+    uint16_t crc_received;
+    uint8_t opcode;
+    uint8_t seq;
+    uint16_t payload_length;   // Payload bytes so far
+    uint32_t crc_errors;
+} CECFrameDecoder;
+
+typedef enum {
+    CECJsonStateKeyWait,
+    CECJsonStateKey,
+    CECJsonStateColon,
+    CECJsonStateValueWait,
+    CECJsonStateString,
+    CECJsonStateEscape,
+    CECJsonStateUnicode,
+    CECJsonStateScalar,
+    CECJsonStateNested,
+    CECJsonStateNestedString,
+    CECJsonStateNestedEscape,
+} CECJsonState;
+
+// Streaming reader for the Pi's JSON reply lines; the "result" string is
+// decoded on the fly instead of buffering the line. Only the fields of the
+// line's own object are read, nested objects and arrays are skipped.
+typedef struct {
+    CECJsonState state;
+    uint8_t depth;             // Objects and arrays open inside a skipped value
+    bool started;              // Something other than whitespace was seen
+    bool in_result;            // The string being read is the result text
+    char key[12];
+    uint8_t key_length;
+    char value[12];            // Scalars and short strings, truncated
+    uint8_t value_length;
+    uint16_t unicode;
+    uint8_t unicode_digits;
+    uint16_t surrogate;        // High half of a \u escaped surrogate pair
+    // Fields of the current line
+    bool has_status;
+    bool status_success;
+    bool partial;
+    uint8_t id;
+    uint8_t proto;
+    uint8_t result_length;     // Result bytes seen, up to the ❌ prefix length
+    bool result_failed;        // Result text starts with ❌
+} CECJsonScanner;
+
+// CRC-16/CCITT-FALSE, one byte at a time
+uint16_t cec_protocol_crc16_update(uint16_t crc, uint8_t byte);
+
+// Encode one frame into out, returns the frame size or 0 if it does not fit
+size_t cec_protocol_frame_encode(
+    uint8_t opcode, uint8_t seq, const uint8_t* payload, size_t payload_length, uint8_t* out, size_t out_size);
+
+void cec_protocol_frame_decoder_reset(CECFrameDecoder* decoder);
+
+// Feed one byte and report what it completed
+CECFrameEvent cec_protocol_frame_decoder_feed(CECFrameDecoder* decoder, uint8_t byte);
+
+// CECOpBaud request for action and rate, with the pattern for CECBaudVerify
+void cec_protocol_baud_request(CECRequest* request, CECBaudAction action, uint32_t rate);
+
+// CECOpKey request for action on a CEC UI command code
+void cec_protocol_key_request(CECRequest* request, CECKeyAction action, uint8_t key, uint8_t destination);
+
+// CECOpWatch request turning events on or off
+void cec_protocol_watch_request(CECRequest* request, bool on);
+
+// Decode an event payload of length bytes (only the first CEC_EVENT_MAX_PAYLOAD
+// are needed); false for unknown types and short payloads
+bool cec_protocol_event_parse(const uint8_t* payload, size_t length, CECEvent* event);
+
+// Whether a verify reply's text is the pattern sent
+bool cec_protocol_baud_pattern_matches(const uint8_t* data, size_t length);
+
+// JSON line equivalent of a request, for Pis without binary framing
+void cec_protocol_build_json(const CECRequest* request, uint8_t seq, char* buffer, size_t buffer_size);
+
+void cec_protocol_json_reset(CECJsonScanner* json);
+
+// Feed one byte of a reply line; result text is decoded into text (up to 4 bytes).
+// Returns true at the end of a non-empty line, the fields stay set until reset.
+bool cec_protocol_json_feed(CECJsonScanner* json, uint8_t byte, char* text, size_t* text_length);
@@ -8,24 +8,172 @@
 #include <gui/modules/text_input.h>
 #include <gui/modules/popup.h>
 #include <notification/notification_messages.h>
+#include <storage/storage.h>
 #include <furi_hal.h>
 #include <string.h>
 #include <stdio.h>
 
+#include "cec_protocol.h"
+
 #define TAG "CECRemote"
 
-// Define the CECCommand structure first
+// Worker thread that owns the serial link
+#define CEC_MAX_INFLIGHT 4    // Requests awaiting a reply at once
+#define CEC_WORKER_STACK_SIZE 2048
+#define CEC_JOB_QUEUE_SIZE 8
+#define CEC_REPLY_TIMEOUT_MS 5000
+#define CEC_PROGRESS_INTERVAL_MS 250
+#define CEC_RX_CHUNK_SIZE 32
+
+// UART rate negotiation after PING, see rpi/baud_rate.py for the Pi's side.
+// The rate that last verified is kept on the SD card and tried first.
+#define CEC_BAUD_PATH APP_DATA_PATH("baud")
+#define CEC_BAUD_REPLY_MS 500      // Wait for a PROPOSE or VERIFY reply
+#define CEC_BAUD_SETTLE_MS 1200    // After a failed switch: the Pi's 1 s verify window, plus margin
+#define CEC_BAUD_ERROR_LIMIT 4     // CRC errors and timeouts that drop the link to 115200 ...
+#define CEC_BAUD_ERROR_WINDOW_MS 2000  // ... within this window
+
+static const uint32_t cec_remote_baud_rates[] = {921600, 460800};
+
+// Connection kept by the worker in the background: PING with backoff until the Pi
+// answers, at once when it announces it is ready. Commands wait for the link meanwhile.
+#define CEC_CONNECT_BACKOFF_MIN_MS 250
+#define CEC_CONNECT_BACKOFF_MAX_MS 4000
+#define CEC_PARKED_TIMEOUT_MS 60000  // A command still waiting for the Pi after this fails
+
+// Result view: reply text streams into a fixed ring, the oldest text drops out first
+#define CEC_RESULT_RING_SIZE 1024  // Power of two
+#define CEC_RESULT_COLUMNS 20
+#define CEC_RESULT_ROWS 5
+#define CEC_RESULT_TOP 23          // Baseline of the first text row
+#define CEC_RESULT_ROW_HEIGHT 10
+
+// Remote screen: arrows stream as held keys (OP_KEY), OK and Back are taps
+#define CEC_REMOTE_NO_KEY 0xFF
+#define CEC_UI_SELECT 0x00
+#define CEC_UI_EXIT 0x0D
+#define CEC_UI_MUTE 0x43
+
+// Dashboard of the bus, fed by the Pi's events
+#define CEC_DASHBOARD_DEVICES 15   // Logical addresses 0-14
+#define CEC_DASHBOARD_ROWS 4
+#define CEC_POWER_UNKNOWN 0xFF
+
+// Round trips measured here, per request opcode, in log2 buckets: <1, <2, <4 ... ms
+#define CEC_LATENCY_OPCODES 16
+#define CEC_LATENCY_BUCKETS 14
+
+// Multi-step recipe the Pi runs as one SEQUENCE request:
+//   attempts | settle (100 ms) | until | until address, then per step
+//   delay after (100 ms) | retries | length | raw CEC frame
+typedef struct {
+    const uint8_t* data;
+    uint8_t length;            // 0: no recipe
+} CECRecipe;
+
+// One menu command of a vendor; data points into flash or the loaded profile record
 typedef struct {
-    const char* name;
-    const char* command;
+    uint8_t opcode;            // CECOp* request opcode, 0 when the vendor lacks it
+    uint8_t cec_length;        // Valid bytes in cec
+    const uint8_t* cec;        // Raw frame for CECOpTx, logical address for power ops
     const char* brightsign_ascii;  // BrightSign ASCII code
+    CECRecipe recipe;          // Used instead of the single frame when the Pi supports it
 } CECCommand;
 
+// Request sent to the Pi whose reply has not arrived yet
+typedef struct {
+    bool active;
+    bool wants_reply;          // False for fire-and-forget and cancelled requests
+    bool foreground;           // Reply goes to the result scene
+    uint8_t seq;
+    uint8_t opcode;
+    uint32_t started_at;       // Request sent
+    uint32_t sent_at;          // Request sent or last sign of life from the Pi
+} CECPending;
+
+typedef struct {
+    uint16_t buckets[CEC_LATENCY_BUCKETS];
+    uint16_t count;
+    uint16_t timeouts;
+    uint32_t max_ms;
+} CECLatency;
+
+// One reply from the Pi; its text has already been streamed into the result ring
+typedef struct {
+    uint8_t seq;
+    bool success;
+    bool partial;              // Streamed record, the final result follows
+} CECReply;
+
+typedef enum {
+    CECJobConnect,             // Open the UART and negotiate the protocol
+    CECJobCommand,
+    CECJobKey,                 // Held key event, sent without waiting for a reply
+    CECJobWatch,               // Ask the Pi for bus events again, it resends what it knows
+} CECJobType;
+
+// Unit of work handed from the GUI to the worker
+typedef struct {
+    CECJobType type;
+    bool foreground;           // Show the result, otherwise only notify
+    bool wants_reply;
+    uint32_t queued_at;
+    CECRequest request;
+} CECJob;
+
+// The worker's link to the Pi
+typedef enum {
+    CECLinkOff,                // UART not available
+    CECLinkConnecting,         // PING with backoff until the Pi answers
+    CECLinkUp,
+} CECLinkState;
+
+typedef enum {
+    CECWorkerFlagStop = (1 << 0),
+    CECWorkerFlagCancel = (1 << 1),  // Abandon the foreground request
+} CECWorkerFlag;
+
+// Custom events posted from the worker to the GUI thread
+typedef enum {
+    CECRemoteEventConnected = 100,
+    CECRemoteEventConnectFailed,
+    CECRemoteEventDisconnected,      // The worker is connecting again
+    CECRemoteEventProgress,
+    CECRemoteEventResult,
+    CECRemoteEventBackgroundSuccess,
+    CECRemoteEventBackgroundError,
+    CECRemoteEventPopupDone,
+    CECRemoteEventRemoteExit,
+} CECRemoteEvent;
+
+typedef enum {
+    CECProgressQueued,
+    CECProgressSent,
+} CECProgress;
+
+// Bounded text of the foreground result; counters run freely, index = counter % size
+typedef struct {
+    char data[CEC_RESULT_RING_SIZE];
+    uint32_t head;             // Bytes ever written
+    uint32_t tail;             // Oldest byte still held
+} CECResultRing;
+
+// Reply text being streamed into the ring, rolled back if it is not ours after all
+typedef struct {
+    bool active;
+    bool started;              // Line break before the reply already written
+    uint32_t mark;             // Ring head when the reply began
+    uint8_t status;            // Binary status byte
+} CECReplyStream;
+
 // Moved these enums to the top as they are used early
 typedef enum {
     CECRemoteViewSubmenu,
     CECRemoteViewTextInput,
     CECRemoteViewPopup,
+    CECRemoteViewResult,
+    CECRemoteViewRemote,
+    CECRemoteViewDashboard,
 } CECRemoteView;
 
 typedef enum {
@@ -34,19 +182,17 @@ typedef enum {
     CECRemoteSceneCommandMenu,
     CECRemoteSceneCustomCommand,
     CECRemoteSceneResult,
+    CECRemoteSceneRemote,
+    CECRemoteSceneDashboard,
     CECRemoteSceneNum,
 } CECRemoteScene;
 
+// Vendor selection; profile vendors use their index position as menu ID
 typedef enum {
-    // Vendor selection
-    CECVendorGeneric,
-    CECVendorOptoma,
-    CECVendorNEC,
-    CECVendorEpson,
-    CECVendorSamsung,
-    CECVendorLG,
-    CECVendorDisplayLogs,
+    CECVendorBuiltin = 0xEF,   // No profile file: built-in generic commands
+    CECVendorDisplayLogs = 0xF0,
     CECVendorClearLogs,
+    CECVendorDiagnostics,
 } CECVendorMenuItem;
 
 typedef enum {
@@ -62,12 +208,80 @@ typedef enum {
     CECCommandMute,
     CECCommandScan,
     CECCommandStatus,
+    CECCommandRemote,
+    CECCommandDashboard,
     CECCommandDisplayLogs,
     CECCommandClearLogs,
     CECCommandCustom,
     CECCommandBack,
 } CECCommandMenuItem;
 
+// Commands a vendor profile can define, in menu order
+#define CEC_PROFILE_SLOTS (CECCommandStatus + 1)
+
+// Vendor profiles: indexed file built by tools/cec_profiles.py, user copy first
+#define CEC_PROFILE_USER_PATH APP_DATA_PATH("vendors.cecp")
+#define CEC_PROFILE_ASSET_PATH APP_ASSETS_PATH("vendors.cecp")
+#define CEC_PROFILE_VERSION 1
+#define CEC_PROFILE_HEADER_SIZE 8
+#define CEC_PROFILE_ENTRY_SIZE 32
+#define CEC_PROFILE_NAME_SIZE 24
+#define CEC_PROFILE_MAX_VENDORS 16
+#define CEC_PROFILE_MAX_RECORD 1024
+#define CEC_BRIGHTSIGN_MAX 32
+
+typedef struct {
+    char name[CEC_PROFILE_NAME_SIZE];
+    uint32_t offset;
+    uint16_t length;
+    uint16_t crc;              // CRC-16/CCITT-FALSE of the record
+} CECProfileEntry;
+
+// Index of every vendor, but the commands of only the selected one
+typedef struct {
+    const char* path;          // File the index came from, NULL when there is none
+    uint8_t vendor_count;
+    CECProfileEntry vendors[CEC_PROFILE_MAX_VENDORS];
+    uint8_t loaded;            // Vendor whose record is in RAM
+    uint8_t* record;
+    CECCommand commands[CEC_PROFILE_SLOTS];
+} CECProfiles;
+
+// Result view state; the text itself is read from the ring under its mutex
+typedef struct {
+    CECResultRing* ring;
+    FuriMutex* mutex;
+    char header[24];
+    bool waiting;
+    bool follow;               // Keep the newest lines in view while text streams in
+    uint16_t top;              // First visible line when not following
+} CECResultViewModel;
+
+// Remote view state, only changed from the GUI thread
+typedef struct {
+    bool volume_page;          // Arrows are volume keys instead of navigation
+    InputKey held;             // Arrow being held, InputKeyMAX for none
+    uint8_t held_code;         // UI command code sent for it, released with the same code
+} CECRemoteViewModel;
+
+// One device on the dashboard, as the Pi's events describe it
+typedef struct {
+    bool present;
+    uint8_t power;             // CEC power status, CEC_POWER_UNKNOWN until reported
+    char name[CEC_EVENT_NAME_SIZE];
+} CECDashboardDevice;
+
+// Dashboard view state, written by the worker as events arrive
+typedef struct {
+    bool watching;             // Events were asked for; JSON-only Pis have none
+    CECDashboardDevice devices[CEC_DASHBOARD_DEVICES];
+    uint8_t source;            // Active source, CEC_EVENT_NO_DEVICE when nobody known is there
+    uint16_t source_path;
+    bool has_source;
+    uint16_t events;           // Events since the dashboard was last cleared
+    uint8_t top;               // First device row in view
+} CECDashboardViewModel;
+
 // App structure
 typedef struct {
     Gui* gui;
@@ -76,13 +290,51 @@ typedef struct {
     Submenu* submenu;
     TextInput* text_input;
     Popup* popup;
+    View* result_view;
+    View* remote_view;
+    View* dashboard_view;
     NotificationApp* notifications;
-    char                text_buffer[256];
+    CECRequest          request;
     char                custom_command[64];
-    char                result_buffer[512];
+    CECResultRing       result;              // Foreground result, guarded by result_mutex
+    CECLatency          latency[CEC_LATENCY_OPCODES];  // Guarded by result_mutex
     char                brightsign_code[32];  // Store BrightSign ASCII code
     bool                is_connected;
     bool                uart_initialized;
+    bool                binary_protocol;     // Negotiated with the Pi at PING
+    uint32_t            baud_rate;           // Current UART rate, worker-only
+    uint8_t             baud_errors;         // Link errors since baud_window_start
+    uint32_t            baud_window_start;
+    bool                last_success;
+    bool                result_waiting;      // Result scene is waiting on the worker
+    uint32_t            power_on_at;         // Pi powered from the 5V pin, or the app started if it already was
+    bool                powered_here;
+    uint32_t            connected_ms;        // After power_on_at, 0 until then; guarded by result_mutex
+    uint32_t            first_command_ms;
+    uint32_t            result_started;
+    volatile uint8_t    result_progress;     // CECProgress of the foreground job
+    // Worker-only state: the serial link and requests in flight
+    FuriThread*         worker_thread;
+    FuriMessageQueue*   job_queue;
+    FuriMutex*          result_mutex;
+    uint8_t             next_seq;
+    CECPending          pending[CEC_MAX_INFLIGHT];
+    CECFrameDecoder     decoder;
+    CECJsonScanner      json;
+    CECReplyStream      stream;
+    CECLinkState        link_state;
+    uint8_t             connect_attempts;    // PINGs since the link went down
+    uint32_t            next_ping_at;
+    uint32_t            last_rx;             // Last byte from the Pi
+    bool                pi_restarted;        // CECEventReady while connected
+    CECJob              parked[CEC_JOB_QUEUE_SIZE];  // Jobs waiting for the link, oldest first
+    uint8_t             parked_count;
+    bool                watching;            // The Pi pushes events, so the link is read even when idle
+    uint8_t             event[CEC_EVENT_MAX_PAYLOAD];  // Start of the event frame being received
+    uint8_t             rx_chunk[CEC_RX_CHUNK_SIZE];
+    size_t              rx_chunk_length;
+    size_t              rx_chunk_position;
+    CECProfiles         profiles;
     uint8_t             selected_vendor;
     uint32_t            last_command_menu_index;  // Remember menu position
     FuriHalSerialHandle* serial_handle;
@@ -94,120 +346,41 @@ typedef struct {
 static CECRemoteApp* cec_remote_app_alloc(void);
 static void          cec_remote_app_free(CECRemoteApp* app);
 
-// Command definitions by vendor
-// Generic commands (simple and direct)
-static const CECCommand generic_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"on 0\"}", "ON_0"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:10:00\"}", "4F821000"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:20:00\"}", "4F822000"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:30:00\"}", "4F823000"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:40:00\"}", "4F824000"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"volup\"}", "VOLUP"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"voldown\"}", "VOLDOWN"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"mute\"}", "MUTE"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
-};
-
-// Samsung-specific commands
-static const CECCommand samsung_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"on 0\"}", "ON_0"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:10:00\"}", "4F821000"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:20:00\"}", "4F822000"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:30:00\"}", "4F823000"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:82:40:00\"}", "4F824000"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:44:41\"}", "4F4441"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:44:42\"}", "4F4442"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 4F:44:43\"}", "4F4443"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
-};
-
-// Optoma-specific commands
-static const CECCommand optoma_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:04\"}", "1004"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:10:00\"}", "10821000"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:20:00\"}", "10822000"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:30:00\"}", "10823000"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:40:00\"}", "10824000"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:41\"}", "104441"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:42\"}", "104442"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:43\"}", "104443"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
-};
-
-// NEC-specific commands
-static const CECCommand nec_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:04\"}", "1004"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:10:00\"}", "10821000"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:20:00\"}", "10822000"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:30:00\"}", "10823000"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:40:00\"}", "10824000"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:41\"}", "104441"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:42\"}", "104442"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:43\"}", "104443"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
+static const char* const cec_command_labels[CEC_PROFILE_SLOTS] = {
+    [CECCommandPowerOn] = "🔌 Power ON",
+    [CECCommandPowerOff] = "⏸️ Power OFF",
+    [CECCommandHDMI1] = "📺 HDMI 1",
+    [CECCommandHDMI2] = "📺 HDMI 2",
+    [CECCommandHDMI3] = "📺 HDMI 3",
+    [CECCommandHDMI4] = "📺 HDMI 4",
+    [CECCommandVolumeUp] = "🔊 Volume UP",
+    [CECCommandVolumeDown] = "🔉 Volume DOWN",
+    [CECCommandMute] = "🔇 Mute",
+    [CECCommandScan] = "🔍 Scan Devices",
+    [CECCommandStatus] = "ℹ️ Status",
 };
 
-// Epson-specific commands
-static const CECCommand epson_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:04\"}", "1004"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:10:00\"}", "10821000"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:20:00\"}", "10822000"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:30:00\"}", "10823000"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:82:40:00\"}", "10824000"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:41\"}", "104441"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:42\"}", "104442"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:43\"}", "104443"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
+// CEC UI command codes of the remote screen's arrows, navigation page then volume page
+static const uint8_t cec_remote_keys[2][InputKeyOk] = {
+    {[InputKeyUp] = 0x01, [InputKeyDown] = 0x02, [InputKeyRight] = 0x04, [InputKeyLeft] = 0x03},
+    {[InputKeyUp] = 0x41, [InputKeyDown] = 0x42, [InputKeyRight] = CEC_REMOTE_NO_KEY, [InputKeyLeft] = CEC_REMOTE_NO_KEY},
 };
 
-// LG-specific commands
-static const CECCommand lg_commands[] = {
-    {"POWER_ON", "{\"command\":\"CUSTOM\",\"cec_command\":\"on 0\"}", "ON_0"},
-    {"POWER_OFF", "{\"command\":\"CUSTOM\",\"cec_command\":\"standby 0\"}", "STANDBY_0"},
-    {"HDMI_1", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:F1\"}", "1044F1"},
-    {"HDMI_2", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:F2\"}", "1044F2"},
-    {"HDMI_3", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:F3\"}", "1044F3"},
-    {"HDMI_4", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:F4\"}", "1044F4"},
-    {"VOLUME_UP", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:41\"}", "104441"},
-    {"VOLUME_DOWN", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:42\"}", "104442"},
-    {"MUTE", "{\"command\":\"CUSTOM\",\"cec_command\":\"tx 10:44:43\"}", "104443"},
-    {"SCAN", "{\"command\":\"SCAN\"}", "SCAN"},
-    {"STATUS", "{\"command\":\"STATUS\"}", "POW_0"},
+// Generic commands, used when no vendor profile file is installed
+static const CECCommand builtin_commands[CEC_PROFILE_SLOTS] = {
+    [CECCommandPowerOn] = {CECOpPowerOn, 1, (const uint8_t[]){0x00}, "ON_0", {NULL, 0}},
+    [CECCommandPowerOff] = {CECOpPowerOff, 1, (const uint8_t[]){0x00}, "STANDBY_0", {NULL, 0}},
+    [CECCommandHDMI1] = {CECOpTx, 4, (const uint8_t[]){0x4F, 0x82, 0x10, 0x00}, "4F821000", {NULL, 0}},
+    [CECCommandHDMI2] = {CECOpTx, 4, (const uint8_t[]){0x4F, 0x82, 0x20, 0x00}, "4F822000", {NULL, 0}},
+    [CECCommandHDMI3] = {CECOpTx, 4, (const uint8_t[]){0x4F, 0x82, 0x30, 0x00}, "4F823000", {NULL, 0}},
+    [CECCommandHDMI4] = {CECOpTx, 4, (const uint8_t[]){0x4F, 0x82, 0x40, 0x00}, "4F824000", {NULL, 0}},
+    [CECCommandVolumeUp] = {CECOpVolumeUp, 0, NULL, "VOLUP", {NULL, 0}},
+    [CECCommandVolumeDown] = {CECOpVolumeDown, 0, NULL, "VOLDOWN", {NULL, 0}},
+    [CECCommandMute] = {CECOpMute, 0, NULL, "MUTE", {NULL, 0}},
+    [CECCommandScan] = {CECOpScan, 0, NULL, "SCAN", {NULL, 0}},
+    [CECCommandStatus] = {CECOpStatus, 0, NULL, "POW_0", {NULL, 0}},
 };
 
-// Get commands for selected vendor
-static const CECCommand* get_vendor_commands(uint8_t vendor) {
-    switch(vendor) {
-        case CECVendorSamsung: return samsung_commands;
-        case CECVendorOptoma: return optoma_commands;
-        case CECVendorNEC: return nec_commands;
-        case CECVendorEpson: return epson_commands;
-        case CECVendorLG: return lg_commands;
-        default: return generic_commands;
-    }
-}
-
-static const char* get_vendor_name(uint8_t vendor) {
-    switch(vendor) {
-        case CECVendorSamsung: return "Samsung";
-        case CECVendorOptoma: return "Optoma";
-        case CECVendorNEC: return "NEC";
-        case CECVendorEpson: return "Epson";
-        case CECVendorLG: return "LG";
-        default: return "Generic";
-    }
-}
-
 // Forward declarations for scene functions
 void cec_remote_scene_start_on_enter(void* context);
 bool cec_remote_scene_start_on_event(void* context, SceneManagerEvent event);
@@ -224,6 +397,12 @@ void cec_remote_scene_custom_on_exit(void* context);
 void cec_remote_scene_result_on_enter(void* context);
 bool cec_remote_scene_result_on_event(void* context, SceneManagerEvent event);
 void cec_remote_scene_result_on_exit(void* context);
+void cec_remote_scene_remote_on_enter(void* context);
+bool cec_remote_scene_remote_on_event(void* context, SceneManagerEvent event);
+void cec_remote_scene_remote_on_exit(void* context);
+void cec_remote_scene_dashboard_on_enter(void* context);
+bool cec_remote_scene_dashboard_on_event(void* context, SceneManagerEvent event);
+void cec_remote_scene_dashboard_on_exit(void* context);
 
 // Timer callback for safe cleanup
 static void cec_remote_cleanup_timer_callback(void* context) {
@@ -249,7 +428,8 @@ static bool cec_remote_uart_init(CECRemoteApp* app) {
         return false;
     }
     
-    furi_hal_serial_init(app->serial_handle, 115200);
+    furi_hal_serial_init(app->serial_handle, CEC_BAUD_DEFAULT);
+    app->baud_rate = CEC_BAUD_DEFAULT;
     app->rx_stream = furi_stream_buffer_alloc(1024, 1);
     furi_hal_serial_async_rx_start(app->serial_handle, cec_remote_uart_rx_callback, app, false);
     
@@ -258,140 +438,1226 @@ static bool cec_remote_uart_init(CECRemoteApp* app) {
     return true;
 }
 
-static void cec_remote_uart_deinit(CECRemoteApp* app) {
-    if(app->uart_initialized) {
-        furi_hal_serial_async_rx_stop(app->serial_handle);
-        
-        if(app->rx_stream) {
-            furi_stream_buffer_free(app->rx_stream);
-            app->rx_stream = NULL;
-        }
-        
-        furi_hal_serial_deinit(app->serial_handle);
-        furi_hal_serial_control_release(app->serial_handle);
-        app->serial_handle = NULL;
-        
-        app->uart_initialized = false;
-        FURI_LOG_I(TAG, "UART deinitialized safely");
-    }
+static void cec_remote_uart_deinit(CECRemoteApp* app) {
+    if(app->uart_initialized) {
+        furi_hal_serial_async_rx_stop(app->serial_handle);
+        
+        if(app->rx_stream) {
+            furi_stream_buffer_free(app->rx_stream);
+            app->rx_stream = NULL;
+        }
+        
+        furi_hal_serial_deinit(app->serial_handle);
+        furi_hal_serial_control_release(app->serial_handle);
+        app->serial_handle = NULL;
+        
+        app->uart_initialized = false;
+        FURI_LOG_I(TAG, "UART deinitialized safely");
+    }
+}
+
+static bool cec_remote_uart_send(CECRemoteApp* app, const char* data) {
+    if(!app->uart_initialized || !app->serial_handle) {
+        return false;
+    }
+    
+    FURI_LOG_I(TAG, "Sending: %s", data);
+    
+    furi_hal_serial_tx(app->serial_handle, (uint8_t*)data, strlen(data));
+    furi_hal_serial_tx(app->serial_handle, (uint8_t*)"\n", 1);
+    furi_hal_serial_tx_wait_complete(app->serial_handle);
+    
+    return true;
+}
+
+// Make sure rx_chunk holds unread bytes, waiting up to timeout_ms for more
+static bool cec_remote_uart_fill(CECRemoteApp* app, uint32_t timeout_ms) {
+    if(!app->uart_initialized || !app->serial_handle || !app->rx_stream) {
+        return false;
+    }
+    if(app->rx_chunk_position < app->rx_chunk_length) {
+        return true;
+    }
+    
+    app->rx_chunk_position = 0;
+    app->rx_chunk_length =
+        furi_stream_buffer_receive(app->rx_stream, app->rx_chunk, sizeof(app->rx_chunk), timeout_ms);
+    if(app->rx_chunk_length == 0) {
+        return false;
+    }
+    app->last_rx = furi_get_tick();
+    return true;
+}
+
+static bool cec_remote_uart_send_frame(CECRemoteApp* app, const CECRequest* request, uint8_t seq) {
+    if(!app->uart_initialized || !app->serial_handle) {
+        return false;
+    }
+    
+    uint8_t frame[CEC_REQUEST_MAX_DATA + CEC_FRAME_OVERHEAD];
+    size_t size =
+        cec_protocol_frame_encode(request->opcode, seq, request->data, request->length, frame, sizeof(frame));
+    if(size == 0) {
+        return false;
+    }
+    
+    FURI_LOG_I(TAG, "Sending frame: op=0x%02X seq=%u len=%u", request->opcode, seq, request->length);
+    
+    furi_hal_serial_tx(app->serial_handle, frame, size);
+    furi_hal_serial_tx_wait_complete(app->serial_handle);
+    
+    return true;
+}
+
+static void cec_remote_ring_reset(CECResultRing* ring) {
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+static char cec_remote_ring_at(const CECResultRing* ring, uint32_t position) {
+    return ring->data[position % CEC_RESULT_RING_SIZE];
+}
+
+// Append one byte, dropping the oldest when full
+static void cec_remote_ring_put(CECResultRing* ring, char c) {
+    ring->data[ring->head % CEC_RESULT_RING_SIZE] = c;
+    ring->head++;
+    if(ring->head - ring->tail > CEC_RESULT_RING_SIZE) {
+        ring->tail = ring->head - CEC_RESULT_RING_SIZE;
+    }
+}
+
+// Start taking reply text into the ring; the caller holds result_mutex for all stream calls
+static void cec_remote_stream_begin(CECRemoteApp* app) {
+    app->stream.active = true;
+    app->stream.started = false;
+    app->stream.mark = app->result.head;
+}
+
+static void cec_remote_stream_put(CECRemoteApp* app, const char* text, size_t length) {
+    if(!app->stream.active || length == 0) {
+        return;
+    }
+    CECResultRing* ring = &app->result;
+    if(!app->stream.started) {
+        // Every reply starts on a line of its own
+        app->stream.started = true;
+        if(ring->head != ring->tail && cec_remote_ring_at(ring, ring->head - 1) != '\n') {
+            cec_remote_ring_put(ring, '\n');
+        }
+    }
+    for(size_t i = 0; i < length; i++) {
+        cec_remote_ring_put(ring, text[i]);
+    }
+}
+
+// Finish the streamed reply, keep=false takes its text back out of the ring
+static void cec_remote_stream_end(CECRemoteApp* app, bool keep) {
+    if(app->stream.active && !keep) {
+        CECResultRing* ring = &app->result;
+        ring->head = app->stream.mark;
+        if(ring->tail > ring->head) {
+            ring->tail = ring->head;
+        }
+    }
+    app->stream.active = false;
+}
+
+// Add text that did not come from the Pi, such as a local error, as its own line
+static void cec_remote_result_append(CECRemoteApp* app, const char* text) {
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    // A reply cut off half way is abandoned, the rest of it is ignored
+    cec_remote_stream_end(app, false);
+    cec_remote_stream_begin(app);
+    cec_remote_stream_put(app, text, strlen(text));
+    cec_remote_stream_end(app, true);
+    furi_mutex_release(app->result_mutex);
+}
+
+static CECPending* cec_remote_link_find(CECRemoteApp* app, uint8_t seq) {
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(app->pending[i].active && app->pending[i].seq == seq) {
+            return &app->pending[i];
+        }
+    }
+    return NULL;
+}
+
+// Requests whose reply someone is still waiting for
+static size_t cec_remote_link_inflight(CECRemoteApp* app) {
+    size_t count = 0;
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(app->pending[i].active && app->pending[i].wants_reply) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Send a request tagged with a fresh sequence ID, returns its slot or NULL on failure
+static CECPending* cec_remote_link_submit(CECRemoteApp* app, const CECRequest* request, bool wants_reply) {
+    CECPending* slot = NULL;
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(!app->pending[i].active) {
+            slot = &app->pending[i];
+            break;
+        }
+        // Reuse the oldest slot whose owner is not waiting on it
+        if(!app->pending[i].wants_reply && (!slot || app->pending[i].sent_at < slot->sent_at)) {
+            slot = &app->pending[i];
+        }
+    }
+    if(!slot) {
+        FURI_LOG_W(TAG, "Too many requests in flight");
+        return NULL;
+    }
+    
+    // Sequence 0 is reserved for messages that do not answer a request
+    uint8_t seq = app->next_seq;
+    app->next_seq = (app->next_seq == 255) ? 1 : app->next_seq + 1;
+    
+    bool sent;
+    if(app->binary_protocol) {
+        sent = cec_remote_uart_send_frame(app, request, seq);
+    } else {
+        char command[CEC_REQUEST_MAX_DATA * 3 + 80];
+        cec_protocol_build_json(request, seq, command, sizeof(command));
+        sent = cec_remote_uart_send(app, command);
+    }
+    if(!sent) {
+        return NULL;
+    }
+    
+    slot->active = true;
+    slot->wants_reply = wants_reply;
+    slot->foreground = false;
+    slot->seq = seq;
+    slot->opcode = request->opcode;
+    slot->started_at = furi_get_tick();
+    slot->sent_at = slot->started_at;
+    return slot;
+}
+
+// Oldest request still waiting, used for replies from Pis that echo no ID
+static uint8_t cec_remote_link_oldest_seq(CECRemoteApp* app) {
+    CECPending* oldest = NULL;
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        CECPending* slot = &app->pending[i];
+        if(slot->active && slot->wants_reply && (!oldest || slot->sent_at < oldest->sent_at)) {
+            oldest = slot;
+        }
+    }
+    return oldest ? oldest->seq : 0;
+}
+
+// Whether text arriving for seq belongs on the result screen
+static bool cec_remote_link_is_foreground(CECRemoteApp* app, uint8_t seq) {
+    CECPending* slot = cec_remote_link_find(app, seq);
+    return slot && slot->wants_reply && slot->foreground;
+}
+
+static bool cec_remote_link_has_foreground(CECRemoteApp* app) {
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(app->pending[i].active && app->pending[i].wants_reply && app->pending[i].foreground) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// One event from the Pi into the dashboard model; the view redraws if it is shown
+static void cec_remote_dashboard_apply(CECRemoteApp* app, size_t length) {
+    CECEvent event;
+    if(!cec_protocol_event_parse(app->event, length, &event)) {
+        FURI_LOG_W(TAG, "Ignoring event type 0x%02X", app->event[0]);
+        return;
+    }
+    FURI_LOG_I(TAG, "Bus event %u for %X", event.type, event.logical);
+    
+    with_view_model(
+        app->dashboard_view,
+        CECDashboardViewModel * model,
+        {
+            CECDashboardDevice* device =
+                event.logical < CEC_DASHBOARD_DEVICES ? &model->devices[event.logical] : NULL;
+            model->events++;
+            if(event.type == CECEventSource) {
+                model->has_source = true;
+                model->source = event.logical;
+                model->source_path = event.physical;
+            } else if(device && event.type == CECEventGone) {
+                device->present = false;
+                if(model->source == event.logical) {
+                    model->source = CEC_EVENT_NO_DEVICE;
+                }
+            } else if(device) {
+                if(!device->present) {
+                    device->present = true;
+                    device->power = CEC_POWER_UNKNOWN;
+                    device->name[0] = '\0';
+                }
+                if(event.type == CECEventPower) {
+                    device->power = event.power;
+                } else if(event.name[0]) {
+                    memcpy(device->name, event.name, sizeof(device->name));
+                }
+            }
+        },
+        true);
+}
+
+// Feed one binary byte, returns true when it completed a reply
+static bool cec_remote_link_feed_frame(CECRemoteApp* app, uint8_t byte, CECReply* reply) {
+    CECFrameDecoder* decoder = &app->decoder;
+    
+    switch(cec_protocol_frame_decoder_feed(decoder, byte)) {
+    case CECFrameEventHeader:
+        // The seq comes before the text, so only foreground text is streamed
+        if((decoder->opcode == CECOpResult || decoder->opcode == CECOpResultPart) &&
+           cec_remote_link_is_foreground(app, decoder->seq)) {
+            cec_remote_stream_begin(app);
+        }
+        break;
+    case CECFrameEventPayload:
+        if(decoder->opcode == CECOpEvent) {
+            if(decoder->payload_length <= sizeof(app->event)) {
+                app->event[decoder->payload_length - 1] = byte;
+            }
+            break;
+        }
+        // Status byte first, the rest is the result text
+        if(decoder->payload_length == 1) {
+            app->stream.status = byte;
+        } else {
+            char c = byte;
+            cec_remote_stream_put(app, &c, 1);
+        }
+        break;
+    case CECFrameEventCrcError:
+        FURI_LOG_W(TAG, "Frame CRC mismatch (%lu total)", decoder->crc_errors);
+        app->baud_errors++;
+        cec_remote_stream_end(app, false);
+        break;
+    case CECFrameEventComplete:
+        if(decoder->opcode == CECOpEvent && decoder->payload_length >= 1 && app->event[0] == CECEventReady) {
+            // The daemon started again and knows nothing of this session
+            FURI_LOG_W(TAG, "Pi restarted");
+            app->pi_restarted = true;
+            break;
+        }
+        if(decoder->opcode == CECOpEvent) {
+            cec_remote_dashboard_apply(app, MIN(decoder->payload_length, sizeof(app->event)));
+            break;
+        }
+        if((decoder->opcode != CECOpResult && decoder->opcode != CECOpResultPart) || decoder->payload_length < 1) {
+            FURI_LOG_W(TAG, "Ignoring frame op=0x%02X", decoder->opcode);
+            cec_remote_stream_end(app, false);
+            break;
+        }
+        FURI_LOG_I(
+            TAG, "Received frame: op=0x%02X seq=%u len=%u", decoder->opcode, decoder->seq, decoder->payload_length);
+        reply->seq = decoder->seq;
+        reply->success = app->stream.status == CECStatusOk;
+        reply->partial = decoder->opcode == CECOpResultPart;
+        cec_remote_stream_end(app, true);
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+// Feed one JSON byte, returns true when it completed a reply
+static bool cec_remote_link_feed_json(CECRemoteApp* app, uint8_t byte, CECReply* reply) {
+    CECJsonScanner* json = &app->json;
+    // The id may follow the result, so text is streamed while any foreground
+    // request waits and taken back if the line answers another one
+    if(!json->started && !app->stream.active && cec_remote_link_has_foreground(app)) {
+        cec_remote_stream_begin(app);
+    }
+    
+    char text[4];
+    size_t text_length;
+    if(!cec_protocol_json_feed(json, byte, text, &text_length)) {
+        cec_remote_stream_put(app, text, text_length);
+        return false;
+    }
+    
+    bool complete = json->has_status;
+    if(complete) {
+        // Pis that predate IDs echo nothing; their replies come back in order
+        reply->seq = json->id ? json->id : cec_remote_link_oldest_seq(app);
+        reply->partial = json->partial;
+        reply->success = json->partial || (json->status_success && !json->result_failed);
+        FURI_LOG_I(TAG, "Received line: id=%u partial=%u success=%u", reply->seq, reply->partial, reply->success);
+    }
+    cec_remote_stream_end(app, complete && cec_remote_link_is_foreground(app, reply->seq));
+    cec_protocol_json_reset(json);
+    return complete;
+}
+
+// Receive at most one reply; foreground text goes straight into the result ring
+static bool cec_remote_link_poll(CECRemoteApp* app, uint32_t timeout_ms, CECReply* reply) {
+    uint32_t start_time = furi_get_tick();
+    
+    while(furi_get_tick() - start_time < timeout_ms) {
+        if(!cec_remote_uart_fill(app, 10)) {
+            continue;
+        }
+        
+        // One lock per chunk; the result view reads the ring under the same mutex
+        bool complete = false;
+        furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+        while(!complete && app->rx_chunk_position < app->rx_chunk_length) {
+            uint8_t byte = app->rx_chunk[app->rx_chunk_position++];
+            complete = app->binary_protocol ? cec_remote_link_feed_frame(app, byte, reply) :
+                                              cec_remote_link_feed_json(app, byte, reply);
+        }
+        furi_mutex_release(app->result_mutex);
+        if(complete) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+// Count a round trip from send to final reply, or a request that never got one
+static void cec_remote_latency_record(CECRemoteApp* app, const CECPending* slot, bool timed_out) {
+    if(slot->opcode >= CEC_LATENCY_OPCODES) {
+        return;
+    }
+    uint32_t elapsed = furi_get_tick() - slot->started_at;
+
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    CECLatency* latency = &app->latency[slot->opcode];
+    if(timed_out) {
+        latency->timeouts++;
+    } else {
+        uint8_t bucket = elapsed ? 32 - __builtin_clz(elapsed) : 0;
+        latency->buckets[MIN(bucket, CEC_LATENCY_BUCKETS - 1)]++;
+        latency->count++;
+        latency->max_ms = MAX(latency->max_ms, elapsed);
+    }
+    furi_mutex_release(app->result_mutex);
+}
+
+// A streamed record arrived, its text is already in the result ring
+static void cec_remote_worker_partial(CECRemoteApp* app, CECPending* slot) {
+    // Every record proves the Pi is still working on it
+    slot->sent_at = furi_get_tick();
+    if(slot->foreground) {
+        view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventProgress);
+    }
+}
+
+// Hand a finished request back to the GUI; text is added for results that did not come from the Pi
+static void cec_remote_worker_complete(CECRemoteApp* app, CECPending* slot, bool success, const char* text) {
+    slot->active = false;
+    if(success && slot->opcode != CECOpPing && slot->opcode != CECOpStats) {
+        furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+        if(!app->first_command_ms) {
+            app->first_command_ms = furi_get_tick() - app->power_on_at;
+            FURI_LOG_I(TAG, "First command done %lu ms after power on", app->first_command_ms);
+        }
+        furi_mutex_release(app->result_mutex);
+    }
+    
+    if(slot->foreground) {
+        if(text) {
+            cec_remote_result_append(app, text);
+        }
+        furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+        bool empty = app->result.head == app->result.tail;
+        app->last_success = success;
+        furi_mutex_release(app->result_mutex);
+        if(empty) {
+            cec_remote_result_append(app, success ? "✅ Command sent" : "❌ Command failed");
+        }
+        view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventResult);
+    } else {
+        view_dispatcher_send_custom_event(
+            app->view_dispatcher, success ? CECRemoteEventBackgroundSuccess : CECRemoteEventBackgroundError);
+    }
+}
+
+// Drop whatever was received at the previous rate
+static void cec_remote_uart_discard(CECRemoteApp* app) {
+    furi_stream_buffer_reset(app->rx_stream);
+    app->rx_chunk_length = 0;
+    app->rx_chunk_position = 0;
+    cec_protocol_frame_decoder_reset(&app->decoder);
+}
+
+static void cec_remote_uart_set_rate(CECRemoteApp* app, uint32_t rate) {
+    furi_hal_serial_set_br(app->serial_handle, rate);
+    app->baud_rate = rate;
+    app->baud_errors = 0;
+    app->baud_window_start = furi_get_tick();
+}
+
+// One request and its final reply outside the pipeline, only while nothing is
+// in flight; the reply text after the status byte is copied into text
+static bool cec_remote_link_exchange(
+    CECRemoteApp* app,
+    const CECRequest* request,
+    uint32_t timeout_ms,
+    uint8_t* status,
+    uint8_t* text,
+    size_t* text_length) {
+    uint8_t seq = app->next_seq;
+    app->next_seq = (app->next_seq == 255) ? 1 : app->next_seq + 1;
+    if(!cec_remote_uart_send_frame(app, request, seq)) {
+        return false;
+    }
+    
+    CECFrameDecoder* decoder = &app->decoder;
+    size_t capacity = *text_length;
+    *text_length = 0;
+    uint32_t start_time = furi_get_tick();
+    while(furi_get_tick() - start_time < timeout_ms) {
+        if(!cec_remote_uart_fill(app, 10)) {
+            continue;
+        }
+        while(app->rx_chunk_position < app->rx_chunk_length) {
+            uint8_t byte = app->rx_chunk[app->rx_chunk_position++];
+            switch(cec_protocol_frame_decoder_feed(decoder, byte)) {
+            case CECFrameEventHeader:
+                *text_length = 0;
+                break;
+            case CECFrameEventPayload:
+                if(decoder->payload_length == 1) {
+                    *status = byte;
+                } else if(*text_length < capacity) {
+                    text[(*text_length)++] = byte;
+                }
+                break;
+            case CECFrameEventComplete:
+                if(decoder->opcode == CECOpResult && decoder->seq == seq && decoder->payload_length >= 1) {
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+static uint32_t cec_remote_read_le(const uint8_t* data, size_t size) {
+    uint32_t value = 0;
+    for(size_t i = size; i > 0; i--) {
+        value = (value << 8) | data[i - 1];
+    }
+    return value;
+}
+
+static uint32_t cec_remote_baud_load(void) {
+    uint32_t rate = 0;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, CEC_BAUD_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        uint8_t data[4];
+        if(storage_file_read(file, data, sizeof(data)) == sizeof(data)) {
+            rate = cec_remote_read_le(data, sizeof(data));
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return rate;
+}
+
+static void cec_remote_baud_save(uint32_t rate) {
+    uint8_t data[4] = {rate, rate >> 8, rate >> 16, rate >> 24};
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, CEC_BAUD_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS) ||
+       storage_file_write(file, data, sizeof(data)) != sizeof(data)) {
+        FURI_LOG_W(TAG, "Could not store baud rate");
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Propose rate, move there and verify. On failure both ends go back: the Pi
+// once its verify window runs out, so wait for that before checking with PING.
+// Returns whether the link now runs at rate; alive tells if it still works at all.
+static bool cec_remote_baud_try(CECRemoteApp* app, uint32_t rate, bool* alive) {
+    uint32_t previous = app->baud_rate;
+    CECRequest request;
+    uint8_t status = CECStatusError;
+    uint8_t text[CEC_BAUD_PATTERN_SIZE];
+    size_t text_length = sizeof(text);
+    
+    cec_protocol_baud_request(&request, CECBaudPropose, rate);
+    *alive = cec_remote_link_exchange(app, &request, CEC_BAUD_REPLY_MS, &status, text, &text_length);
+    if(!*alive || status != CECStatusOk) {
+        return false;
+    }
+    
+    uint32_t switched = furi_get_tick();
+    cec_remote_uart_set_rate(app, rate);
+    furi_delay_ms(20);  // The Pi switches once its reply has drained
+    cec_remote_uart_discard(app);
+    
+    cec_protocol_baud_request(&request, CECBaudVerify, rate);
+    text_length = sizeof(text);
+    if(cec_remote_link_exchange(app, &request, CEC_BAUD_REPLY_MS, &status, text, &text_length) &&
+       status == CECStatusOk && cec_protocol_baud_pattern_matches(text, text_length)) {
+        FURI_LOG_I(TAG, "UART at %lu baud", rate);
+        return true;
+    }
+    
+    FURI_LOG_W(TAG, "UART verify at %lu baud failed", rate);
+    cec_remote_uart_set_rate(app, previous);
+    uint32_t waited = furi_get_tick() - switched;
+    if(waited < CEC_BAUD_SETTLE_MS) {
+        furi_delay_ms(CEC_BAUD_SETTLE_MS - waited);
+    }
+    cec_remote_uart_discard(app);
+    
+    CECRequest ping = {.opcode = CECOpPing, .length = 0};
+    text_length = sizeof(text);
+    *alive = cec_remote_link_exchange(app, &ping, CEC_BAUD_REPLY_MS, &status, text, &text_length);
+    return false;
+}
+
+// Remembered rate first, then the faster ones below it. Anything else, 115200
+// from an older version included, starts over from the fastest.
+static void cec_remote_baud_negotiate(CECRemoteApp* app) {
+    uint32_t remembered = cec_remote_baud_load();
+    bool known = false;
+    for(size_t i = 0; i < COUNT_OF(cec_remote_baud_rates); i++) {
+        known = known || cec_remote_baud_rates[i] == remembered;
+    }
+    if(!known) {
+        remembered = 0;
+    }
+    
+    bool alive = true;
+    for(size_t i = 0; i < COUNT_OF(cec_remote_baud_rates) && alive; i++) {
+        uint32_t rate = cec_remote_baud_rates[i];
+        if(remembered && rate > remembered) {
+            continue;
+        }
+        if(cec_remote_baud_try(app, rate, &alive)) {
+            if(rate != remembered) {
+                cec_remote_baud_save(rate);
+            }
+            return;
+        }
+    }
+    FURI_LOG_I(TAG, "UART stays at %lu baud", app->baud_rate);
+}
+
+// Too many CRC errors or lost replies at a faster rate: the two ends no longer
+// agree. Drop to 115200 and remember the next slower fast rate for the next
+// connect, never 115200 itself: that one still tries, and verify falls back.
+// The frame sent at 115200 reads as noise on a Pi still at the fast rate,
+// which makes it fall back too; late replies are dropped as stale.
+static void cec_remote_baud_check(CECRemoteApp* app) {
+    if(app->baud_rate == CEC_BAUD_DEFAULT) {
+        return;
+    }
+    if(furi_get_tick() - app->baud_window_start >= CEC_BAUD_ERROR_WINDOW_MS) {
+        app->baud_errors = 0;
+        app->baud_window_start = furi_get_tick();
+    }
+    if(app->baud_errors < CEC_BAUD_ERROR_LIMIT) {
+        return;
+    }
+    
+    uint32_t slower = cec_remote_baud_rates[COUNT_OF(cec_remote_baud_rates) - 1];
+    for(size_t i = 0; i < COUNT_OF(cec_remote_baud_rates); i++) {
+        if(cec_remote_baud_rates[i] < app->baud_rate) {
+            slower = cec_remote_baud_rates[i];
+            break;
+        }
+    }
+    FURI_LOG_W(TAG, "UART errors at %lu baud, back to %d", app->baud_rate, CEC_BAUD_DEFAULT);
+    cec_remote_baud_save(slower);
+    cec_remote_uart_set_rate(app, CEC_BAUD_DEFAULT);
+    cec_remote_uart_discard(app);
+    CECRequest ping = {.opcode = CECOpPing, .length = 0};
+    cec_remote_uart_send_frame(app, &ping, 0);
+}
+
+// Forget the dashboard and ask the Pi for events; its reply is what it knows, then changes
+static void cec_remote_worker_watch(CECRemoteApp* app) {
+    with_view_model(
+        app->dashboard_view,
+        CECDashboardViewModel * model,
+        {
+            memset(model->devices, 0, sizeof(model->devices));
+            model->has_source = false;
+            model->events = 0;
+            model->watching = app->binary_protocol;
+        },
+        true);
+    if(!app->binary_protocol) {
+        return;
+    }
+    
+    CECRequest watch;
+    cec_protocol_watch_request(&watch, true);
+    app->watching = cec_remote_uart_send_frame(app, &watch, 0);
+}
+
+// A job that will not run, answered as failed if anybody waits for it
+static void cec_remote_worker_fail_job(CECRemoteApp* app, const CECJob* job, const char* text) {
+    if(job->wants_reply) {
+        CECPending failed = {.foreground = job->foreground};
+        cec_remote_worker_complete(app, &failed, false, text);
+    }
+}
+
+// Start over at 115200 with JSON PINGs. A Pi still at a faster rate falls back on
+// their noise, and stops pushing events at the first one it reads.
+static void cec_remote_link_restart(CECRemoteApp* app) {
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(app->pending[i].active && app->pending[i].wants_reply) {
+            cec_remote_worker_complete(app, &app->pending[i], false, "❌ Lost connection to Pi");
+        }
+        app->pending[i].active = false;
+    }
+    if(app->baud_rate != CEC_BAUD_DEFAULT) {
+        cec_remote_uart_set_rate(app, CEC_BAUD_DEFAULT);
+    }
+    cec_remote_uart_discard(app);
+    cec_protocol_json_reset(&app->json);
+    app->binary_protocol = false;
+    app->watching = false;
+    app->pi_restarted = false;
+    app->link_state = CECLinkConnecting;
+    app->connect_attempts = 0;
+    app->next_ping_at = furi_get_tick();
+    if(app->is_connected) {
+        app->is_connected = false;
+        view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventDisconnected);
+    }
+}
+
+static void cec_remote_worker_connect(CECRemoteApp* app) {
+    if(!app->uart_initialized && !cec_remote_uart_init(app)) {
+        app->link_state = CECLinkOff;
+        view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventConnectFailed);
+        return;
+    }
+    cec_remote_link_restart(app);
+}
+
+// The Pi answered a PING: settle the protocol and rate, ask for events
+static void cec_remote_link_up(CECRemoteApp* app) {
+    app->binary_protocol = app->json.proto == CEC_PROTOCOL_VERSION;
+    cec_protocol_json_reset(&app->json);
+    FURI_LOG_I(
+        TAG, "Using %s protocol after %u PINGs", app->binary_protocol ? "binary" : "JSON", app->connect_attempts);
+    if(app->binary_protocol) {
+        cec_remote_baud_negotiate(app);
+    }
+    cec_remote_worker_watch(app);
+    app->link_state = CECLinkUp;
+    app->last_rx = furi_get_tick();
+    
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    if(!app->connected_ms) {
+        app->connected_ms = furi_get_tick() - app->power_on_at;
+        FURI_LOG_I(TAG, "Pi connected %lu ms after power on", app->connected_ms);
+    }
+    furi_mutex_release(app->result_mutex);
+    app->is_connected = true;
+    view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventConnected);
+}
+
+// One step of the handshake: a PING once its backoff is over, then up to 20 ms of
+// reading. The reply is a JSON line; the Pi's ready announcement is a frame.
+static void cec_remote_link_connect_step(CECRemoteApp* app) {
+    uint32_t now = furi_get_tick();
+    if((int32_t)(now - app->next_ping_at) >= 0) {
+        CECRequest ping = {.opcode = CECOpPing, .length = 0};
+        char command[80];
+        cec_protocol_build_json(&ping, 0, command, sizeof(command));
+        cec_protocol_json_reset(&app->json);
+        cec_remote_uart_send(app, command);
+        uint8_t shift = MIN(app->connect_attempts, 4);
+        app->next_ping_at = now + MIN(CEC_CONNECT_BACKOFF_MIN_MS << shift, CEC_CONNECT_BACKOFF_MAX_MS);
+        if(app->connect_attempts < UINT8_MAX) {
+            app->connect_attempts++;
+        }
+    }
+    if(!cec_remote_uart_fill(app, 20)) {
+        return;
+    }
+    
+    while(app->rx_chunk_position < app->rx_chunk_length) {
+        uint8_t byte = app->rx_chunk[app->rx_chunk_position++];
+        CECFrameDecoder* decoder = &app->decoder;
+        CECFrameEvent frame = cec_protocol_frame_decoder_feed(decoder, byte);
+        if(frame == CECFrameEventPayload && decoder->opcode == CECOpEvent &&
+           decoder->payload_length <= sizeof(app->event)) {
+            app->event[decoder->payload_length - 1] = byte;
+        } else if(
+            frame == CECFrameEventComplete && decoder->opcode == CECOpEvent && decoder->payload_length >= 1 &&
+            app->event[0] == CECEventReady) {
+            FURI_LOG_I(TAG, "Pi is ready, PING now");
+            app->next_ping_at = furi_get_tick();
+            app->connect_attempts = 0;
+        }
+        
+        char text[4];
+        size_t text_length;
+        if(cec_protocol_json_feed(&app->json, byte, text, &text_length)) {
+            if(app->json.has_status && app->json.status_success) {
+                cec_remote_link_up(app);
+                return;
+            }
+            cec_protocol_json_reset(&app->json);
+        }
+    }
+}
+
+// Jobs queued while the link is down: commands wait for it, keys and watch
+// requests are dropped (the link asks for events itself once it is up)
+static void cec_remote_worker_park(CECRemoteApp* app, uint32_t timeout_ms) {
+    CECJob job;
+    while(furi_message_queue_get(app->job_queue, &job, timeout_ms) == FuriStatusOk) {
+        timeout_ms = 0;
+        if(job.type == CECJobConnect) {
+            cec_remote_worker_connect(app);
+        } else if(job.type != CECJobCommand) {
+            continue;
+        } else if(app->link_state == CECLinkOff || app->parked_count == COUNT_OF(app->parked)) {
+            cec_remote_worker_fail_job(app, &job, "❌ Pi not connected");
+        } else {
+            app->parked[app->parked_count++] = job;
+        }
+    }
+    
+    // Nobody should find a power command run a minute after they gave up on it
+    uint32_t now = furi_get_tick();
+    while(app->parked_count && now - app->parked[0].queued_at >= CEC_PARKED_TIMEOUT_MS) {
+        cec_remote_worker_fail_job(app, &app->parked[0], "❌ Pi not connected");
+        app->parked_count--;
+        memmove(&app->parked[0], &app->parked[1], app->parked_count * sizeof(CECJob));
+    }
+}
+
+// Key events go out with seq 0 and take no reply slot; a Pi without binary
+// framing gets the old one-shot command on key down instead
+static void cec_remote_worker_send_key(CECRemoteApp* app, const CECRequest* key) {
+    if(app->binary_protocol) {
+        cec_remote_uart_send_frame(app, key, 0);
+        return;
+    }
+    if(key->data[0] != CECKeyDown) {
+        return;
+    }
+    
+    CECRequest request = {.opcode = CECOpTx, .length = 3, .data = {0x10, 0x44, key->data[1]}};
+    if(key->data[1] == 0x41) {
+        request = (CECRequest){.opcode = CECOpVolumeUp, .length = 0};
+    } else if(key->data[1] == 0x42) {
+        request = (CECRequest){.opcode = CECOpVolumeDown, .length = 0};
+    } else if(key->data[1] == CEC_UI_MUTE) {
+        request = (CECRequest){.opcode = CECOpMute, .length = 0};
+    }
+    cec_remote_link_submit(app, &request, false);
+}
+
+static void cec_remote_worker_start_job(CECRemoteApp* app, const CECJob* job) {
+    if(job->type == CECJobConnect) {
+        cec_remote_worker_connect(app);
+        return;
+    }
+    if(job->type == CECJobKey) {
+        cec_remote_worker_send_key(app, &job->request);
+        return;
+    }
+    if(job->type == CECJobWatch) {
+        cec_remote_worker_watch(app);
+        return;
+    }
+    
+    CECRequest request = job->request;
+    // Pis speaking this protocol version stream discovery results as they arrive
+    if(request.opcode == CECOpScan && app->binary_protocol) {
+        request.opcode = CECOpDiscover;
+        request.length = 0;
+    }
+    
+    CECPending* slot = cec_remote_link_submit(app, &request, job->wants_reply);
+    if(!slot) {
+        cec_remote_worker_fail_job(app, job, "❌ UART send failed");
+        return;
+    }
+    
+    slot->foreground = job->foreground;
+    if(job->foreground) {
+        // Drop anything a cancelled request streamed in after the GUI cleared the ring
+        furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+        cec_remote_stream_end(app, false);
+        cec_remote_ring_reset(&app->result);
+        furi_mutex_release(app->result_mutex);
+        app->result_progress = CECProgressSent;
+        view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventProgress);
+    }
+}
+
+// The GUI gave up on the foreground request: its reply is dropped when it arrives,
+// and if it is still waiting for the link it is not sent at all
+static void cec_remote_worker_cancel(CECRemoteApp* app) {
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        if(app->pending[i].active && app->pending[i].foreground) {
+            FURI_LOG_I(TAG, "Cancelled seq=%u", app->pending[i].seq);
+            app->pending[i].wants_reply = false;
+            app->pending[i].foreground = false;
+        }
+    }
+    uint8_t kept = 0;
+    for(uint8_t i = 0; i < app->parked_count; i++) {
+        if(!app->parked[i].foreground) {
+            app->parked[kept++] = app->parked[i];
+        }
+    }
+    app->parked_count = kept;
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    cec_remote_stream_end(app, false);
+    furi_mutex_release(app->result_mutex);
+}
+
+// A request that timed out with nothing at all heard from the Pi meanwhile means
+// the Pi is gone (unplugged, rebooting): connect again in the background
+static void cec_remote_worker_check_timeouts(CECRemoteApp* app) {
+    uint32_t now = furi_get_tick();
+    bool silent = false;
+    for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+        CECPending* slot = &app->pending[i];
+        if(slot->active && slot->wants_reply && now - slot->sent_at >= CEC_REPLY_TIMEOUT_MS) {
+            // A late reply to this request is now recognised as stale
+            cec_remote_latency_record(app, slot, true);
+            app->baud_errors++;
+            silent = silent || now - app->last_rx >= CEC_REPLY_TIMEOUT_MS;
+            cec_remote_worker_complete(app, slot, false, "❌ No response from Pi");
+        }
+    }
+    if(silent || app->pi_restarted) {
+        FURI_LOG_W(TAG, "Link to Pi lost, connecting again");
+        cec_remote_link_restart(app);
+    }
+}
+
+// Worker thread: owns the serial link, pipelines queued jobs and routes replies
+static int32_t cec_remote_worker(void* context) {
+    CECRemoteApp* app = context;
+    uint32_t last_progress = 0;
+    
+    while(true) {
+        uint32_t flags = furi_thread_flags_wait(CECWorkerFlagStop | CECWorkerFlagCancel, FuriFlagWaitAny, 0);
+        if(!(flags & FuriFlagError)) {
+            if(flags & CECWorkerFlagStop) {
+                break;
+            }
+            if(flags & CECWorkerFlagCancel) {
+                cec_remote_worker_cancel(app);
+            }
+        }
+        
+        // Until the Pi answers, jobs wait and the handshake runs in the background
+        if(app->link_state != CECLinkUp) {
+            cec_remote_worker_park(app, app->link_state == CECLinkOff ? 50 : 0);
+            if(app->link_state == CECLinkConnecting) {
+                cec_remote_link_connect_step(app);
+            }
+            continue;
+        }
+        
+        // Keep up to CEC_MAX_INFLIGHT requests on the wire, block only when idle;
+        // while the Pi pushes events the link is read instead of blocking.
+        // Jobs that waited for the link go first.
+        CECJob job;
+        size_t inflight = cec_remote_link_inflight(app);
+        while(app->link_state == CECLinkUp && app->parked_count && inflight < CEC_MAX_INFLIGHT) {
+            job = app->parked[0];
+            app->parked_count--;
+            memmove(&app->parked[0], &app->parked[1], app->parked_count * sizeof(CECJob));
+            cec_remote_worker_start_job(app, &job);
+            inflight = cec_remote_link_inflight(app);
+        }
+        while(app->link_state == CECLinkUp && !app->parked_count && inflight < CEC_MAX_INFLIGHT &&
+              furi_message_queue_get(app->job_queue, &job, inflight || app->watching ? 0 : 50) == FuriStatusOk) {
+            cec_remote_worker_start_job(app, &job);
+            inflight = cec_remote_link_inflight(app);
+        }
+        if(inflight == 0 && !app->watching) {
+            continue;
+        }
+        
+        CECReply reply;
+        if(cec_remote_link_poll(app, 20, &reply)) {
+            CECPending* slot = cec_remote_link_find(app, reply.seq);
+            if(!slot) {
+                FURI_LOG_W(TAG, "Dropping stale reply seq=%u", reply.seq);
+            } else if(reply.partial) {
+                if(slot->wants_reply) {
+                    cec_remote_worker_partial(app, slot);
+                }
+            } else if(!slot->wants_reply) {
+                cec_remote_latency_record(app, slot, false);
+                slot->active = false;
+            } else {
+                cec_remote_latency_record(app, slot, false);
+                cec_remote_worker_complete(app, slot, reply.success, NULL);
+            }
+        }
+        cec_remote_worker_check_timeouts(app);
+        cec_remote_baud_check(app);
+        
+        if(furi_get_tick() - last_progress >= CEC_PROGRESS_INTERVAL_MS) {
+            last_progress = furi_get_tick();
+            for(size_t i = 0; i < CEC_MAX_INFLIGHT; i++) {
+                if(app->pending[i].active && app->pending[i].foreground) {
+                    view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventProgress);
+                    break;
+                }
+            }
+        }
+    }
+    
+    cec_remote_uart_deinit(app);
+    return 0;
+}
+
+// Queue a job for the worker without blocking the GUI
+static bool cec_remote_queue_job(CECRemoteApp* app, CECJobType type, const CECRequest* request, bool foreground) {
+    CECJob job = {.type = type, .foreground = foreground, .wants_reply = true, .queued_at = furi_get_tick()};
+    if(request) {
+        job.request = *request;
+    }
+    if(type == CECJobKey ||
+       (type == CECJobCommand && (request->opcode == CECOpDisplayLogs || request->opcode == CECOpClearLog))) {
+        job.wants_reply = false;
+    }
+    
+    if(furi_message_queue_put(app->job_queue, &job, 0) != FuriStatusOk) {
+        FURI_LOG_W(TAG, "Job queue full");
+        return false;
+    }
+    return true;
+}
+
+static void cec_remote_set_request(CECRemoteApp* app, uint8_t opcode, const uint8_t* data, size_t length) {
+    length = MIN(length, sizeof(app->request.data));
+    app->request.opcode = opcode;
+    app->request.length = length;
+    if(length > 0) {
+        memcpy(app->request.data, data, length);
+    }
+}
+
+// Fire-and-forget request, its reply is recognised by ID and dropped
+static void cec_remote_post_request(CECRemoteApp* app, uint8_t opcode) {
+    CECRequest request = {.opcode = opcode, .length = 0};
+    cec_remote_queue_job(app, CECJobCommand, &request, false);
+}
+
+static void cec_remote_send_key(CECRemoteApp* app, CECKeyAction action, uint8_t key) {
+    CECRequest request;
+    cec_protocol_key_request(&request, action, key, CEC_KEY_DEST_AUTO);
+    cec_remote_queue_job(app, CECJobKey, &request, false);
+}
+
+static void cec_remote_popup_done_callback(void* context) {
+    CECRemoteApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventPopupDone);
+}
+
+// Confirmation popup that returns to the menu on its own
+static void cec_remote_show_timed_popup(CECRemoteApp* app, const char* header, const char* text, uint32_t timeout_ms) {
+    popup_reset(app->popup);
+    popup_set_header(app->popup, header, 64, 10, AlignCenter, AlignTop);
+    popup_set_text(app->popup, text, 64, 32, AlignCenter, AlignCenter);
+    popup_set_callback(app->popup, cec_remote_popup_done_callback);
+    popup_set_context(app->popup, app);
+    popup_set_timeout(app->popup, timeout_ms);
+    popup_enable_timeout(app->popup);
+    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewPopup);
+}
+
+// Display logs on HDMI using CEC
+static void display_logs_on_hdmi(CECRemoteApp* app) {
+    // Send command to display logs on HDMI
+    cec_remote_post_request(app, CECOpDisplayLogs);
+    
+    // Auto return to menu after 2 seconds
+    cec_remote_show_timed_popup(app, "HDMI Display", "✅ Logs shown on HDMI\nCheck connected display", 2000);
+}
+
+// Clear logs
+static void clear_logs(CECRemoteApp* app) {
+    cec_remote_post_request(app, CECOpClearLog);
+    
+    cec_remote_show_timed_popup(app, "Clearing Logs", "✅ Logs cleared", 1000);
+}
+
+// Volume and mute are queued in the background so repeated presses never block
+static bool cec_remote_is_quick_command(uint32_t index) {
+    return index == CECCommandVolumeUp || index == CECCommandVolumeDown || index == CECCommandMute;
 }
 
-static bool cec_remote_uart_send(CECRemoteApp* app, const char* data) {
-    if(!app->uart_initialized || !app->serial_handle) {
+// Read the vendor index of one profile file, commands stay on the SD card
+static bool cec_remote_profiles_read_index(CECProfiles* profiles, File* file, const char* path) {
+    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
         return false;
     }
     
-    FURI_LOG_I(TAG, "Sending: %s", data);
-    
-    furi_hal_serial_tx(app->serial_handle, (uint8_t*)data, strlen(data));
-    furi_hal_serial_tx(app->serial_handle, (uint8_t*)"\n", 1);
-    furi_hal_serial_tx_wait_complete(app->serial_handle);
+    uint64_t file_size = storage_file_size(file);
+    uint8_t header[CEC_PROFILE_HEADER_SIZE];
+    bool valid = storage_file_read(file, header, sizeof(header)) == sizeof(header) &&
+                 memcmp(header, "CECP", 4) == 0 && header[4] == CEC_PROFILE_VERSION &&
+                 header[5] > 0 && header[5] <= CEC_PROFILE_MAX_VENDORS && header[6] == CEC_PROFILE_ENTRY_SIZE;
+    
+    uint8_t count = valid ? header[5] : 0;
+    for(uint8_t i = 0; valid && i < count; i++) {
+        uint8_t entry[CEC_PROFILE_ENTRY_SIZE];
+        CECProfileEntry* vendor = &profiles->vendors[i];
+        valid = storage_file_read(file, entry, sizeof(entry)) == sizeof(entry);
+        if(!valid) {
+            break;
+        }
+        memcpy(vendor->name, entry, CEC_PROFILE_NAME_SIZE);
+        vendor->name[CEC_PROFILE_NAME_SIZE - 1] = '\0';
+        vendor->offset = cec_remote_read_le(&entry[CEC_PROFILE_NAME_SIZE], 4);
+        vendor->length = cec_remote_read_le(&entry[CEC_PROFILE_NAME_SIZE + 4], 2);
+        vendor->crc = cec_remote_read_le(&entry[CEC_PROFILE_NAME_SIZE + 6], 2);
+        valid = vendor->length > 0 && vendor->length <= CEC_PROFILE_MAX_RECORD &&
+                vendor->offset + vendor->length <= file_size;
+    }
+    storage_file_close(file);
     
+    if(!valid) {
+        FURI_LOG_W(TAG, "Ignoring invalid profile file %s", path);
+        return false;
+    }
+    profiles->vendor_count = count;
+    profiles->path = path;
     return true;
 }
 
-static bool cec_remote_uart_receive(CECRemoteApp* app, char* buffer, size_t buffer_size, uint32_t timeout_ms) {
-    if(!app->uart_initialized || !app->serial_handle || !app->rx_stream) {
-        return false;
+static void cec_remote_profiles_load_index(CECRemoteApp* app) {
+    CECProfiles* profiles = &app->profiles;
+    if(profiles->path) {
+        return;
     }
     
-    uint32_t start_time = furi_get_tick();
-    size_t total_received = 0;
-    
-    while(furi_get_tick() - start_time < timeout_ms && total_received < buffer_size - 1) {
-        uint8_t byte;
-        if(furi_stream_buffer_receive(app->rx_stream, &byte, 1, 50) > 0) {
-            if(byte == '\n' || byte == '\r') {
-                buffer[total_received] = '\0';
-                if(total_received > 0) {
-                    FURI_LOG_I(TAG, "Received: %s", buffer);
-                    return true;
-                }
-            } else if(byte >= 32 && byte <= 126) {
-                buffer[total_received++] = byte;
-            }
-        }
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(!cec_remote_profiles_read_index(profiles, file, CEC_PROFILE_USER_PATH) &&
+       !cec_remote_profiles_read_index(profiles, file, CEC_PROFILE_ASSET_PATH)) {
+        profiles->vendor_count = 0;
+        FURI_LOG_W(TAG, "No vendor profiles, using built-in commands");
     }
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
     
-    buffer[total_received] = '\0';
-    return total_received > 0;
+    if(profiles->path) {
+        FURI_LOG_I(TAG, "%u vendor profiles in %s", profiles->vendor_count, profiles->path);
+    }
 }
 
-// Extract result from JSON response (simplified and safe)
-static void extract_result_from_json(const char* json_response, char* result_buffer, size_t buffer_size) {
-    // Simple and safe JSON parsing
-    const char* result_start = strstr(json_response, "\"result\":\"");
-    if(result_start) {
-        result_start += 10; // Skip "result":"
-        const char* result_end = strstr(result_start, "\"");
-        if(result_end) {
-            size_t result_len = result_end - result_start;
-            if(result_len < buffer_size - 1 && result_len < 400) { // Safety limit
-                strncpy(result_buffer, result_start, result_len);
-                result_buffer[result_len] = '\0';
-                return;
-            }
+// Point commands[] into a vendor record, rejecting anything that overruns it
+static bool cec_remote_profiles_parse(CECProfiles* profiles, const uint8_t* record, size_t length) {
+    memset(profiles->commands, 0, sizeof(profiles->commands));
+    
+    size_t pos = 1;
+    for(uint8_t i = 0; i < record[0]; i++) {
+        if(pos + 5 > length) {
+            return false;
         }
+        uint8_t slot = record[pos];
+        uint8_t cec_length = record[pos + 2];
+        uint8_t code_length = record[pos + 3];
+        uint8_t recipe_length = record[pos + 4];
+        pos += 5;
+        
+        if(slot >= CEC_PROFILE_SLOTS || cec_length > CEC_REQUEST_MAX_DATA ||
+           recipe_length > CEC_REQUEST_MAX_DATA || code_length == 0 || code_length > CEC_BRIGHTSIGN_MAX ||
+           pos + cec_length + code_length + recipe_length > length ||
+           record[pos + cec_length + code_length - 1] != '\0') {
+            return false;
+        }
+        
+        CECCommand* command = &profiles->commands[slot];
+        command->opcode = record[pos - 4];
+        command->cec_length = cec_length;
+        command->cec = &record[pos];
+        command->brightsign_ascii = (const char*)&record[pos + cec_length];
+        command->recipe.data = recipe_length ? &record[pos + cec_length + code_length] : NULL;
+        command->recipe.length = recipe_length;
+        pos += cec_length + code_length + recipe_length;
     }
-    
-    // Safe fallback
-    if(strstr(json_response, "success")) {
-        strncpy(result_buffer, "✅ Command sent", buffer_size - 1);
-    } else {
-        strncpy(result_buffer, "❌ Command failed", buffer_size - 1);
-    }
-    result_buffer[buffer_size - 1] = '\0';
+    return pos == length;
 }
 
-// Send command and get clean response
-static bool cec_remote_send_command(CECRemoteApp* app, const char* command) {
-    FURI_LOG_I(TAG, "Sending command: %s", command);
-    
-    if(!cec_remote_uart_send(app, command)) {
-        strcpy(app->result_buffer, "❌ UART send failed");
+// Keep only the selected vendor's commands in RAM
+static bool cec_remote_profiles_load_vendor(CECRemoteApp* app, uint8_t vendor) {
+    CECProfiles* profiles = &app->profiles;
+    if(profiles->record && profiles->loaded == vendor) {
+        return true;
+    }
+    if(!profiles->path || vendor >= profiles->vendor_count) {
         return false;
     }
     
-    char raw_response[512];  // Smaller buffer
-    if(!cec_remote_uart_receive(app, raw_response, sizeof(raw_response), 5000)) {
-        strcpy(app->result_buffer, "❌ No response from Pi");
+    free(profiles->record);
+    profiles->record = NULL;
+    
+    const CECProfileEntry* entry = &profiles->vendors[vendor];
+    uint8_t* record = malloc(entry->length);
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool valid = storage_file_open(file, profiles->path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+                 storage_file_seek(file, entry->offset, true) &&
+                 storage_file_read(file, record, entry->length) == entry->length;
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    
+    if(valid) {
+        uint16_t crc = 0xFFFF;
+        for(size_t i = 0; i < entry->length; i++) {
+            crc = cec_protocol_crc16_update(crc, record[i]);
+        }
+        valid = crc == entry->crc && cec_remote_profiles_parse(profiles, record, entry->length);
+    }
+    if(!valid) {
+        FURI_LOG_E(TAG, "Corrupt profile for %s", entry->name);
+        free(record);
         return false;
     }
     
-    // Extract clean result from JSON
-    extract_result_from_json(raw_response, app->result_buffer, sizeof(app->result_buffer));
-    
+    profiles->record = record;
+    profiles->loaded = vendor;
     return true;
 }
 
-// Display logs on HDMI using CEC
-static void display_logs_on_hdmi(CECRemoteApp* app) {
-    // Send command to display logs on HDMI
-    const char* display_command = "{\"command\":\"DISPLAY_LOGS_ON_HDMI\"}";
-    
-    popup_set_header(app->popup, "HDMI Display", 64, 10, AlignCenter, AlignTop);
-    popup_set_text(app->popup, "✅ Logs shown on HDMI\nCheck connected display", 64, 32, AlignCenter, AlignCenter);
-    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewPopup);
-    
-    cec_remote_uart_send(app, display_command);
-    
-    // Auto return to menu after 2 seconds
-    furi_delay_ms(2000);
-    scene_manager_previous_scene(app->scene_manager);
+// Commands for selected vendor
+static const CECCommand* get_vendor_commands(CECRemoteApp* app) {
+    CECProfiles* profiles = &app->profiles;
+    if(profiles->record && profiles->loaded == app->selected_vendor) {
+        return profiles->commands;
+    }
+    return builtin_commands;
 }
 
-// Clear logs
-static void clear_logs(CECRemoteApp* app) {
-    const char* clear_command = "{\"command\":\"CLEAR_FLIPPER_LOG\"}";
-    
-    popup_set_header(app->popup, "Clearing Logs", 64, 10, AlignCenter, AlignTop);
-    popup_set_text(app->popup, "✅ Logs cleared", 64, 32, AlignCenter, AlignCenter);
-    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewPopup);
-    
-    cec_remote_uart_send(app, clear_command);
-    
-    furi_delay_ms(1000);
-    scene_manager_previous_scene(app->scene_manager);
+static const char* get_vendor_name(CECRemoteApp* app) {
+    if(app->profiles.record && app->profiles.loaded == app->selected_vendor) {
+        return app->profiles.vendors[app->selected_vendor].name;
+    }
+    return "Generic";
 }
 
 // Vendor selection callback
@@ -402,7 +1668,16 @@ static void cec_remote_vendor_callback(void* context, uint32_t index) {
         display_logs_on_hdmi(app);
     } else if(index == CECVendorClearLogs) {
         clear_logs(app);
+    } else if(index == CECVendorDiagnostics) {
+        // Pi latency histograms; the Flipper's own round trips are added below them
+        cec_remote_set_request(app, CECOpStats, NULL, 0);
+        strcpy(app->brightsign_code, "");
+        scene_manager_next_scene(app->scene_manager, CECRemoteSceneResult);
     } else {
+        if(index != CECVendorBuiltin && !cec_remote_profiles_load_vendor(app, index)) {
+            notification_message(app->notifications, &sequence_error);
+            return;
+        }
         app->selected_vendor = index;
         app->last_command_menu_index = 0;  // Reset menu position for new vendor
         scene_manager_next_scene(app->scene_manager, CECRemoteSceneCommandMenu);
@@ -436,13 +1711,34 @@ static void cec_remote_command_callback(void* context, uint32_t index) {
         return;
     }
     
+    if(index == CECCommandRemote) {
+        scene_manager_next_scene(app->scene_manager, CECRemoteSceneRemote);
+        return;
+    }
+    
+    if(index == CECCommandDashboard) {
+        scene_manager_next_scene(app->scene_manager, CECRemoteSceneDashboard);
+        return;
+    }
+    
     // Get the command for this vendor
-    const CECCommand* commands = get_vendor_commands(app->selected_vendor);
-    strncpy(app->text_buffer, commands[index].command, sizeof(app->text_buffer) - 1);
-    app->text_buffer[sizeof(app->text_buffer) - 1] = '\0';
+    const CECCommand* command = &get_vendor_commands(app)[index];
+    cec_remote_set_request(app, command->opcode, command->cec, command->cec_length);
+    
+    // Whole vendor recipe in one round trip; JSON-only Pis get the single frame
+    if(command->recipe.length && app->binary_protocol) {
+        cec_remote_set_request(app, CECOpSequence, command->recipe.data, command->recipe.length);
+    }
+    
+    if(cec_remote_is_quick_command(index)) {
+        if(!cec_remote_queue_job(app, CECJobCommand, &app->request, false)) {
+            notification_message(app->notifications, &sequence_error);
+        }
+        return;
+    }
     
     // Store BrightSign code
-    strncpy(app->brightsign_code, commands[index].brightsign_ascii, sizeof(app->brightsign_code) - 1);
+    strncpy(app->brightsign_code, command->brightsign_ascii, sizeof(app->brightsign_code) - 1);
     app->brightsign_code[sizeof(app->brightsign_code) - 1] = '\0';
     
     scene_manager_next_scene(app->scene_manager, CECRemoteSceneResult);
@@ -452,9 +1748,7 @@ static void cec_remote_command_callback(void* context, uint32_t index) {
 static void cec_remote_text_input_callback(void* context) {
     CECRemoteApp* app = context;
     
-    snprintf(app->text_buffer, sizeof(app->text_buffer),
-             "{\"command\":\"CUSTOM\",\"cec_command\":\"%.50s\"}", 
-             app->custom_command);
+    cec_remote_set_request(app, CECOpCustom, (const uint8_t*)app->custom_command, strlen(app->custom_command));
     
     // Clear BrightSign code for custom commands
     strcpy(app->brightsign_code, "");
@@ -466,36 +1760,14 @@ static void cec_remote_text_input_callback(void* context) {
 void cec_remote_scene_start_on_enter(void* context) {
     CECRemoteApp* app = context;
     
-    // Enable 5V output for Pi power
+    // Enable 5V output for Pi power; it boots while the menus are already in use
+    app->powered_here = !furi_hal_power_is_otg_enabled();
     furi_hal_power_enable_otg();
+    app->power_on_at = furi_get_tick();
     
-    popup_set_header(app->popup, "CEC Remote v3.0", 64, 10, AlignCenter, AlignTop);
-    popup_set_text(app->popup, "Connecting to Pi...", 64, 32, AlignCenter, AlignCenter);
-    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewPopup);
-    
-    if(cec_remote_uart_init(app)) {
-        furi_delay_ms(500);
-        
-        if(cec_remote_uart_send(app, "{\"command\":\"PING\"}")) {
-            char response[256];
-            if(cec_remote_uart_receive(app, response, sizeof(response), 3000)) {
-                if(strstr(response, "success") || strstr(response, "pong")) {
-                    app->is_connected = true;
-                    notification_message(app->notifications, &sequence_success);
-                    popup_set_header(app->popup, "Connected!", 64, 10, AlignCenter, AlignTop);
-                    popup_set_text(app->popup, "Ready to control CEC devices", 64, 32, AlignCenter, AlignCenter);
-                    furi_delay_ms(1000);
-                    scene_manager_next_scene(app->scene_manager, CECRemoteSceneVendorSelect);
-                    return;
-                }
-            }
-        }
-    }
-    
-    app->is_connected = false;
-    popup_set_header(app->popup, "Connection Failed", 64, 10, AlignCenter, AlignTop);
-    popup_set_text(app->popup, "Check Pi connection\nPress Back to exit", 64, 32, AlignCenter, AlignCenter);
-    notification_message(app->notifications, &sequence_error);
+    // The worker connects in the background, commands wait for it
+    cec_remote_queue_job(app, CECJobConnect, NULL, false);
+    scene_manager_next_scene(app->scene_manager, CECRemoteSceneVendorSelect);
 }
 
 bool cec_remote_scene_start_on_event(void* context, SceneManagerEvent event) {
@@ -515,27 +1787,67 @@ void cec_remote_scene_start_on_exit(void* context) {
     popup_reset(app->popup);
 }
 
+// The brand menu shows whether the Pi is there yet
+static void cec_remote_vendor_select_set_header(CECRemoteApp* app) {
+    submenu_set_header(app->submenu, app->is_connected ? "Select Device Brand" : "Connecting to Pi...");
+}
+
 void cec_remote_scene_vendor_select_on_enter(void* context) {
     CECRemoteApp* app = context;
     
     submenu_reset(app->submenu);
-    submenu_set_header(app->submenu, "Select Device Brand");
-    
-    submenu_add_item(app->submenu, "Generic/Unknown", CECVendorGeneric, cec_remote_vendor_callback, app);
-    submenu_add_item(app->submenu, "Samsung TV", CECVendorSamsung, cec_remote_vendor_callback, app);
-    submenu_add_item(app->submenu, "Optoma Projector", CECVendorOptoma, cec_remote_vendor_callback, app);
-    submenu_add_item(app->submenu, "NEC Projector", CECVendorNEC, cec_remote_vendor_callback, app);
-    submenu_add_item(app->submenu, "Epson Projector", CECVendorEpson, cec_remote_vendor_callback, app);
-    submenu_add_item(app->submenu, "LG TV", CECVendorLG, cec_remote_vendor_callback, app);
+    cec_remote_vendor_select_set_header(app);
+    
+    // Only the index is read here; commands load when a vendor is picked
+    cec_remote_profiles_load_index(app);
+    for(uint8_t i = 0; i < app->profiles.vendor_count; i++) {
+        submenu_add_item(app->submenu, app->profiles.vendors[i].name, i, cec_remote_vendor_callback, app);
+    }
+    if(app->profiles.vendor_count == 0) {
+        submenu_add_item(app->submenu, "Generic/Unknown", CECVendorBuiltin, cec_remote_vendor_callback, app);
+    }
     submenu_add_item(app->submenu, "📺 Show on HDMI", CECVendorDisplayLogs, cec_remote_vendor_callback, app);
     submenu_add_item(app->submenu, "🗑️ Clear Logs", CECVendorClearLogs, cec_remote_vendor_callback, app);
+    submenu_add_item(app->submenu, "📊 Diagnostics", CECVendorDiagnostics, cec_remote_vendor_callback, app);
     
     view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewSubmenu);
 }
 
+// Background results and timed popups while a menu is showing
+static bool cec_remote_menu_handle_event(CECRemoteApp* app, SceneManagerEvent event) {
+    if(event.type != SceneManagerEventTypeCustom) {
+        return false;
+    }
+    
+    switch(event.event) {
+    case CECRemoteEventPopupDone:
+        popup_reset(app->popup);
+        view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewSubmenu);
+        return true;
+    case CECRemoteEventBackgroundSuccess:
+        notification_message(app->notifications, &sequence_blink_green_10);
+        return true;
+    case CECRemoteEventBackgroundError:
+        notification_message(app->notifications, &sequence_blink_red_10);
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool cec_remote_scene_vendor_select_on_event(void* context, SceneManagerEvent event) {
     CECRemoteApp* app = context;
-    bool consumed = false;
+    bool consumed = cec_remote_menu_handle_event(app, event);
+    
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == CECRemoteEventConnected || event.event == CECRemoteEventDisconnected) {
+            cec_remote_vendor_select_set_header(app);
+            consumed = true;
+        } else if(event.event == CECRemoteEventConnectFailed) {
+            cec_remote_show_timed_popup(app, "Connection Failed", "UART unavailable", 2000);
+            consumed = true;
+        }
+    }
     
     if(event.type == SceneManagerEventTypeBack) {
         furi_timer_start(app->cleanup_timer, 100);
@@ -556,20 +1868,18 @@ void cec_remote_scene_command_menu_on_enter(void* context) {
     submenu_reset(app->submenu);
     
     char header[64];
-    snprintf(header, sizeof(header), "%s Commands", get_vendor_name(app->selected_vendor));
+    snprintf(header, sizeof(header), "%s Commands", get_vendor_name(app));
     submenu_set_header(app->submenu, header);
     
-    submenu_add_item(app->submenu, "🔌 Power ON", CECCommandPowerOn, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "⏸️ Power OFF", CECCommandPowerOff, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "📺 HDMI 1", CECCommandHDMI1, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "📺 HDMI 2", CECCommandHDMI2, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "📺 HDMI 3", CECCommandHDMI3, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "📺 HDMI 4", CECCommandHDMI4, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "🔊 Volume UP", CECCommandVolumeUp, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "🔉 Volume DOWN", CECCommandVolumeDown, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "🔇 Mute", CECCommandMute, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "🔍 Scan Devices", CECCommandScan, cec_remote_command_callback, app);
-    submenu_add_item(app->submenu, "ℹ️ Status", CECCommandStatus, cec_remote_command_callback, app);
+    // Commands the vendor profile leaves out are not offered
+    const CECCommand* commands = get_vendor_commands(app);
+    for(uint32_t slot = 0; slot < CEC_PROFILE_SLOTS; slot++) {
+        if(commands[slot].opcode) {
+            submenu_add_item(app->submenu, cec_command_labels[slot], slot, cec_remote_command_callback, app);
+        }
+    }
+    submenu_add_item(app->submenu, "🎮 Remote", CECCommandRemote, cec_remote_command_callback, app);
+    submenu_add_item(app->submenu, "📡 Dashboard", CECCommandDashboard, cec_remote_command_callback, app);
     submenu_add_item(app->submenu, "📺 Show on HDMI", CECCommandDisplayLogs, cec_remote_command_callback, app);
     submenu_add_item(app->submenu, "🗑️ Clear Logs", CECCommandClearLogs, cec_remote_command_callback, app);
     submenu_add_item(app->submenu, "⚙️ Custom Command", CECCommandCustom, cec_remote_command_callback, app);
@@ -582,9 +1892,8 @@ void cec_remote_scene_command_menu_on_enter(void* context) {
 }
 
 bool cec_remote_scene_command_menu_on_event(void* context, SceneManagerEvent event) {
-    UNUSED(context);
-    UNUSED(event);
-    return false;
+    CECRemoteApp* app = context;
+    return cec_remote_menu_handle_event(app, event);
 }
 
 void cec_remote_scene_command_menu_on_exit(void* context) {
@@ -609,9 +1918,10 @@ void cec_remote_scene_custom_on_enter(void* context) {
 }
 
 bool cec_remote_scene_custom_on_event(void* context, SceneManagerEvent event) {
-    UNUSED(context);
-    UNUSED(event);
-    return false;
+    CECRemoteApp* app = context;
+    // Only background notifications; popups never show over the text input
+    return event.type == SceneManagerEventTypeCustom && event.event != CECRemoteEventPopupDone &&
+           cec_remote_menu_handle_event(app, event);
 }
 
 void cec_remote_scene_custom_on_exit(void* context) {
@@ -619,44 +1929,286 @@ void cec_remote_scene_custom_on_exit(void* context) {
     text_input_reset(app->text_input);
 }
 
-void cec_remote_scene_result_on_enter(void* context) {
-    CECRemoteApp* app = context;
+// Lay the ring out as lines of at most CEC_RESULT_COLUMNS characters and
+// draw rows first.. when a canvas is given; returns the number of lines
+static uint16_t cec_remote_result_layout(const CECResultRing* ring, Canvas* canvas, uint16_t first) {
+    char line[CEC_RESULT_COLUMNS * 4 + 1];  // A character is up to 4 UTF-8 bytes
+    size_t length = 0;
+    uint8_t columns = 0;
+    uint16_t lines = 0;
+    
+    // Once old text has dropped out the first line is a fragment, start after it
+    uint32_t start = ring->tail;
+    if(ring->tail > 0) {
+        while(start != ring->head && cec_remote_ring_at(ring, start) != '\n') {
+            start++;
+        }
+        start = (start == ring->head) ? ring->tail : start + 1;
+    }
     
-    memset(app->result_buffer, 0, sizeof(app->result_buffer));
+    for(uint32_t position = start; position != ring->head; position++) {
+        char c = cec_remote_ring_at(ring, position);
+        bool continuation = ((uint8_t)c & 0xC0) == 0x80;
+        bool wrap = columns == CEC_RESULT_COLUMNS && !continuation;
+        if(c == '\n' || wrap) {
+            if(canvas && lines >= first && lines < first + CEC_RESULT_ROWS) {
+                line[length] = '\0';
+                canvas_draw_str(canvas, 0, CEC_RESULT_TOP + (lines - first) * CEC_RESULT_ROW_HEIGHT, line);
+            }
+            lines++;
+            length = 0;
+            columns = 0;
+            if(c == '\n') {
+                continue;
+            }
+        }
+        if(c == '\r') {
+            continue;
+        }
+        if(length < sizeof(line) - 1) {
+            line[length++] = c;
+        }
+        if(!continuation) {
+            columns++;
+        }
+    }
+    if(length > 0) {
+        if(canvas && lines >= first && lines < first + CEC_RESULT_ROWS) {
+            line[length] = '\0';
+            canvas_draw_str(canvas, 0, CEC_RESULT_TOP + (lines - first) * CEC_RESULT_ROW_HEIGHT, line);
+        }
+        lines++;
+    }
+    return lines;
+}
+
+// First visible line for a model and a text of total lines
+static uint16_t cec_remote_result_top(const CECResultViewModel* model, uint16_t total) {
+    uint16_t last_page = total > CEC_RESULT_ROWS ? total - CEC_RESULT_ROWS : 0;
+    return model->follow ? last_page : MIN(model->top, last_page);
+}
+
+static void cec_remote_result_draw_callback(Canvas* canvas, void* context) {
+    CECResultViewModel* model = context;
+    
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 0, 10, model->header);
+    canvas_draw_line(canvas, 0, 12, 127, 12);
+    
+    // Rendered from the ring as it fills, the worker only waits while this runs
+    canvas_set_font(canvas, FontKeyboard);
+    furi_mutex_acquire(model->mutex, FuriWaitForever);
+    uint16_t total = cec_remote_result_layout(model->ring, NULL, 0);
+    uint16_t top = cec_remote_result_top(model, total);
+    cec_remote_result_layout(model->ring, canvas, top);
+    furi_mutex_release(model->mutex);
+    
+    if(total == 0 && model->waiting) {
+        canvas_draw_str_aligned(canvas, 64, 40, AlignCenter, AlignCenter, "Back to cancel");
+    }
+    if(total > CEC_RESULT_ROWS) {
+        // Scroll bar
+        uint16_t track = 64 - 14;
+        uint16_t thumb = MAX(track * CEC_RESULT_ROWS / total, 3);
+        canvas_draw_line(canvas, 126, 14, 126, 63);
+        canvas_draw_box(canvas, 125, 14 + (track - thumb) * top / (total - CEC_RESULT_ROWS), 3, thumb);
+    }
+}
+
+// Up/Down scroll a line, Left/Right a page, OK jumps back to the newest text
+static bool cec_remote_result_input_callback(InputEvent* event, void* context) {
+    CECRemoteApp* app = context;
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) {
+        return false;
+    }
     
-    popup_set_header(app->popup, "Sending...", 64, 10, AlignCenter, AlignTop);
-    popup_set_text(app->popup, "Please wait...", 64, 32, AlignCenter, AlignCenter);
-    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewPopup);
+    int32_t step;
+    switch(event->key) {
+    case InputKeyUp:
+        step = -1;
+        break;
+    case InputKeyDown:
+        step = 1;
+        break;
+    case InputKeyLeft:
+        step = -CEC_RESULT_ROWS;
+        break;
+    case InputKeyRight:
+        step = CEC_RESULT_ROWS;
+        break;
+    case InputKeyOk:
+        step = INT16_MAX;
+        break;
+    default:
+        return false;
+    }
     
-    // Send command and get clean response
-    if(cec_remote_send_command(app, app->text_buffer)) {
-        popup_set_header(app->popup, "Command Result", 64, 5, AlignCenter, AlignTop);
-        
-        // Create display text with better formatting and spacing
-        char display_text[256];
-        if(strlen(app->brightsign_code) > 0) {
-            // Format: Result message + BrightSign code with proper spacing
-            // Using larger spacing between lines for better readability
-            snprintf(display_text, sizeof(display_text), 
-                    "%.35s\n\n\nBrightSign Code:\n%.20s", 
-                    app->result_buffer, app->brightsign_code);
-        } else {
-            // Show just the result for commands without BrightSign codes
-            strncpy(display_text, app->result_buffer, sizeof(display_text) - 1);
-            display_text[sizeof(display_text) - 1] = '\0';
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    uint16_t total = cec_remote_result_layout(&app->result, NULL, 0);
+    furi_mutex_release(app->result_mutex);
+    
+    with_view_model(
+        app->result_view,
+        CECResultViewModel * model,
+        {
+            int32_t last_page = total > CEC_RESULT_ROWS ? total - CEC_RESULT_ROWS : 0;
+            int32_t top = (int32_t)cec_remote_result_top(model, total) + step;
+            top = CLAMP(top, last_page, 0);
+            model->top = top;
+            // Scrolled to the end: keep following new text
+            model->follow = top == last_page;
+        },
+        true);
+    return true;
+}
+
+static void cec_remote_result_set_header(CECRemoteApp* app, const char* header, bool waiting) {
+    with_view_model(
+        app->result_view,
+        CECResultViewModel * model,
+        {
+            strncpy(model->header, header, sizeof(model->header) - 1);
+            model->header[sizeof(model->header) - 1] = '\0';
+            model->waiting = waiting;
+        },
+        true);
+}
+
+static void cec_remote_result_show_progress(CECRemoteApp* app) {
+    uint32_t elapsed = furi_get_tick() - app->result_started;
+    char header[24];
+    
+    snprintf(
+        header,
+        sizeof(header),
+        "%s %lu.%lus",
+        app->result_progress == CECProgressSent ? "Waiting" : "Queued",
+        elapsed / 1000,
+        (elapsed % 1000) / 100);
+    cec_remote_result_set_header(app, header, true);
+}
+
+// Upper bound of the bucket holding the percent-th round trip, capped at the slowest seen
+static uint32_t cec_remote_latency_percentile(const CECLatency* latency, uint8_t percent) {
+    uint32_t rank = (latency->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for(uint8_t i = 0; i < CEC_LATENCY_BUCKETS - 1; i++) {
+        seen += latency->buckets[i];
+        if(seen >= rank) {
+            return MIN((uint32_t)1 << i, latency->max_ms);
         }
-        
-        // Use larger text positioning for better visibility
-        popup_set_text(app->popup, display_text, 64, 35, AlignCenter, AlignCenter);
-        
-        if(strstr(app->result_buffer, "✅")) {
-            notification_message(app->notifications, &sequence_success);
-        } else {
-            notification_message(app->notifications, &sequence_error);
+    }
+    return latency->max_ms;
+}
+
+// Round trips as seen from here: Pi time plus the UART in both directions
+static void cec_remote_latency_show(CECRemoteApp* app) {
+    static const char* names[CEC_LATENCY_OPCODES] = {
+        [CECOpPing] = "PING",
+        [CECOpPowerOn] = "POWER_ON",
+        [CECOpPowerOff] = "POWER_OFF",
+        [CECOpScan] = "SCAN",
+        [CECOpStatus] = "STATUS",
+        [CECOpTx] = "TX",
+        [CECOpCustom] = "CUSTOM",
+        [CECOpDiscover] = "DISCOVER",
+        [CECOpSequence] = "SEQUENCE",
+        [CECOpStats] = "STATS",
+    };
+    CECLatency latency[CEC_LATENCY_OPCODES];
+    char line[32];
+
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    memcpy(latency, app->latency, sizeof(latency));
+    uint32_t connected_ms = app->connected_ms;
+    uint32_t first_command_ms = app->first_command_ms;
+    furi_mutex_release(app->result_mutex);
+
+    // Cold start as the user saw it, 0 for what has not happened yet
+    cec_remote_result_append(app, app->powered_here ? "\n⏱️ From power on" : "\n⏱️ From app start");
+    snprintf(
+        line,
+        sizeof(line),
+        " link %lu.%lus cmd %lu.%lus",
+        connected_ms / 1000,
+        (connected_ms % 1000) / 100,
+        first_command_ms / 1000,
+        (first_command_ms % 1000) / 100);
+    cec_remote_result_append(app, line);
+
+    cec_remote_result_append(app, "\n📟 Flipper round trip");
+    cec_remote_result_append(app, "ms p50/p95/p99");
+    for(uint8_t op = 0; op < CEC_LATENCY_OPCODES; op++) {
+        const CECLatency* entry = &latency[op];
+        if(entry->count == 0 && entry->timeouts == 0) {
+            continue;
         }
+        snprintf(line, sizeof(line), "%s n=%u lost=%u", names[op] ? names[op] : "OTHER", entry->count, entry->timeouts);
+        cec_remote_result_append(app, line);
+        if(entry->count) {
+            snprintf(
+                line,
+                sizeof(line),
+                " rtt %lu/%lu/%lu",
+                cec_remote_latency_percentile(entry, 50),
+                cec_remote_latency_percentile(entry, 95),
+                cec_remote_latency_percentile(entry, 99));
+            cec_remote_result_append(app, line);
+        }
+    }
+}
+
+static void cec_remote_result_show(CECRemoteApp* app) {
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    bool success = app->last_success;
+    furi_mutex_release(app->result_mutex);
+    
+    if(app->request.opcode == CECOpStats) {
+        cec_remote_latency_show(app);
+    }
+    if(strlen(app->brightsign_code) > 0) {
+        // BrightSign code below the result, in the same scrollable text
+        char code[CEC_BRIGHTSIGN_MAX + 16];
+        snprintf(code, sizeof(code), "\nBrightSign Code:\n%s", app->brightsign_code);
+        cec_remote_result_append(app, code);
+    }
+    cec_remote_result_set_header(app, success ? "Command Result" : "Command Failed", false);
+    
+    if(success) {
+        notification_message(app->notifications, &sequence_success);
+    } else {
+        notification_message(app->notifications, &sequence_error);
+    }
+}
+
+void cec_remote_scene_result_on_enter(void* context) {
+    CECRemoteApp* app = context;
+    
+    furi_mutex_acquire(app->result_mutex, FuriWaitForever);
+    cec_remote_ring_reset(&app->result);
+    furi_mutex_release(app->result_mutex);
+    
+    with_view_model(
+        app->result_view,
+        CECResultViewModel * model,
+        {
+            model->follow = true;
+            model->top = 0;
+        },
+        false);
+    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewResult);
+    
+    // The worker sends the command; text, progress and the result arrive as it streams in
+    app->result_started = furi_get_tick();
+    app->result_progress = CECProgressQueued;
+    app->result_waiting = cec_remote_queue_job(app, CECJobCommand, &app->request, true);
+    
+    if(app->result_waiting) {
+        cec_remote_result_show_progress(app);
     } else {
-        popup_set_header(app->popup, "Error", 64, 5, AlignCenter, AlignTop);
-        popup_set_text(app->popup, app->result_buffer, 64, 35, AlignCenter, AlignCenter);
+        cec_remote_result_append(app, "❌ Too many queued commands");
+        cec_remote_result_set_header(app, "Error", false);
         notification_message(app->notifications, &sequence_error);
     }
 }
@@ -665,7 +2217,23 @@ bool cec_remote_scene_result_on_event(void* context, SceneManagerEvent event) {
     CECRemoteApp* app = context;
     bool consumed = false;
     
-    if(event.type == SceneManagerEventTypeBack) {
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == CECRemoteEventProgress && app->result_waiting) {
+            cec_remote_result_show_progress(app);
+            consumed = true;
+        } else if(event.event == CECRemoteEventResult && app->result_waiting) {
+            app->result_waiting = false;
+            cec_remote_result_show(app);
+            consumed = true;
+        } else {
+            consumed = cec_remote_menu_handle_event(app, event);
+        }
+    } else if(event.type == SceneManagerEventTypeBack) {
+        if(app->result_waiting) {
+            // Cancel: the worker drops the reply whenever it shows up
+            furi_thread_flags_set(furi_thread_get_id(app->worker_thread), CECWorkerFlagCancel);
+            app->result_waiting = false;
+        }
         scene_manager_previous_scene(app->scene_manager);
         consumed = true;
     }
@@ -675,7 +2243,247 @@ bool cec_remote_scene_result_on_event(void* context, SceneManagerEvent event) {
 
 void cec_remote_scene_result_on_exit(void* context) {
     CECRemoteApp* app = context;
-    popup_reset(app->popup);
+    cec_remote_result_set_header(app, "", false);
+}
+
+static void cec_remote_remote_draw_callback(Canvas* canvas, void* context) {
+    CECRemoteViewModel* model = context;
+    static const char* const labels[2][InputKeyBack] = {
+        {[InputKeyUp] = "Up", [InputKeyDown] = "Down", [InputKeyRight] = "Right", [InputKeyLeft] = "Left",
+         [InputKeyOk] = "OK"},
+        {[InputKeyUp] = "Vol +", [InputKeyDown] = "Vol -", [InputKeyOk] = "Mute"},
+    };
+    static const uint8_t x[InputKeyBack] = {[InputKeyUp] = 40, [InputKeyDown] = 40, [InputKeyRight] = 66,
+                                            [InputKeyLeft] = 10, [InputKeyOk] = 40};
+    static const uint8_t y[InputKeyBack] = {[InputKeyUp] = 24, [InputKeyDown] = 54, [InputKeyRight] = 39,
+                                            [InputKeyLeft] = 39, [InputKeyOk] = 39};
+    
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 0, 10, model->volume_page ? "Remote: Volume" : "Remote: Navigate");
+    canvas_draw_line(canvas, 0, 12, 127, 12);
+    
+    canvas_set_font(canvas, FontSecondary);
+    for(uint8_t key = 0; key < InputKeyBack; key++) {
+        const char* label = labels[model->volume_page][key];
+        if(!label) {
+            continue;
+        }
+        canvas_draw_str_aligned(canvas, x[key], y[key], AlignCenter, AlignCenter, label);
+        if(key == model->held) {
+            canvas_draw_frame(canvas, x[key] - 16, y[key] - 6, 32, 12);
+        }
+    }
+    canvas_draw_str_aligned(canvas, 127, 24, AlignRight, AlignCenter, "Long OK");
+    canvas_draw_str_aligned(canvas, 127, 33, AlignRight, AlignCenter, model->volume_page ? "arrows" : "volume");
+    canvas_draw_str_aligned(canvas, 127, 48, AlignRight, AlignCenter, "Long Back");
+    canvas_draw_str_aligned(canvas, 127, 57, AlignRight, AlignCenter, "quit");
+}
+
+// Arrows are held keys: down on press, repeats while the button repeats, up on release
+static bool cec_remote_remote_input_callback(InputEvent* event, void* context) {
+    CECRemoteApp* app = context;
+    CECRemoteViewModel* model = view_get_model(app->remote_view);
+    bool update = false;
+    
+    if(event->key == InputKeyOk || event->key == InputKeyBack) {
+        if(event->type == InputTypeShort) {
+            uint8_t code = event->key == InputKeyBack ? CEC_UI_EXIT :
+                           model->volume_page         ? CEC_UI_MUTE :
+                                                        CEC_UI_SELECT;
+            cec_remote_send_key(app, CECKeyDown, code);
+            cec_remote_send_key(app, CECKeyUp, code);
+        } else if(event->type == InputTypeLong && event->key == InputKeyOk) {
+            model->volume_page = !model->volume_page;
+            update = true;
+        } else if(event->type == InputTypeLong) {
+            view_dispatcher_send_custom_event(app->view_dispatcher, CECRemoteEventRemoteExit);
+        }
+    } else if(event->key < InputKeyOk) {
+        uint8_t code = cec_remote_keys[model->volume_page][event->key];
+        if(event->type == InputTypePress && code != CEC_REMOTE_NO_KEY) {
+            if(model->held != InputKeyMAX) {
+                cec_remote_send_key(app, CECKeyUp, model->held_code);
+            }
+            model->held = event->key;
+            model->held_code = code;
+            cec_remote_send_key(app, CECKeyDown, code);
+            update = true;
+        } else if(event->key == model->held) {
+            if(event->type == InputTypeLong || event->type == InputTypeRepeat) {
+                cec_remote_send_key(app, CECKeyRepeat, model->held_code);
+            } else if(event->type == InputTypeRelease) {
+                cec_remote_send_key(app, CECKeyUp, model->held_code);
+                model->held = InputKeyMAX;
+                update = true;
+            }
+        }
+    }
+    
+    view_commit_model(app->remote_view, update);
+    return true;
+}
+
+void cec_remote_scene_remote_on_enter(void* context) {
+    CECRemoteApp* app = context;
+    
+    with_view_model(
+        app->remote_view,
+        CECRemoteViewModel * model,
+        {
+            model->volume_page = false;
+            model->held = InputKeyMAX;
+        },
+        false);
+    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewRemote);
+}
+
+bool cec_remote_scene_remote_on_event(void* context, SceneManagerEvent event) {
+    CECRemoteApp* app = context;
+    
+    if(event.type == SceneManagerEventTypeCustom && event.event == CECRemoteEventRemoteExit) {
+        scene_manager_previous_scene(app->scene_manager);
+        return true;
+    }
+    return event.type == SceneManagerEventTypeCustom && event.event != CECRemoteEventPopupDone &&
+           cec_remote_menu_handle_event(app, event);
+}
+
+void cec_remote_scene_remote_on_exit(void* context) {
+    CECRemoteApp* app = context;
+    
+    // Never leave a key held on the TV
+    with_view_model(
+        app->remote_view,
+        CECRemoteViewModel * model,
+        {
+            if(model->held != InputKeyMAX) {
+                cec_remote_send_key(app, CECKeyUp, model->held_code);
+                model->held = InputKeyMAX;
+            }
+        },
+        false);
+}
+
+static void cec_remote_dashboard_draw_callback(Canvas* canvas, void* context) {
+    CECDashboardViewModel* model = context;
+    static const char* const logical_names[CEC_DASHBOARD_DEVICES] = {
+        "TV", "Rec 1", "Rec 2", "Tuner 1", "Play 1", "Audio", "Tuner 2", "Tuner 3",
+        "Play 2", "Rec 3", "Tuner 4", "Play 3", "Res 1", "Res 2", "Free"};
+    static const char* const power_names[] = {"on", "standby", ">on", ">standby"};
+    char line[40];
+    
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 0, 10, "Bus Dashboard");
+    canvas_draw_line(canvas, 0, 12, 127, 12);
+    canvas_set_font(canvas, FontSecondary);
+    
+    if(!model->watching) {
+        canvas_draw_str(canvas, 0, 26, "Pi sends no events");
+        canvas_draw_str(canvas, 0, 38, "over a JSON link");
+        return;
+    }
+    
+    if(!model->has_source) {
+        snprintf(line, sizeof(line), "Source unknown");
+    } else if(model->source == CEC_EVENT_NO_DEVICE) {
+        snprintf(
+            line,
+            sizeof(line),
+            "Source %x.%x.%x.%x",
+            model->source_path >> 12,
+            (model->source_path >> 8) & 0xF,
+            (model->source_path >> 4) & 0xF,
+            model->source_path & 0xF);
+    } else {
+        const CECDashboardDevice* device = &model->devices[model->source];
+        snprintf(
+            line,
+            sizeof(line),
+            "Source %.8s %x.%x.%x.%x",
+            device->name[0] ? device->name : logical_names[model->source],
+            model->source_path >> 12,
+            (model->source_path >> 8) & 0xF,
+            (model->source_path >> 4) & 0xF,
+            model->source_path & 0xF);
+    }
+    canvas_draw_str(canvas, 0, 22, line);
+    
+    uint8_t row = 0;
+    uint8_t index = 0;
+    for(uint8_t logical = 0; logical < CEC_DASHBOARD_DEVICES; logical++) {
+        const CECDashboardDevice* device = &model->devices[logical];
+        if(!device->present || index++ < model->top) {
+            continue;
+        }
+        if(row == CEC_DASHBOARD_ROWS) {
+            break;
+        }
+        uint8_t y = 33 + row * CEC_RESULT_ROW_HEIGHT;
+        snprintf(line, sizeof(line), "%X %s", logical, device->name[0] ? device->name : logical_names[logical]);
+        canvas_draw_str(canvas, 0, y, line);
+        canvas_draw_str_aligned(
+            canvas,
+            127,
+            y,
+            AlignRight,
+            AlignBottom,
+            device->power < COUNT_OF(power_names) ? power_names[device->power] : "?");
+        row++;
+    }
+    if(index == 0) {
+        canvas_draw_str(canvas, 0, 33, model->events ? "No devices" : "Waiting for the Pi...");
+    }
+}
+
+// Up/Down scroll the device list, OK asks the Pi for everything again
+static bool cec_remote_dashboard_input_callback(InputEvent* event, void* context) {
+    CECRemoteApp* app = context;
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) {
+        return false;
+    }
+    
+    if(event->key == InputKeyOk) {
+        cec_remote_queue_job(app, CECJobWatch, NULL, false);
+        return true;
+    }
+    if(event->key != InputKeyUp && event->key != InputKeyDown) {
+        return false;
+    }
+    with_view_model(
+        app->dashboard_view,
+        CECDashboardViewModel * model,
+        {
+            uint8_t present = 0;
+            for(uint8_t logical = 0; logical < CEC_DASHBOARD_DEVICES; logical++) {
+                present += model->devices[logical].present;
+            }
+            if(event->key == InputKeyUp && model->top > 0) {
+                model->top--;
+            } else if(event->key == InputKeyDown && model->top + CEC_DASHBOARD_ROWS < present) {
+                model->top++;
+            }
+        },
+        true);
+    return true;
+}
+
+void cec_remote_scene_dashboard_on_enter(void* context) {
+    CECRemoteApp* app = context;
+    
+    with_view_model(app->dashboard_view, CECDashboardViewModel * model, { model->top = 0; }, false);
+    view_dispatcher_switch_to_view(app->view_dispatcher, CECRemoteViewDashboard);
+}
+
+bool cec_remote_scene_dashboard_on_event(void* context, SceneManagerEvent event) {
+    CECRemoteApp* app = context;
+    return event.type == SceneManagerEventTypeCustom && event.event != CECRemoteEventPopupDone &&
+           cec_remote_menu_handle_event(app, event);
+}
+
+void cec_remote_scene_dashboard_on_exit(void* context) {
+    UNUSED(context);
 }
 
 // View dispatcher callbacks
@@ -686,6 +2494,12 @@ static bool cec_remote_view_dispatcher_navigation_event_callback(void* context)
 
 static bool cec_remote_view_dispatcher_custom_event_callback(void* context, uint32_t event) {
     CECRemoteApp* app = context;
+    // The link comes and goes in the background, whatever screen is showing
+    if(event == CECRemoteEventConnected) {
+        notification_message(app->notifications, &sequence_success);
+    } else if(event == CECRemoteEventDisconnected || event == CECRemoteEventConnectFailed) {
+        notification_message(app->notifications, &sequence_error);
+    }
     return scene_manager_handle_custom_event(app->scene_manager, event);
 }
 
@@ -696,6 +2510,8 @@ void (*const cec_remote_scene_on_enter_handlers[])(void*) = {
     cec_remote_scene_command_menu_on_enter,
     cec_remote_scene_custom_on_enter,
     cec_remote_scene_result_on_enter,
+    cec_remote_scene_remote_on_enter,
+    cec_remote_scene_dashboard_on_enter,
 };
 
 bool (*const cec_remote_scene_on_event_handlers[])(void*, SceneManagerEvent) = {
@@ -704,6 +2520,8 @@ bool (*const cec_remote_scene_on_event_handlers[])(void*, SceneManagerEvent) = {
     cec_remote_scene_command_menu_on_event,
     cec_remote_scene_custom_on_event,
     cec_remote_scene_result_on_event,
+    cec_remote_scene_remote_on_event,
+    cec_remote_scene_dashboard_on_event,
 };
 
 void (*const cec_remote_scene_on_exit_handlers[])(void*) = {
@@ -712,6 +2530,8 @@ void (*const cec_remote_scene_on_exit_handlers[])(void*) = {
     cec_remote_scene_command_menu_on_exit,
     cec_remote_scene_custom_on_exit,
     cec_remote_scene_result_on_exit,
+    cec_remote_scene_remote_on_exit,
+    cec_remote_scene_dashboard_on_exit,
 };
 
 const SceneManagerHandlers cec_remote_scene_handlers = {
@@ -725,9 +2545,10 @@ const SceneManagerHandlers cec_remote_scene_handlers = {
 static CECRemoteApp* cec_remote_app_alloc(void) {
     CECRemoteApp* app = malloc(sizeof(CECRemoteApp));
     
-    memset(app->text_buffer, 0, sizeof(app->text_buffer));
+    memset(&app->request, 0, sizeof(app->request));
+    memset(&app->decoder, 0, sizeof(app->decoder));
     memset(app->custom_command, 0, sizeof(app->custom_command));
-    memset(app->result_buffer, 0, sizeof(app->result_buffer));
+    cec_remote_ring_reset(&app->result);
     memset(app->brightsign_code, 0, sizeof(app->brightsign_code));
     
     app->gui = furi_record_open(RECORD_GUI);
@@ -752,16 +2573,87 @@ static CECRemoteApp* cec_remote_app_alloc(void) {
     app->popup = popup_alloc();
     view_dispatcher_add_view(app->view_dispatcher, CECRemoteViewPopup, popup_get_view(app->popup));
     
+    app->result_view = view_alloc();
+    view_set_context(app->result_view, app);
+    view_set_draw_callback(app->result_view, cec_remote_result_draw_callback);
+    view_set_input_callback(app->result_view, cec_remote_result_input_callback);
+    view_allocate_model(app->result_view, ViewModelTypeLocking, sizeof(CECResultViewModel));
+    view_dispatcher_add_view(app->view_dispatcher, CECRemoteViewResult, app->result_view);
+    
+    app->remote_view = view_alloc();
+    view_set_context(app->remote_view, app);
+    view_set_draw_callback(app->remote_view, cec_remote_remote_draw_callback);
+    view_set_input_callback(app->remote_view, cec_remote_remote_input_callback);
+    view_allocate_model(app->remote_view, ViewModelTypeLocking, sizeof(CECRemoteViewModel));
+    view_dispatcher_add_view(app->view_dispatcher, CECRemoteViewRemote, app->remote_view);
+    
+    app->dashboard_view = view_alloc();
+    view_set_context(app->dashboard_view, app);
+    view_set_draw_callback(app->dashboard_view, cec_remote_dashboard_draw_callback);
+    view_set_input_callback(app->dashboard_view, cec_remote_dashboard_input_callback);
+    view_allocate_model(app->dashboard_view, ViewModelTypeLocking, sizeof(CECDashboardViewModel));
+    view_dispatcher_add_view(app->view_dispatcher, CECRemoteViewDashboard, app->dashboard_view);
+    
     app->is_connected = false;
+    app->link_state = CECLinkOff;
+    app->connect_attempts = 0;
+    app->next_ping_at = 0;
+    app->last_rx = 0;
+    app->pi_restarted = false;
+    app->parked_count = 0;
+    app->power_on_at = furi_get_tick();
+    app->powered_here = false;
+    app->connected_ms = 0;
+    app->first_command_ms = 0;
     app->uart_initialized = false;
+    app->binary_protocol = false;
+    app->watching = false;
+    app->baud_rate = CEC_BAUD_DEFAULT;
+    app->baud_errors = 0;
+    app->baud_window_start = 0;
+    app->last_success = false;
+    app->result_waiting = false;
+    app->next_seq = 1;
+    memset(app->pending, 0, sizeof(app->pending));
+    memset(&app->stream, 0, sizeof(app->stream));
+    cec_protocol_json_reset(&app->json);
+    app->rx_chunk_length = 0;
+    app->rx_chunk_position = 0;
     app->serial_handle = NULL;
     app->rx_stream = NULL;
-    app->selected_vendor = CECVendorGeneric;
+    app->selected_vendor = CECVendorBuiltin;
+    memset(&app->profiles, 0, sizeof(app->profiles));
     app->last_command_menu_index = 0;  // Initialize menu position
     
     // Create cleanup timer
     app->cleanup_timer = furi_timer_alloc(cec_remote_cleanup_timer_callback, FuriTimerTypeOnce, app);
     
+    // All serial I/O happens on the worker; the GUI only queues jobs
+    app->result_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    with_view_model(
+        app->result_view,
+        CECResultViewModel * model,
+        {
+            model->ring = &app->result;
+            model->mutex = app->result_mutex;
+            model->header[0] = '\0';
+            model->waiting = false;
+            model->follow = true;
+            model->top = 0;
+        },
+        false);
+    with_view_model(
+        app->dashboard_view,
+        CECDashboardViewModel * model,
+        {
+            memset(model, 0, sizeof(*model));
+            model->source = CEC_EVENT_NO_DEVICE;
+        },
+        false);
+    app->job_queue = furi_message_queue_alloc(CEC_JOB_QUEUE_SIZE, sizeof(CECJob));
+    app->worker_thread = furi_thread_alloc_ex("CECRemoteWorker", CEC_WORKER_STACK_SIZE, cec_remote_worker, app);
+    furi_thread_start(app->worker_thread);
+    
     return app;
 }
 
@@ -774,10 +2666,12 @@ static void cec_remote_app_free(CECRemoteApp* app) {
         furi_timer_free(app->cleanup_timer);
     }
     
-    // Safely cleanup UART
-    if(app->uart_initialized) {
-        cec_remote_uart_deinit(app);
-    }
+    // Stop the worker, it releases the UART on its way out
+    furi_thread_flags_set(furi_thread_get_id(app->worker_thread), CECWorkerFlagStop);
+    furi_thread_join(app->worker_thread);
+    furi_thread_free(app->worker_thread);
+    furi_message_queue_free(app->job_queue);
+    furi_mutex_free(app->result_mutex);
     
     view_dispatcher_remove_view(app->view_dispatcher, CECRemoteViewSubmenu);
     submenu_free(app->submenu);
@@ -788,12 +2682,22 @@ static void cec_remote_app_free(CECRemoteApp* app) {
     view_dispatcher_remove_view(app->view_dispatcher, CECRemoteViewPopup);
     popup_free(app->popup);
     
+    view_dispatcher_remove_view(app->view_dispatcher, CECRemoteViewResult);
+    view_free(app->result_view);
+    
+    view_dispatcher_remove_view(app->view_dispatcher, CECRemoteViewRemote);
+    view_free(app->remote_view);
+    
+    view_dispatcher_remove_view(app->view_dispatcher, CECRemoteViewDashboard);
+    view_free(app->dashboard_view);
+    
     scene_manager_free(app->scene_manager);
     view_dispatcher_free(app->view_dispatcher);
     
     furi_record_close(RECORD_NOTIFICATION);
     furi_record_close(RECORD_GUI);
     
+    free(app->profiles.record);
     free(app);
 }
 
@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+"""
+Compile and check CEC Remote vendor profile files (.cecp)
+The Flipper app keeps only the selected vendor's commands in RAM and reads
+them from an indexed binary file on the SD card. This tool builds that file
+from the Markdown definitions in profiles/vendors.md and validates files
+before they are copied to the Flipper.
+
+File layout (little endian):
+  header  "CECP" | version | vendor count | index entry size | reserved
+  index   per vendor: name (24, NUL padded) | offset (4) | length (2) | crc16 (2)
+  record  command count, then per command:
+          slot | opcode | cec length | brightsign length | recipe length |
+          cec bytes | brightsign ASCII (NUL terminated) | recipe
+The CRC (CCITT-FALSE) covers one record. Recipes use the payload format
+of the SEQUENCE request.
+
+Usage:
+  cec_profiles.py compile profiles/vendors.md -o files/vendors.cecp
+  cec_profiles.py check files/vendors.cecp [--source profiles/vendors.md]
+"""
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"CECP"
+VERSION = 1
+HEADER_SIZE = 8
+INDEX_ENTRY_SIZE = 32
+NAME_SIZE = 24
+
+MAX_VENDORS = 16
+MAX_RECORD = 1024
+MAX_DATA = 64             # CEC_REQUEST_MAX_DATA on the Flipper
+MAX_BRIGHTSIGN = 32
+
+# Menu slots, in CECCommandMenuItem order
+SLOTS = ["POWER_ON", "POWER_OFF", "HDMI_1", "HDMI_2", "HDMI_3", "HDMI_4",
+         "VOLUME_UP", "VOLUME_DOWN", "MUTE", "SCAN", "STATUS"]
+
+# CECOpcode values
+OP_SCAN = 0x02
+OP_STATUS = 0x03
+OP_POWER_ON = 0x04
+OP_POWER_OFF = 0x05
+OP_TX = 0x06
+OP_VOLUME_UP = 0x07
+OP_VOLUME_DOWN = 0x08
+OP_MUTE = 0x09
+OP_CUSTOM = 0x0A
+
+SIMPLE_VERBS = {
+    "volup": (OP_VOLUME_UP, "VOLUP"),
+    "voldown": (OP_VOLUME_DOWN, "VOLDOWN"),
+    "mute": (OP_MUTE, "MUTE"),
+    "scan": (OP_SCAN, "SCAN"),
+}
+
+UNTIL = {"none": 0, "on": 1, "standby": 2}
+UNTIL_ADAPTIVE = 0x80
+
+HEADING = re.compile(r"^###\s+(.+?)\s*$")
+OPTION = re.compile(r"(\w+)=(\S+)")
+
+
+class ProfileError(Exception):
+    pass
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, same as cec_remote_crc16_update() on the Flipper"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def parse_frame(text):
+    try:
+        frame = bytes(int(part, 16) for part in text.split(":"))
+    except ValueError:
+        raise ProfileError(f"bad CEC frame '{text}'")
+    if not frame or len(frame) > 16:
+        raise ProfileError(f"bad CEC frame '{text}'")
+    return frame
+
+
+def encode_command(text):
+    """cec-client command -> (opcode, data, BrightSign code)"""
+    parts = text.split()
+    verb, args = parts[0].lower(), parts[1:]
+    if verb == "tx" and len(args) == 1:
+        frame = parse_frame(args[0])
+        return OP_TX, frame, frame.hex().upper()
+    if verb in ("on", "standby") and len(args) == 1 and args[0].isdigit():
+        address = int(args[0])
+        opcode = OP_POWER_ON if verb == "on" else OP_POWER_OFF
+        return opcode, bytes([address]), f"{verb.upper()}_{address}"
+    if verb in SIMPLE_VERBS and not args:
+        opcode, code = SIMPLE_VERBS[verb]
+        return opcode, b"", code
+    if verb == "pow" and args == ["0"]:
+        return OP_STATUS, b"", "POW_0"
+    return OP_CUSTOM, text.encode("ascii"), ""
+
+
+def options(text):
+    return dict(OPTION.findall(text))
+
+
+def encode_recipe(header, steps):
+    """SEQUENCE payload: attempts | settle | until | address, then steps"""
+    opts = options(header)
+    until, _, address = opts.get("until", "none").partition(":")
+    if until not in UNTIL:
+        raise ProfileError(f"unknown until '{until}'")
+    if until == "none" and opts.get("adaptive", "0") not in ("0", "no"):
+        raise ProfileError("adaptive needs an until condition")
+    recipe = bytearray([
+        int(opts.get("attempts", 1)),
+        round(float(opts.get("settle", 0)) * 10),
+        UNTIL[until] | (UNTIL_ADAPTIVE if opts.get("adaptive", "0") not in ("0", "no") else 0),
+        int(address or 0),
+    ])
+    for step in steps:
+        cec, _, rest = step.partition("#")[0].strip().partition(" ")
+        parts = cec.split()
+        if parts != ["tx"]:
+            raise ProfileError(f"sequence steps must be tx frames: '{step}'")
+        words = rest.split()
+        frame = parse_frame(words[0])
+        opts = options(" ".join(words[1:]))
+        recipe += bytes([round(float(opts.get("delay", 0)) * 10), int(opts.get("retries", 0)), len(frame)]) + frame
+    if not steps:
+        raise ProfileError("sequence without steps")
+    return bytes(recipe)
+
+
+def parse_source(text):
+    """Markdown definitions -> [(vendor name, {slot: (opcode, data, brightsign, recipe)})]"""
+    vendors = []
+    current = None
+    in_block = False
+    pending = None       # (slot, header line, steps) of an open sequence
+
+    def close_sequence():
+        nonlocal pending
+        if pending:
+            slot, header, steps = pending
+            if slot not in current[1]:
+                raise ProfileError(f"{current[0]}: {slot} sequence before its command")
+            opcode, data, code, _ = current[1][slot]
+            current[1][slot] = (opcode, data, code, encode_recipe(header, steps))
+            pending = None
+
+    for number, line in enumerate(text.splitlines(), start=1):
+        try:
+            heading = HEADING.match(line)
+            if heading and not in_block:
+                current = (heading.group(1), {})
+                vendors.append(current)
+                continue
+            if line.strip().startswith("```"):
+                if in_block:
+                    close_sequence()
+                in_block = not in_block
+                continue
+            if not in_block or current is None or not line.strip():
+                continue
+
+            if line[0].isspace():
+                if not pending:
+                    raise ProfileError("indented line outside a sequence")
+                pending[2].append(line.strip())
+                continue
+
+            close_sequence()
+            slot, _, command = line.partition("#")[0].strip().partition(" ")
+            command = command.strip()
+            if slot not in SLOTS:
+                raise ProfileError(f"unknown command slot '{slot}'")
+            if command.startswith("sequence"):
+                pending = (slot, command, [])
+            elif slot in current[1]:
+                raise ProfileError(f"duplicate {slot}")
+            else:
+                current[1][slot] = encode_command(command) + (b"",)
+        except (ProfileError, ValueError) as e:
+            raise ProfileError(f"line {number}: {e}")
+    return [vendor for vendor in vendors if vendor[1]]
+
+
+def encode_record(commands):
+    record = bytearray([len(commands)])
+    for slot, (opcode, data, code, recipe) in sorted(commands.items(), key=lambda item: SLOTS.index(item[0])):
+        brightsign = code.encode("ascii") + b"\0"
+        if len(data) > MAX_DATA or len(recipe) > MAX_DATA or len(brightsign) > MAX_BRIGHTSIGN:
+            raise ProfileError(f"{slot} is too long")
+        record += bytes([SLOTS.index(slot), opcode, len(data), len(brightsign), len(recipe)])
+        record += data + brightsign + recipe
+    if len(record) > MAX_RECORD:
+        raise ProfileError("vendor record too large")
+    return bytes(record)
+
+
+def compile_profiles(vendors):
+    if not vendors:
+        raise ProfileError("no vendors defined")
+    if len(vendors) > MAX_VENDORS:
+        raise ProfileError(f"too many vendors (max {MAX_VENDORS})")
+
+    records = [encode_record(commands) for _, commands in vendors]
+    offset = HEADER_SIZE + INDEX_ENTRY_SIZE * len(vendors)
+    out = bytearray(MAGIC + bytes([VERSION, len(vendors), INDEX_ENTRY_SIZE, 0]))
+    for (name, _), record in zip(vendors, records):
+        encoded = name.encode("utf-8")
+        if len(encoded) >= NAME_SIZE:
+            raise ProfileError(f"vendor name too long: {name}")
+        out += encoded.ljust(NAME_SIZE, b"\0") + struct.pack("<IHH", offset, len(record), crc16(record))
+        offset += len(record)
+    for record in records:
+        out += record
+    return bytes(out)
+
+
+def check_record(name, record):
+    """Walk one record exactly as the Flipper loader does"""
+    count = record[0]
+    pos = 1
+    slots = set()
+    for _ in range(count):
+        if pos + 5 > len(record):
+            raise ProfileError(f"{name}: truncated command")
+        slot, opcode, data_length, code_length, recipe_length = record[pos:pos + 5]
+        pos += 5
+        end = pos + data_length + code_length + recipe_length
+        if slot >= len(SLOTS) or slot in slots:
+            raise ProfileError(f"{name}: bad or duplicate slot {slot}")
+        if end > len(record) or data_length > MAX_DATA or recipe_length > MAX_DATA:
+            raise ProfileError(f"{name}: {SLOTS[slot]} overruns the record")
+        if code_length == 0 or code_length > MAX_BRIGHTSIGN or record[pos + data_length + code_length - 1] != 0:
+            raise ProfileError(f"{name}: {SLOTS[slot]} BrightSign code not terminated")
+        if opcode == 0:
+            raise ProfileError(f"{name}: {SLOTS[slot]} has no opcode")
+        slots.add(slot)
+        pos = end
+    if pos != len(record):
+        raise ProfileError(f"{name}: {len(record) - pos} trailing bytes")
+    return [SLOTS[slot] for slot in sorted(slots)]
+
+
+def check_profiles(data):
+    """Validate header, index and every record; returns [(name, slots)]"""
+    if len(data) < HEADER_SIZE or data[:4] != MAGIC:
+        raise ProfileError("not a CECP file")
+    version, count, entry_size = data[4], data[5], data[6]
+    if version != VERSION or entry_size != INDEX_ENTRY_SIZE:
+        raise ProfileError(f"unsupported version {version} / entry size {entry_size}")
+    if count == 0 or count > MAX_VENDORS:
+        raise ProfileError(f"bad vendor count {count}")
+    records_start = HEADER_SIZE + INDEX_ENTRY_SIZE * count
+    if len(data) < records_start:
+        raise ProfileError("truncated index")
+
+    vendors = []
+    expected_offset = records_start
+    for i in range(count):
+        entry = data[HEADER_SIZE + i * INDEX_ENTRY_SIZE:HEADER_SIZE + (i + 1) * INDEX_ENTRY_SIZE]
+        raw_name = entry[:NAME_SIZE]
+        if b"\0" not in raw_name:
+            raise ProfileError(f"vendor {i}: name not terminated")
+        name = raw_name.split(b"\0", 1)[0].decode("utf-8")
+        offset, length, crc = struct.unpack("<IHH", entry[NAME_SIZE:])
+        if offset != expected_offset or length == 0 or length > MAX_RECORD or offset + length > len(data):
+            raise ProfileError(f"{name}: index points outside the records ({offset}+{length})")
+        record = data[offset:offset + length]
+        if crc16(record) != crc:
+            raise ProfileError(f"{name}: CRC mismatch")
+        vendors.append((name, check_record(name, record)))
+        expected_offset = offset + length
+    if expected_offset != len(data):
+        raise ProfileError(f"{len(data) - expected_offset} unindexed bytes at end of file")
+    return vendors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    sub = parser.add_subparsers(dest="action", required=True)
+    compile_parser = sub.add_parser("compile", help="build a .cecp file from Markdown definitions")
+    compile_parser.add_argument("source")
+    compile_parser.add_argument("-o", "--output", required=True)
+    check_parser = sub.add_parser("check", help="validate a .cecp file")
+    check_parser.add_argument("profile")
+    check_parser.add_argument("--source", help="also require the file to match these definitions")
+    args = parser.parse_args()
+
+    try:
+        if args.action == "compile":
+            with open(args.source, encoding="utf-8") as f:
+                data = compile_profiles(parse_source(f.read()))
+            check_profiles(data)
+            with open(args.output, "wb") as f:
+                f.write(data)
+            print(f"{args.output}: {len(data)} bytes")
+            return 0
+
+        with open(args.profile, "rb") as f:
+            data = f.read()
+        for name, slots in check_profiles(data):
+            print(f"{name:<24} {len(slots):2} commands")
+        if args.source:
+            with open(args.source, encoding="utf-8") as f:
+                if compile_profiles(parse_source(f.read())) != data:
+                    raise ProfileError(f"{args.profile} is out of date with {args.source}")
+        print(f"{args.profile}: OK ({len(data)} bytes)")
+        return 0
+    except ProfileError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,186 @@
+// Host microbenchmarks for the protocol core (../cec_protocol.c)
+// Reports throughput and per-message cost of the paths the worker runs for
+// every byte or request: frame decoding, JSON reply scanning, CRC, frame
+// encoding and JSON request building. Build with `make bench`.
+//
+//   ./protocol_bench [-t seconds per case]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cec_protocol.h"
+
+#define STREAM_SIZE (64 * 1024)
+
+static volatile uint32_t sink;  // Keeps results alive so nothing is optimised away
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Repeat fn until seconds have passed; returns runs per second
+static double measure(void (*fn)(void* context), void* context, double seconds) {
+    fn(context);  // Warm up caches
+    uint32_t runs = 0;
+    double start = now();
+    double elapsed;
+    do {
+        fn(context);
+        runs++;
+        elapsed = now() - start;
+    } while(elapsed < seconds);
+    return runs / elapsed;
+}
+
+static void report(const char* name, double runs_per_second, size_t bytes, size_t messages, const char* unit) {
+    if(bytes) {
+        printf("%-26s %8.1f MB/s", name, runs_per_second * bytes / 1e6);
+    } else {
+        printf("%-26s %13s", name, "");
+    }
+    printf("  %8.1f ns/%s\n", 1e9 / (runs_per_second * messages), unit);
+}
+
+// A byte stream as the Pi sends it: result frames with text of one size
+typedef struct {
+    uint8_t data[STREAM_SIZE];
+    size_t length;
+    size_t messages;
+} CECStream;
+
+static void stream_frames(CECStream* stream, size_t text_length) {
+    uint8_t payload[CEC_FRAME_MAX_PAYLOAD];
+    payload[0] = CECStatusOk;
+    for(size_t i = 1; i <= text_length; i++) {
+        payload[i] = (i % 40 == 0) ? '\n' : 'a' + i % 26;
+    }
+    stream->length = 0;
+    stream->messages = 0;
+    for(;;) {
+        size_t size = cec_protocol_frame_encode(
+            CECOpResult,
+            stream->messages & 0xFF,
+            payload,
+            text_length + 1,
+            &stream->data[stream->length],
+            sizeof(stream->data) - stream->length);
+        if(size == 0) {
+            break;
+        }
+        stream->length += size;
+        stream->messages++;
+    }
+}
+
+static void stream_json(CECStream* stream, const char* line) {
+    size_t line_length = strlen(line);
+    stream->length = 0;
+    stream->messages = 0;
+    while(stream->length + line_length <= sizeof(stream->data)) {
+        memcpy(&stream->data[stream->length], line, line_length);
+        stream->length += line_length;
+        stream->messages++;
+    }
+}
+
+static void run_frame_decode(void* context) {
+    const CECStream* stream = context;
+    CECFrameDecoder decoder = {0};
+    uint32_t complete = 0;
+    for(size_t i = 0; i < stream->length; i++) {
+        complete += cec_protocol_frame_decoder_feed(&decoder, stream->data[i]) == CECFrameEventComplete;
+    }
+    sink += complete;
+}
+
+static void run_json_scan(void* context) {
+    const CECStream* stream = context;
+    CECJsonScanner json;
+    cec_protocol_json_reset(&json);
+    char text[4];
+    size_t text_length;
+    uint32_t total = 0;
+    for(size_t i = 0; i < stream->length; i++) {
+        if(cec_protocol_json_feed(&json, stream->data[i], text, &text_length)) {
+            total += json.id + json.status_success;
+            cec_protocol_json_reset(&json);
+        }
+        total += text_length;
+    }
+    sink += total;
+}
+
+static void run_crc(void* context) {
+    const CECStream* stream = context;
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < stream->length; i++) {
+        crc = cec_protocol_crc16_update(crc, stream->data[i]);
+    }
+    sink += crc;
+}
+
+static void run_frame_encode(void* context) {
+    const CECRequest* request = context;
+    uint8_t frame[CEC_REQUEST_MAX_DATA + CEC_FRAME_OVERHEAD];
+    for(uint32_t seq = 0; seq < 256; seq++) {
+        sink += cec_protocol_frame_encode(request->opcode, seq, request->data, request->length, frame, sizeof(frame));
+    }
+}
+
+static void run_build_json(void* context) {
+    const CECRequest* request = context;
+    char buffer[CEC_REQUEST_MAX_DATA * 3 + 80];
+    for(uint32_t seq = 0; seq < 256; seq++) {
+        cec_protocol_build_json(request, seq, buffer, sizeof(buffer));
+        sink += (uint8_t)buffer[10];
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.5;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-t seconds per case]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static CECStream stream;
+    static const size_t text_lengths[] = {16, 128, CEC_FRAME_MAX_PAYLOAD - 1};
+    char name[32];
+
+    for(size_t i = 0; i < sizeof(text_lengths) / sizeof(text_lengths[0]); i++) {
+        stream_frames(&stream, text_lengths[i]);
+        snprintf(name, sizeof(name), "frame decode %zu B text", text_lengths[i]);
+        report(name, measure(run_frame_decode, &stream, seconds), stream.length, stream.messages, "frame");
+    }
+
+    // As json.dumps() writes them: emoji as \u escapes, ", " and ": " separators
+    stream_json(
+        &stream,
+        "{\"status\": \"success\", \"result\": \"\\u2705 Command executed: tx 4F:82:10:00\", \"id\": 12}\n");
+    report("json scan short reply", measure(run_json_scan, &stream, seconds), stream.length, stream.messages, "line");
+    stream_json(
+        &stream,
+        "{\"status\": \"success\", \"result\": \"\\ud83d\\udd0d 2 devices (0 queried) in 79 ms\\n"
+        "#0 TV (Samsung) - standby\\n#1 CECTester (Pulse Eight) - on\\n#4 Playback 1 (Sony) - on\\n"
+        "#5 Audio (Denon) - standby\\n#8 Playback 2 (Apple) - on\\n#11 Tuner (LG) - standby\", "
+        "\"partial\": false, \"id\": 201}\n");
+    report("json scan scan reply", measure(run_json_scan, &stream, seconds), stream.length, stream.messages, "line");
+
+    stream_frames(&stream, 128);
+    report("crc16", measure(run_crc, &stream, seconds), stream.length, stream.length, "byte");
+
+    CECRequest tx = {.opcode = CECOpTx, .length = 4, .data = {0x4F, 0x82, 0x10, 0x00}};
+    report("frame encode tx request", measure(run_frame_encode, &tx, seconds), 0, 256, "frame");
+    report("build json tx request", measure(run_build_json, &tx, seconds), 0, 256, "line");
+    return 0;
+}
@@ -0,0 +1,271 @@
+// Fuzz target for the protocol core (../cec_protocol.c)
+// Every input is fed, byte by byte, to the frame decoder and to the JSON
+// reply scanner the way the worker feeds UART bytes, parsed as an event
+// payload, and its first bytes are turned into a request that must survive
+// frame encode/decode and JSON building, and whose JSON line must read back
+// with its id even behind nested fields of the same names. Broken invariants
+// abort, so the sanitizers and the fuzzer report them like crashes.
+//
+//   make fuzz && ./protocol_fuzz corpus/    libFuzzer (clang)
+//   make fuzz-standalone && ./protocol_fuzz_standalone -runs=100000 [-seed=1] [files...]
+//
+// The standalone build needs no libFuzzer: it runs the given files, then
+// generated inputs mixing valid frames, JSON reply lines and corruption.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cec_protocol.h"
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if(!(condition)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort();                                                              \
+        }                                                                         \
+    } while(0)
+
+static void fuzz_frame_decoder(const uint8_t* data, size_t size) {
+    CECFrameDecoder decoder = {0};
+    bool in_frame = false;
+    for(size_t i = 0; i < size; i++) {
+        CECFrameEvent event = cec_protocol_frame_decoder_feed(&decoder, data[i]);
+        switch(event) {
+        case CECFrameEventHeader:
+            in_frame = true;
+            break;
+        case CECFrameEventPayload:
+            CHECK(in_frame);
+            CHECK(decoder.payload_length >= 1 && decoder.payload_length <= CEC_FRAME_MAX_PAYLOAD);
+            break;
+        case CECFrameEventComplete:
+        case CECFrameEventCrcError:
+            CHECK(in_frame);
+            CHECK(decoder.payload_length + 2u == decoder.length);
+            in_frame = false;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void fuzz_json_scanner(const uint8_t* data, size_t size) {
+    CECJsonScanner json;
+    cec_protocol_json_reset(&json);
+    for(size_t i = 0; i < size; i++) {
+        char text[4];
+        size_t text_length = 99;
+        bool line = cec_protocol_json_feed(&json, data[i], text, &text_length);
+        CHECK(text_length <= sizeof(text));
+        CHECK(json.key_length < sizeof(json.key) && json.value_length < sizeof(json.value));
+        if(line) {
+            CHECK(data[i] == '\n' || data[i] == '\r');
+            cec_protocol_json_reset(&json);
+        }
+    }
+}
+
+static void fuzz_request(const uint8_t* data, size_t size) {
+    if(size < 2) {
+        return;
+    }
+    CECRequest request = {.opcode = data[0], .length = data[1] % (CEC_REQUEST_MAX_DATA + 1)};
+    size_t available = size - 2 < request.length ? size - 2 : request.length;
+    memcpy(request.data, &data[2], available);
+    request.length = available;
+    uint8_t seq = size > 2 ? data[size - 1] : 0;
+
+    // Same buffer size as cec_remote_link_submit(), with a guard behind it
+    char json[CEC_REQUEST_MAX_DATA * 3 + 80 + 8];
+    memset(json, 0x5A, sizeof(json));
+    cec_protocol_build_json(&request, seq, json, sizeof(json) - 8);
+    CHECK(memchr(json, '\0', sizeof(json) - 8) != NULL);
+    for(size_t i = sizeof(json) - 8; i < sizeof(json); i++) {
+        CHECK(json[i] == 0x5A);
+    }
+
+    // The line as the Pi's reply scanner reads it, after nested fields that must not count
+    char nested[96];
+    snprintf(
+        nested,
+        sizeof(nested),
+        "{\"state\":{\"status\":\"error\",\"id\":%u,\"partial\":true,\"list\":[\"}\\\"]\",{\"id\":1}]},",
+        (uint8_t)(seq + 1));
+    CHECK(json[0] == '{');
+    CECJsonScanner scanner;
+    cec_protocol_json_reset(&scanner);
+    char text[4];
+    size_t text_length;
+    for(const char* c = nested; *c; c++) {
+        cec_protocol_json_feed(&scanner, *c, text, &text_length);
+    }
+    for(const char* c = json + 1; *c; c++) {
+        cec_protocol_json_feed(&scanner, *c, text, &text_length);
+    }
+    CHECK(cec_protocol_json_feed(&scanner, '\n', text, &text_length));
+    CHECK(scanner.id == seq && !scanner.has_status && !scanner.partial);
+
+    uint8_t frame[CEC_REQUEST_MAX_DATA + CEC_FRAME_OVERHEAD];
+    size_t frame_size =
+        cec_protocol_frame_encode(request.opcode, seq, request.data, request.length, frame, sizeof(frame));
+    CHECK(frame_size == (size_t)request.length + CEC_FRAME_OVERHEAD);
+
+    CECFrameDecoder decoder = {0};
+    uint8_t payload[CEC_REQUEST_MAX_DATA];
+    size_t complete = 0;
+    for(size_t i = 0; i < frame_size; i++) {
+        CECFrameEvent event = cec_protocol_frame_decoder_feed(&decoder, frame[i]);
+        if(event == CECFrameEventPayload) {
+            payload[decoder.payload_length - 1] = frame[i];
+        }
+        CHECK(event != CECFrameEventCrcError);
+        complete += event == CECFrameEventComplete;
+    }
+    CHECK(complete == 1);
+    CHECK(decoder.opcode == request.opcode && decoder.seq == seq);
+    CHECK(decoder.payload_length == request.length);
+    CHECK(memcmp(payload, request.data, request.length) == 0);
+}
+
+static void fuzz_event(const uint8_t* data, size_t size) {
+    CECEvent event;
+    memset(&event, 0x5A, sizeof(event));
+    if(cec_protocol_event_parse(data, size, &event)) {
+        CHECK(event.logical <= 0x0F);
+        CHECK(memchr(event.name, '\0', sizeof(event.name)) != NULL);
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_frame_decoder(data, size);
+    fuzz_event(data, size);
+    fuzz_json_scanner(data, size);
+    fuzz_request(data, size);
+    return 0;
+}
+
+#ifdef CEC_FUZZ_STANDALONE
+
+#define INPUT_MAX 4096
+
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static const char* const json_pieces[] = {
+    "{\"status\": \"success\", \"result\": \"",
+    "{\"status\":\"error\",\"result\":\"",
+    "\", \"id\": ",
+    "\", \"partial\": true, \"id\": ",
+    ", \"proto\": 3}",
+    "\\u2705 ",
+    "\\u274c ",
+    "\\ud83d\\udd0d",
+    "\\udc00",
+    "\\ud83d",
+    "\\n",
+    "\\\"",
+    "\\",
+    "\\u12",
+    "Command executed: tx 4F:82:10:00",
+    "\"averyveryverylongkeyname\": \"averyveryverylongvalue\"",
+    "}\n",
+    "\n",
+    "\r\n",
+};
+
+// Valid frames, JSON fragments and random bytes, then a few mutations
+static size_t generate(uint8_t* out) {
+    size_t length = 0;
+    size_t parts = 1 + rng() % 8;
+    for(size_t part = 0; part < parts && length < INPUT_MAX - CEC_FRAME_MAX_PAYLOAD - 16; part++) {
+        switch(rng() % 3) {
+        case 0: {
+            uint8_t payload[CEC_FRAME_MAX_PAYLOAD];
+            size_t payload_length = rng() % (CEC_FRAME_MAX_PAYLOAD + 1);
+            for(size_t i = 0; i < payload_length; i++) {
+                payload[i] = rng();
+            }
+            uint8_t opcode = (rng() & 1) ? CECOpResult : CECOpResultPart;
+            length += cec_protocol_frame_encode(
+                opcode, rng(), payload, payload_length, &out[length], INPUT_MAX - length);
+            break;
+        }
+        case 1: {
+            size_t pieces = 1 + rng() % 12;
+            for(size_t i = 0; i < pieces; i++) {
+                const char* piece = json_pieces[rng() % (sizeof(json_pieces) / sizeof(json_pieces[0]))];
+                size_t piece_length = strlen(piece);
+                if(length + piece_length >= INPUT_MAX - CEC_FRAME_MAX_PAYLOAD - 16) {
+                    break;
+                }
+                memcpy(&out[length], piece, piece_length);
+                length += piece_length;
+            }
+            break;
+        }
+        default: {
+            size_t count = rng() % 64;
+            for(size_t i = 0; i < count; i++) {
+                out[length++] = rng();
+            }
+            break;
+        }
+        }
+    }
+    size_t mutations = rng() % 4;
+    for(size_t i = 0; i < mutations && length > 0; i++) {
+        size_t at = rng() % length;
+        switch(rng() % 3) {
+        case 0:
+            out[at] ^= 1 << (rng() % 8);
+            break;
+        case 1:
+            out[at] = (rng() & 1) ? CEC_FRAME_SYNC : '\n';
+            break;
+        default:
+            length = at;
+            break;
+        }
+    }
+    return length;
+}
+
+int main(int argc, char** argv) {
+    unsigned long runs = 10000;
+    rng_state = 1;
+    static uint8_t input[INPUT_MAX];
+
+    for(int i = 1; i < argc; i++) {
+        if(strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = strtoul(argv[i] + 6, NULL, 10);
+        } else if(strncmp(argv[i], "-seed=", 6) == 0) {
+            rng_state = strtoul(argv[i] + 6, NULL, 10) | 1;
+        } else {
+            FILE* file = fopen(argv[i], "rb");
+            if(!file) {
+                perror(argv[i]);
+                return 2;
+            }
+            size_t size = fread(input, 1, sizeof(input), file);
+            fclose(file);
+            LLVMFuzzerTestOneInput(input, size);
+        }
+    }
+
+    for(unsigned long run = 0; run < runs; run++) {
+        LLVMFuzzerTestOneInput(input, generate(input));
+    }
+    printf("%lu generated inputs passed\n", runs);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Several CEC adapters on one Pi
+A site with several displays gives each its own USB-CEC adapter (or kernel
+CEC device). CEC_ADAPTERS lists them as name=backend[:device], comma
+separated, first one first:
+
+  CEC_ADAPTERS="lobby=kernel:/dev/cec0,bar=cec-client:/dev/ttyACM0,stage=cec-client:/dev/ttyACM1"
+
+The device is the kernel device, the cec-client port or, for the fake
+backend, the name of the fake bus's TV. Every adapter has its own backend
+and its own scheduler worker, so commands to different buses run at the
+same time. The first adapter is the shared backend and scheduler the rest
+of the daemon uses: bus state, events, discovery, sequences and held keys
+stay on it. Without CEC_ADAPTERS there is one adapter, main, and nothing
+changes. An adapter that does not open fails only the commands sent to it;
+the first one is tried again on every request until it opens, and the bus
+state starts listening to it then.
+
+CEC_ADAPTER_GROUPS names sets of adapters, e.g. "front=lobby+bar;back=stage".
+A request's "adapter" field picks a target: an adapter, a group, "all", or
+a list of names. Requests without one go to CEC_DEFAULT_TARGET, the first
+adapter unless set.
+"""
+import os
+import threading
+import logging
+from bus_state import get_bus_state
+from cec_backend import adapter_specs, open_backend, CECBackendError
+from scheduler import CommandScheduler, get_scheduler, CONTROL_VERBS
+
+logger = logging.getLogger("adapters")
+
+CEC_ADAPTER_GROUPS = os.environ.get("CEC_ADAPTER_GROUPS", "")
+CEC_DEFAULT_TARGET = os.environ.get("CEC_DEFAULT_TARGET", "")
+
+ALL = "all"
+
+
+class AdapterError(CECBackendError):
+    """Raised for a target that names no adapter"""
+
+
+class Adapter:
+    """One CEC bus: a name, its backend and the scheduler in front of it"""
+    def __init__(self, name, scheduler=None, error=None):
+        self.name = name
+        self.scheduler = scheduler
+        self.backend = scheduler.backend if scheduler else None
+        # Why the backend did not open; such an adapter fails every command sent to it
+        self.error = error
+
+
+class AdapterSet:
+    def __init__(self, adapters, groups=None, default=None):
+        self.adapters = adapters
+        self.by_name = {adapter.name: adapter for adapter in adapters}
+        if len(self.by_name) != len(adapters):
+            raise AdapterError("Adapter names must be unique")
+        self.groups = groups or {}
+        for group, names in self.groups.items():
+            unknown = [name for name in names if name not in self.by_name]
+            if unknown:
+                raise AdapterError(f"Group '{group}' names unknown adapters: {', '.join(unknown)}")
+        self.default = default or adapters[0].name
+        try:
+            self.resolve(self.default)
+        except AdapterError as e:
+            logger.error(f"❌ Default target: {e}, using {adapters[0].name}")
+            self.default = adapters[0].name
+
+    @property
+    def primary(self):
+        return self.adapters[0]
+
+    def resolve(self, target=None):
+        """The adapters a request's target stands for, in CEC_ADAPTERS order"""
+        if target is None or target == "":
+            target = self.default
+        names = target if isinstance(target, (list, tuple)) else [target]
+        chosen = set()
+        for name in names:
+            name = str(name)
+            if name == ALL:
+                chosen.update(self.by_name)
+            elif name in self.groups:
+                chosen.update(self.groups[name])
+            elif name in self.by_name:
+                chosen.add(name)
+            else:
+                raise AdapterError(f"Unknown adapter '{name}', have {', '.join(self.names())}")
+        return [adapter for adapter in self.adapters if adapter.name in chosen]
+
+    def names(self):
+        return [adapter.name for adapter in self.adapters] + list(self.groups) + [ALL]
+
+    def run(self, adapters, command, timeout=10):
+        """Run command on every adapter at once; [(name, success, output)] in adapter order"""
+        # Queue on every worker before waiting on any, so the buses work in parallel
+        jobs = []
+        for adapter in adapters:
+            if adapter.scheduler is None:
+                jobs.append((adapter, None, adapter.error))
+                continue
+            try:
+                jobs.append((adapter, adapter.scheduler.submit(command, timeout), None))
+            except Exception as e:
+                jobs.append((adapter, None, e))
+        results = []
+        for adapter, job, error in jobs:
+            if error is None:
+                try:
+                    success, output = adapter.scheduler.wait(job, timeout)
+                except Exception as e:
+                    error = e
+            if error is not None:
+                success, output = False, str(error) or type(error).__name__
+            results.append((adapter.name, success, output))
+        return results
+
+    def to_dict(self):
+        return {adapter.name: {"backend": adapter.scheduler.name, "scheduler": adapter.scheduler.to_dict()}
+                if adapter.scheduler else {"error": str(adapter.error)} for adapter in self.adapters}
+
+    def stop(self):
+        """Stop the adapters of their own; the first one goes with the shared scheduler"""
+        for adapter in self.adapters[1:]:
+            if adapter.scheduler:
+                adapter.scheduler.stop()
+                adapter.backend.stop()
+
+
+def summarize(command, success, output):
+    """One display's share of a fanned-out result"""
+    text = output.strip()
+    verb = command.split(" ", 1)[0].lower()
+    if success and verb in CONTROL_VERBS or not text:
+        return command
+    if not success:
+        # cec-client's last word is the one that says what went wrong
+        return text.splitlines()[-1]
+    return text
+
+
+def format_results(command, results):
+    """Response dict for a fanned-out command: a count, then one entry per display"""
+    succeeded = sum(1 for _, success, _ in results if success)
+    lines = [f"{'✅' if succeeded == len(results) else '❌'} {command}: {succeeded}/{len(results)} displays"]
+    displays = {}
+    for name, success, output in results:
+        text = summarize(command, success, output)
+        separator = "\n" if "\n" in text else " "
+        lines.append(f"{'✅' if success else '❌'} {name}:{separator}{text}")
+        displays[name] = {"status": "success" if success else "error", "result": output}
+    return {"status": "success" if succeeded == len(results) else "error", "result": "\n".join(lines),
+            "displays": displays}
+
+
+def parse_groups(text):
+    """{group: [adapter names]} from "front=lobby+bar;back=stage" """
+    groups = {}
+    for entry in filter(None, (part.strip() for part in text.split(";"))):
+        name, _, members = entry.partition("=")
+        names = [member.strip() for member in members.split("+") if member.strip()]
+        if not name.strip() or not names:
+            raise AdapterError(f"Bad CEC_ADAPTER_GROUPS entry '{entry}', expected group=adapter+adapter")
+        groups[name.strip()] = names
+    return groups
+
+
+_adapters = None
+_adapters_lock = threading.Lock()
+
+
+def open_adapter(name, open_scheduler, quiet=False):
+    """Adapter for name, or one that carries the error when its backend does not open"""
+    try:
+        return Adapter(name, open_scheduler())
+    except (OSError, CECBackendError) as e:
+        # An unplugged adapter should not take the other displays down with it
+        if not quiet:
+            logger.error(f"❌ CEC adapter {name} did not open: {e}")
+        return Adapter(name, error=f"❌ Adapter did not open: {e}")
+
+
+def get_adapters():
+    """Every configured adapter, the first one sharing get_backend() and get_scheduler()"""
+    global _adapters
+    with _adapters_lock:
+        if _adapters is None:
+            specs = adapter_specs()
+            adapters = [open_adapter(specs[0][0], get_scheduler)]
+            for name, kind, device in specs[1:]:
+                adapters.append(open_adapter(name, lambda: CommandScheduler(open_backend(kind, device))))
+            _adapters = AdapterSet(adapters, parse_groups(CEC_ADAPTER_GROUPS), CEC_DEFAULT_TARGET)
+            if len(adapters) > 1:
+                logger.info(f"🖥️ {len(adapters)} CEC adapters: " +
+                            ", ".join(f"{a.name} ({a.scheduler.name if a.scheduler else a.error})"
+                                      for a in adapters))
+        elif _adapters.primary.scheduler is None:
+            # The shared backend opens lazily, e.g. once a late USB adapter shows up
+            primary = open_adapter(_adapters.primary.name, get_scheduler, quiet=True)
+            if primary.scheduler:
+                logger.info(f"✅ CEC adapter {primary.name} opened")
+                _adapters.adapters[0] = _adapters.by_name[primary.name] = primary
+                # The bus state could not listen to it at startup
+                get_bus_state()
+        return _adapters
+
+
+def stop_adapters():
+    global _adapters
+    with _adapters_lock:
+        if _adapters is not None:
+            _adapters.stop()
+            _adapters = None
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""
+UART rate negotiation, Pi side
+The link always starts at 115200. After PING the Flipper may propose a
+higher rate with OP_BAUD:
+  1. BAUD_PROPOSE rate   answered at the current rate, then the Pi switches
+  2. BAUD_VERIFY pattern sent by the Flipper at the new rate; the Pi echoes
+                         the pattern and the new rate becomes the good one
+If no verify arrives within VERIFY_TIMEOUT the Pi goes back to the rate it
+came from. Once switched, line noise (CRC errors, bytes that are neither a
+frame nor JSON) past ERROR_LIMIT within ERROR_WINDOW means the two ends no
+longer agree, e.g. because the Flipper app restarted at 115200, and the Pi
+falls back to DEFAULT_RATE.
+
+The class only keeps state and calls set_rate(rate); the caller owns the
+port and the clock, so the same state machine runs on a pty in the tools.
+"""
+import logging
+import time
+
+logger = logging.getLogger("baud_rate")
+
+DEFAULT_RATE = 115200
+RATES = (115200, 230400, 460800, 921600)
+VERIFY_TIMEOUT = 1.0       # seconds from switching until BAUD_VERIFY must arrive
+ERROR_LIMIT = 4            # noise events that trigger a fallback ...
+ERROR_WINDOW = 2.0         # ... within this many seconds
+
+
+class BaudRate:
+    def __init__(self, set_rate, clock=time.monotonic):
+        self.set_rate = set_rate
+        self.clock = clock
+        self.rate = DEFAULT_RATE
+        self.good = DEFAULT_RATE       # Last rate a verify succeeded at
+        self.previous = None           # Rate to return to while a switch is unverified
+        self.deadline = None
+        self.errors = []               # Times of recent noise events
+
+    def _apply(self, rate, reason):
+        if rate != self.rate:
+            logger.info(f"⚡ UART {self.rate} -> {rate} baud ({reason})")
+            self.set_rate(rate)
+            self.rate = rate
+        self.errors = []
+
+    def propose(self, rate):
+        """Check a proposed rate; returns (ok, text) for the reply sent before switching"""
+        if rate not in RATES:
+            return False, f"❌ Unsupported baud rate {rate}"
+        if self.deadline is not None:
+            return False, "❌ Baud switch already pending"
+        return True, f"⚡ Switching to {rate} baud"
+
+    def switch(self, rate):
+        """The propose reply is on the wire; move to rate and wait for the verify"""
+        self.previous = self.rate
+        self.deadline = self.clock() + VERIFY_TIMEOUT
+        self._apply(rate, "proposed")
+
+    def verify(self, rate):
+        """BAUD_VERIFY arrived intact at rate; returns whether it commits"""
+        if rate != self.rate:
+            return False
+        self.good = rate
+        self.previous = None
+        self.deadline = None
+        logger.info(f"✅ UART verified at {rate} baud")
+        return True
+
+    def timeout(self):
+        """Seconds until poll() has something to do, None while idle"""
+        if self.deadline is None:
+            return None
+        return max(0.0, self.deadline - self.clock())
+
+    def poll(self):
+        """Go back to the previous rate if the switch was never verified"""
+        if self.deadline is not None and self.clock() >= self.deadline:
+            rate = self.previous
+            self.previous = None
+            self.deadline = None
+            self._apply(rate, "not verified")
+            self.good = rate
+
+    def note_errors(self, count):
+        """count noise events just seen on the line"""
+        if count <= 0 or self.rate == DEFAULT_RATE:
+            return
+        now = self.clock()
+        self.errors = [t for t in self.errors if now - t < ERROR_WINDOW] + [now] * count
+        if len(self.errors) >= ERROR_LIMIT:
+            self.previous = None
+            self.deadline = None
+            self._apply(DEFAULT_RATE, f"{len(self.errors)} errors")
+            self.good = DEFAULT_RATE
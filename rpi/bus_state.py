@@ -0,0 +1,321 @@
+#!/usr/bin/env python3
+"""
+Live CEC bus state from passive monitoring
+Every traffic line the backend reports goes through on_line(), and what
+devices announce or answer is kept per logical address:
+  0x90 Report Power Status       power
+  0x82 Active Source             active source and its physical address, power on
+  0x80 Routing Change,
+  0x86 Set Stream Path           active path; the device there is the source
+  0x9D Inactive Source           no active source
+  0x47 Set OSD Name              name
+  0x87 Device Vendor ID          vendor
+  0x84 Report Physical Address   physical address
+  0x36 Standby                   power standby, of one device or (broadcast) all
+Standby, Image View On and Text View On sent by the Pi only mark the
+target's power stale: whether it obeyed is not seen on the bus.
+
+STATUS and pow/ven/name queries are answered from the table when the
+field is known and younger than MAX_AGE; a refresh goes to the bus and
+the answer lands in the table on its way back. Adapters pass on
+broadcasts and frames addressed to the Pi, which covers all of the above
+except replies other devices get to their own queries.
+
+Watchers get (event type, logical address, value) with the OP_EVENT types
+of uart_protocol: power changes, devices appearing (or being renamed) and
+disappearing, and changes of the active source. Devices appear with their
+first frame and disappear on a hot plug or when a poll goes unanswered
+(note_present()). Watchers run on the thread that saw the traffic.
+"""
+import os
+import re
+import threading
+import time
+import logging
+from cec_backend import (LOGICAL_NAMES, POWER_NAMES, VENDOR_NAMES, BROADCAST, OP_IMAGE_VIEW_ON, OP_TEXT_VIEW_ON,
+                         OP_STANDBY, OP_SET_OSD_NAME, OP_ACTIVE_SOURCE, OP_REPORT_PHYSICAL_ADDRESS,
+                         OP_DEVICE_VENDOR_ID, OP_REPORT_POWER_STATUS, OP_INACTIVE_SOURCE, get_backend)
+from device_cache import HOTPLUG_PATTERN, format_physical
+from discovery import NAME_PATTERN, POWER_PATTERN, VENDOR_PATTERN
+from uart_protocol import EVENT_POWER, EVENT_SOURCE, EVENT_DEVICE, EVENT_GONE, EVENT_NO_DEVICE
+
+logger = logging.getLogger("bus_state")
+
+# Seconds a field is trusted without fresh traffic; power is rarely reported unasked
+MAX_AGE = float(os.environ.get("CEC_STATE_MAX_AGE", "300"))
+
+OP_ROUTING_CHANGE = 0x80
+OP_SET_STREAM_PATH = 0x86
+
+POWER_CODES = {name: code for code, name in POWER_NAMES.items()}
+
+# "TRAFFIC: [  1234]\t<< 4f:82:10:00", both directions
+FRAME_PATTERN = re.compile(r"(<<|>>)\s+([0-9a-fA-F]{2}(?::[0-9a-fA-F]{2})*)")
+
+# Query verbs answered from the table: verb -> (field, reply as cec-client prints it, pattern reading it back)
+QUERIES = {
+    "pow": ("power", lambda logical, value: f"power status: {value}", POWER_PATTERN),
+    "ven": ("vendor", lambda logical, value: f"vendor id: {value}", VENDOR_PATTERN),
+    "name": ("name", lambda logical, value: f"osd name of device {logical:x} is '{value}'", NAME_PATTERN),
+}
+
+
+class BusState:
+    def __init__(self, max_age=MAX_AGE, clock=time.monotonic):
+        self.max_age = max_age
+        self.clock = clock
+        self.lock = threading.Lock()
+        self.devices = {}          # logical address -> {field: (value, monotonic time)}
+        self.active_source = None  # Logical address, None when unknown or none
+        self.active_path = None    # Physical address last routed to
+        self.active_at = None
+        self.watchers = []
+        self.events = []           # Found under the lock, handed to watchers after it
+        self.reported = {}         # logical address -> power code watchers last heard of
+        self.frames = 0
+        self.hits = 0
+        self.misses = 0
+
+    def add_watcher(self, callback):
+        self.watchers.append(callback)
+
+    def _dispatch(self):
+        with self.lock:
+            events, self.events = self.events, []
+        for event in events:
+            for callback in self.watchers:
+                try:
+                    callback(*event)
+                except Exception as e:
+                    logger.error(f"Bus watcher error: {e}")
+
+    def _set(self, logical, field, value):
+        if logical == BROADCAST:
+            return  # Unregistered devices have no address of their own
+        fields = self.devices.get(logical)
+        appeared = fields is None
+        if appeared:
+            fields = self.devices[logical] = {}
+        previous = fields.get(field, (None,))[0]
+        fields[field] = (value, self.clock())
+        if appeared or (field == "name" and value != previous):
+            self.events.append((EVENT_DEVICE, logical, fields.get("name", ("",))[0]))
+        if field == "power" and POWER_CODES.get(value) not in (None, self.reported.get(logical)):
+            self.reported[logical] = POWER_CODES[value]
+            self.events.append((EVENT_POWER, logical, POWER_CODES[value]))
+
+    def _set_source(self, logical, physical):
+        """Active source at physical (dotted), logical None when unknown"""
+        changed = (logical, physical) != (self.active_source, self.active_path)
+        self.active_source, self.active_path, self.active_at = logical, physical, self.clock()
+        if changed and physical is not None:
+            value = int(physical.replace(".", ""), 16)
+            self.events.append((EVENT_SOURCE, EVENT_NO_DEVICE if logical is None else logical, value))
+
+    def _remove(self, logical):
+        if self.devices.pop(logical, None) is not None:
+            self.reported.pop(logical, None)
+            self.events.append((EVENT_GONE, logical, None))
+        if self.active_source == logical:
+            self.active_source = None
+
+    def _forget(self, logical, field):
+        self.devices.get(logical, {}).pop(field, None)
+
+    def _at_path(self, physical):
+        for logical, fields in self.devices.items():
+            if fields.get("physical", (None,))[0] == physical:
+                return logical
+        return None
+
+    def on_line(self, line):
+        """Backend listener: every traffic line, in either direction"""
+        if HOTPLUG_PATTERN.search(line):
+            with self.lock:
+                # Addresses may have moved; names and vendors are re-announced anyway
+                for logical in list(self.devices):
+                    self._remove(logical)
+                self.active_source = None
+                self.active_path = None
+            logger.info("🔌 Physical address change, bus state cleared")
+            self._dispatch()
+            return
+        match = FRAME_PATTERN.search(line)
+        if match:
+            self.on_frame(match.group(1) == "<<", [int(b, 16) for b in match.group(2).split(":")])
+
+    def on_frame(self, received, frame):
+        if len(frame) < 2:
+            return
+        with self.lock:
+            self._on_frame(received, frame)
+        self._dispatch()
+
+    def _on_frame(self, received, frame):
+        initiator, destination = frame[0] >> 4, frame[0] & 0xF
+        opcode, params = frame[1], frame[2:]
+        self.frames += 1
+        if not received:
+            if opcode in (OP_STANDBY, OP_IMAGE_VIEW_ON, OP_TEXT_VIEW_ON):
+                for logical in (list(self.devices) if destination == BROADCAST else [destination]):
+                    self._forget(logical, "power")
+            return
+
+        if opcode == OP_REPORT_POWER_STATUS and params:
+            self._set(initiator, "power", POWER_NAMES.get(params[0], "unknown"))
+        elif opcode == OP_STANDBY:
+            targets = [initiator] + (list(self.devices) if destination == BROADCAST else [destination])
+            for logical in set(targets):
+                self._set(logical, "power", POWER_NAMES[1])
+            if self.active_source in targets:
+                self.active_source = None
+        elif opcode == OP_ACTIVE_SOURCE and len(params) >= 2:
+            physical = format_physical(params[0], params[1])
+            self._set(initiator, "physical", physical)
+            self._set(initiator, "power", POWER_NAMES[0])
+            self._set_source(initiator, physical)
+        elif opcode in (OP_ROUTING_CHANGE, OP_SET_STREAM_PATH):
+            offset = 2 if opcode == OP_ROUTING_CHANGE else 0
+            if len(params) >= offset + 2:
+                physical = format_physical(params[offset], params[offset + 1])
+                self._set_source(self._at_path(physical), physical)
+        elif opcode == OP_INACTIVE_SOURCE:
+            if self.active_source == initiator:
+                self.active_source = None
+        elif opcode == OP_SET_OSD_NAME:
+            self._set(initiator, "name", bytes(params).decode("ascii", "replace"))
+        elif opcode == OP_DEVICE_VENDOR_ID and len(params) >= 3:
+            vendor_id = int.from_bytes(bytes(params[:3]), "big")
+            self._set(initiator, "vendor", VENDOR_NAMES.get(vendor_id, f"0x{vendor_id:06x}"))
+        elif opcode == OP_REPORT_PHYSICAL_ADDRESS and len(params) >= 2:
+            self._set(initiator, "physical", format_physical(params[0], params[1]))
+
+    def get(self, logical, field, max_age=None):
+        """(value, age in seconds) of one field, None when unknown or too old"""
+        max_age = self.max_age if max_age is None else max_age
+        with self.lock:
+            entry = self.devices.get(logical, {}).get(field)
+            if entry is None or self.clock() - entry[1] > max_age:
+                self.misses += 1
+                return None
+            self.hits += 1
+            return entry[0], self.clock() - entry[1]
+
+    @staticmethod
+    def _query(command):
+        parts = command.split()
+        if len(parts) < 1 or parts[0].lower() not in QUERIES:
+            return None
+        try:
+            logical = int(parts[1], 16) & 0xF if len(parts) > 1 else 0
+        except ValueError:
+            return None
+        return parts[0].lower(), logical
+
+    def answer(self, command):
+        """cec-client style output for a pow/ven/name query the table can answer, else None"""
+        query = self._query(command)
+        if query is None:
+            return None
+        verb, logical = query
+        field, reply, _ = QUERIES[verb]
+        known = self.get(logical, field)
+        if known is None:
+            return None
+        return f"{reply(logical, known[0])} (from bus, {known[1]:.0f} s ago)"
+
+    def note_output(self, command, output):
+        """Keep what a pow/ven/name query printed; libcec may answer from its own cache"""
+        query = self._query(command)
+        if query is None:
+            return
+        verb, logical = query
+        field, _, pattern = QUERIES[verb]
+        match = pattern.search(output or "")
+        if match and match.group(1).strip() not in ("unknown", "Unknown"):
+            with self.lock:
+                self._set(logical, field, match.group(1).strip())
+            self._dispatch()
+
+    def note_present(self, logical, present):
+        """A poll of logical was acked or not"""
+        with self.lock:
+            if not present:
+                self._remove(logical)
+            elif logical not in self.devices:
+                self.devices[logical] = {}
+                self.events.append((EVENT_DEVICE, logical, ""))
+        self._dispatch()
+
+    def snapshot(self):
+        """Events that bring a new watcher up to date"""
+        with self.lock:
+            events = []
+            for logical, fields in sorted(self.devices.items()):
+                events.append((EVENT_DEVICE, logical, fields.get("name", ("",))[0]))
+                if POWER_CODES.get(fields.get("power", (None,))[0]) is not None:
+                    events.append((EVENT_POWER, logical, POWER_CODES[fields["power"][0]]))
+            if self.active_path is not None:
+                source = EVENT_NO_DEVICE if self.active_source is None else self.active_source
+                events.append((EVENT_SOURCE, source, int(self.active_path.replace(".", ""), 16)))
+            return events
+
+    def devices_known(self):
+        """Devices with anything known, as discovery-style records"""
+        with self.lock:
+            records = []
+            for logical, fields in sorted(self.devices.items()):
+                records.append({
+                    "logical": logical,
+                    "name": fields.get("name", ("",))[0],
+                    "vendor": fields.get("vendor", ("Unknown",))[0],
+                    "power": fields.get("power", ("unknown",))[0],
+                    "physical": fields.get("physical", (None,))[0],
+                })
+            return records
+
+    def format_status(self):
+        """TV power and the active source, for STATUS"""
+        power = self.get(0, "power")
+        lines = [f"📺 TV: {power[0]} ({power[1]:.0f} s ago)" if power else "📺 TV: unknown"]
+        with self.lock:
+            source, path = self.active_source, self.active_path
+        if source is not None:
+            name = self.devices.get(source, {}).get("name", (LOGICAL_NAMES[source],))[0]
+            lines.append(f"▶️ Source: #{source:X} {name} {path or ''}".rstrip())
+        elif path is not None:
+            lines.append(f"▶️ Input: {path}")
+        return "\n".join(lines)
+
+    def to_dict(self):
+        with self.lock:
+            now = self.clock()
+            devices = {
+                f"{logical:x}": {field: {"value": value, "age": round(now - at, 1)}
+                                 for field, (value, at) in fields.items()}
+                for logical, fields in self.devices.items()
+            }
+            return {"devices": devices, "active_source": self.active_source, "active_path": self.active_path,
+                    "frames": self.frames, "hits": self.hits, "misses": self.misses}
+
+
+_state = None
+_state_lock = threading.Lock()
+
+
+def get_bus_state():
+    """Shared table, listening to the shared backend from the first call that finds it open"""
+    global _state
+    with _state_lock:
+        if _state is None:
+            state = BusState()
+            get_backend().add_listener(state.on_line)
+            _state = state
+        return _state
+
+
+def stop_bus_state():
+    """Forget the table; the next get_bus_state() listens to whichever backend is open then"""
+    global _state
+    with _state_lock:
+        _state = None
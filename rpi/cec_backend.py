@@ -0,0 +1,571 @@
+#!/usr/bin/env python3
+"""
+Pluggable CEC backends
+The daemon speaks cec-client's command text ("tx 4F:82:10:00", "pow 0",
+"scan" ...). A backend runs one such command and returns (success, output):
+  CECSession     the cec-client process, see cec_session.py
+  KernelBackend  /dev/cecN through the Linux CEC framework ioctls
+  FakeBackend    a simulated bus in memory, for the host tools
+The frame backends turn each command into CEC messages: success is the
+transmit status the adapter reports (ACK/NACK) plus the reply where one is
+expected, and the output is written the way cec-client prints it, so scan
+parsing, discovery and sequences work on any backend. Frames seen on the
+bus reach listeners as cec-client style traffic lines.
+
+CEC_BACKEND picks one: auto (default: the kernel device when CEC_DEVICE
+opens, cec-client otherwise), kernel, cec-client or fake.
+
+CEC_ADAPTERS names several adapters instead, each with its own backend,
+see adapters.py. The first one is the shared backend here.
+"""
+import fcntl
+import os
+import re
+import select
+import struct
+import threading
+import time
+import logging
+import latency
+from device_cache import VENDOR_NAMES, format_physical
+
+logger = logging.getLogger("cec_backend")
+
+CEC_BACKEND = os.environ.get("CEC_BACKEND", "auto")
+CEC_DEVICE = os.environ.get("CEC_DEVICE", "/dev/cec0")
+
+# name=backend[:device] per adapter, comma separated
+CEC_ADAPTERS = os.environ.get("CEC_ADAPTERS", "")
+
+# How long a query waits for the answering message
+REPLY_TIMEOUT = 1.0
+
+OSD_NAME = "Flipper CEC"
+
+# cec-client's names for logical addresses
+LOGICAL_NAMES = ["TV", "Recorder 1", "Recorder 2", "Tuner 1", "Playback 1", "Audio", "Tuner 2", "Tuner 3",
+                 "Playback 2", "Recorder 3", "Tuner 4", "Playback 3", "Reserved 1", "Reserved 2", "Free use"]
+
+POWER_NAMES = {0: "on", 1: "standby", 2: "in transition from standby to on", 3: "in transition from on to standby"}
+
+CEC_VERSIONS = {1: "1.2", 2: "1.2a", 3: "1.3", 4: "1.3a", 5: "1.4", 6: "2.0"}
+
+# CEC opcodes the frame backends send or answer
+OP_IMAGE_VIEW_ON = 0x04
+OP_TEXT_VIEW_ON = 0x0D
+OP_STANDBY = 0x36
+OP_USER_CONTROL_PRESSED = 0x44
+OP_USER_CONTROL_RELEASED = 0x45
+OP_GIVE_OSD_NAME = 0x46
+OP_SET_OSD_NAME = 0x47
+OP_ACTIVE_SOURCE = 0x82
+OP_GIVE_PHYSICAL_ADDRESS = 0x83
+OP_REPORT_PHYSICAL_ADDRESS = 0x84
+OP_DEVICE_VENDOR_ID = 0x87
+OP_GIVE_DEVICE_VENDOR_ID = 0x8C
+OP_GIVE_POWER_STATUS = 0x8F
+OP_REPORT_POWER_STATUS = 0x90
+OP_CEC_VERSION = 0x9E
+OP_GET_CEC_VERSION = 0x9F
+OP_INACTIVE_SOURCE = 0x9D
+
+# User control codes for the volume verbs
+VOLUME_KEYS = {"volup": 0x41, "voldown": 0x42, "mute": 0x43}
+
+AUDIO_SYSTEM = 0x5
+BROADCAST = 0xF
+
+TX_PATTERN = re.compile(r"[:\s]+")
+
+
+class CECBackendError(Exception):
+    """Raised when a backend cannot run a command"""
+
+
+class CECTimeout(CECBackendError):
+    """Raised when a command did not finish within its timeout"""
+
+
+def format_frame(frame):
+    return ":".join(f"{b:02x}" for b in frame)
+
+
+class FrameBackend:
+    """Runs cec-client commands as CEC messages; subclasses provide transmit()"""
+
+    name = "frames"
+    # Some TVs miss a frame that follows the previous one too closely
+    min_gap = 0.03
+
+    def __init__(self):
+        self.listeners = []
+        self.command_lock = threading.Lock()
+        self.logical = 0x4         # Claimed logical address
+        self.physical = 0x1000
+        self.started = time.monotonic()
+        self.deadline = None       # Of the command running under command_lock
+
+    def add_listener(self, callback):
+        """Register callback(line) for every traffic line, as cec-client prints them"""
+        self.listeners.append(callback)
+
+    def start(self):
+        return True
+
+    def stop(self):
+        pass
+
+    def transmit(self, frame, reply=None, timeout=REPLY_TIMEOUT):
+        """Put frame on the bus, wait for an answer with opcode reply when given.
+
+        Returns (acked, answer frame or None).
+        """
+        raise NotImplementedError
+
+    def notify(self, direction, frame):
+        ms = int((time.monotonic() - self.started) * 1000)
+        self.notify_line(f"TRAFFIC: [{ms:8d}]\t{direction} {format_frame(frame)}")
+
+    def notify_line(self, line):
+        for callback in self.listeners:
+            try:
+                callback(line)
+            except Exception as e:
+                logger.error(f"Backend listener error: {e}")
+
+    def execute(self, command, timeout=10):
+        """Run one cec-client command, returns (success, output)"""
+        queued = time.monotonic()
+        with self.command_lock:
+            started = time.monotonic()
+            self.deadline = started + timeout
+            try:
+                parts = command.split(None, 1)
+                verb = parts[0].lower() if parts else ""
+                handler = getattr(self, "_cmd_" + verb, None)
+                if handler is None:
+                    return False, f"ERROR:   unknown command '{verb}'"
+                return handler(parts[1] if len(parts) > 1 else "")
+            finally:
+                latency.note_cec(started - queued, time.monotonic() - started)
+
+    def _send(self, destination, opcode=None, params=b"", reply=None):
+        remaining = self.deadline - time.monotonic()
+        if remaining <= 0:
+            raise CECTimeout("Command timed out")
+        frame = bytes([(self.logical << 4) | destination])
+        if opcode is not None:
+            frame += bytes([opcode]) + bytes(params)
+        self.notify(">>", frame)
+        acked, answer = self.transmit(frame, reply, min(REPLY_TIMEOUT, remaining))
+        if answer is not None:
+            # Replies to our own queries never reach the reader, so listeners see them here
+            self.notify("<<", answer)
+        return acked, answer
+
+    def _query(self, destination, opcode, reply):
+        """Answer payload (after the opcode) to a directed query, None without one"""
+        acked, answer = self._send(destination, opcode, reply=reply)
+        if not acked or answer is None or len(answer) < 2 or answer[1] != reply:
+            return None
+        return answer[2:]
+
+    @staticmethod
+    def _address(args, default=0):
+        try:
+            return int(args.split()[0], 16) & 0xF
+        except (IndexError, ValueError):
+            return default
+
+    def _cmd_tx(self, args):
+        try:
+            frame = bytes(int(b, 16) for b in TX_PATTERN.split(args.strip()) if b)
+        except ValueError:
+            frame = b""
+        if not frame:
+            return False, "ERROR:   invalid command"
+        if len(frame) == 1:
+            return self._cmd_poll(f"{frame[0] & 0xF:x}")
+        # The initiator is whatever address this backend holds
+        return self._simple(frame[0] & 0xF, frame[1], frame[2:])
+
+    _cmd_txn = _cmd_tx
+
+    def _simple(self, destination, opcode, params=b""):
+        acked, _ = self._send(destination, opcode, params)
+        text = format_frame(bytes([(self.logical << 4) | destination, opcode]) + bytes(params))
+        if not acked:
+            return False, f"ERROR:   command '{text}' was not acked by the controller"
+        return True, f"TRAFFIC: >> {text}"
+
+    def _cmd_on(self, args):
+        return self._simple(self._address(args), OP_IMAGE_VIEW_ON)
+
+    def _cmd_standby(self, args):
+        return self._simple(self._address(args), OP_STANDBY)
+
+    def _cmd_as(self, args):
+        return self._simple(BROADCAST, OP_ACTIVE_SOURCE, self.physical.to_bytes(2, "big"))
+
+    def _cmd_is(self, args):
+        return self._simple(0x0, OP_INACTIVE_SOURCE, self.physical.to_bytes(2, "big"))
+
+    def _volume(self, key):
+        # The audio system if there is one, the TV otherwise
+        for destination in (AUDIO_SYSTEM, 0x0):
+            acked, _ = self._send(destination, OP_USER_CONTROL_PRESSED, [key])
+            if acked:
+                self._send(destination, OP_USER_CONTROL_RELEASED)
+                return True, f"TRAFFIC: >> {format_frame(bytes([(self.logical << 4) | destination, 0x44, key]))}"
+        return False, "ERROR:   volume key was not acked by the audio system or the TV"
+
+    def _cmd_volup(self, args):
+        return self._volume(VOLUME_KEYS["volup"])
+
+    def _cmd_voldown(self, args):
+        return self._volume(VOLUME_KEYS["voldown"])
+
+    def _cmd_mute(self, args):
+        return self._volume(VOLUME_KEYS["mute"])
+
+    def _cmd_poll(self, args):
+        acked, _ = self._send(self._address(args))
+        return acked, "POLL message sent" if acked else "POLL message failed"
+
+    def _power(self, destination):
+        answer = self._query(destination, OP_GIVE_POWER_STATUS, OP_REPORT_POWER_STATUS)
+        return POWER_NAMES.get(answer[0], "unknown") if answer else None
+
+    def _vendor(self, destination):
+        answer = self._query(destination, OP_GIVE_DEVICE_VENDOR_ID, OP_DEVICE_VENDOR_ID)
+        if not answer or len(answer) < 3:
+            return None
+        vendor_id = int.from_bytes(answer[:3], "big")
+        return VENDOR_NAMES.get(vendor_id, f"0x{vendor_id:06x}")
+
+    def _name(self, destination):
+        answer = self._query(destination, OP_GIVE_OSD_NAME, OP_SET_OSD_NAME)
+        return bytes(answer).decode("ascii", "replace") if answer is not None else None
+
+    def _version(self, destination):
+        answer = self._query(destination, OP_GET_CEC_VERSION, OP_CEC_VERSION)
+        return CEC_VERSIONS.get(answer[0], "unknown") if answer else None
+
+    def _physical(self, destination):
+        answer = self._query(destination, OP_GIVE_PHYSICAL_ADDRESS, OP_REPORT_PHYSICAL_ADDRESS)
+        return format_physical(answer[0], answer[1]) if answer and len(answer) >= 2 else None
+
+    def _cmd_pow(self, args):
+        power = self._power(self._address(args))
+        return power is not None, f"power status: {power or 'unknown'}"
+
+    def _cmd_ven(self, args):
+        vendor = self._vendor(self._address(args))
+        return vendor is not None, f"vendor id: {vendor or 'Unknown'}"
+
+    def _cmd_name(self, args):
+        destination = self._address(args)
+        name = self._name(destination)
+        return name is not None, f"osd name of device {destination:x} is '{name or ''}'"
+
+    def _cmd_ver(self, args):
+        version = self._version(self._address(args))
+        return version is not None, f"cec version {version or 'unknown'}"
+
+    def _cmd_lad(self, args):
+        return True, f"logical address(es) = {LOGICAL_NAMES[self.logical]} ({self.logical:x})"
+
+    def _cmd_scan(self, args):
+        lines = ["CEC bus information", "==================="]
+        for logical in range(15):
+            if logical == self.logical or not self._send(logical)[0]:
+                continue
+            lines += [
+                f"device #{logical:x}: {LOGICAL_NAMES[logical]}",
+                f"address:       {self._physical(logical) or 'f.f.f.f'}",
+                "active source: no",
+                f"vendor:        {self._vendor(logical) or 'Unknown'}",
+                f"osd string:    {self._name(logical) or ''}",
+                f"CEC version:   {self._version(logical) or 'unknown'}",
+                f"power status:  {self._power(logical) or 'unknown'}",
+                "",
+            ]
+        lines.append("currently active source: unknown (-1)")
+        return True, "\n".join(lines)
+
+
+# Linux CEC framework, see linux/cec.h
+def _ioc(direction, number, size):
+    return (direction << 30) | (size << 16) | (ord("a") << 8) | number
+
+
+CEC_MSG = struct.Struct("=QQIIII16sBBBBBBBx")
+CEC_LOG_ADDRS = struct.Struct("=4sHBBII15s4s4s4s48sx")
+CEC_EVENT_SIZE = 80
+
+CEC_ADAP_G_PHYS_ADDR = _ioc(2, 1, 2)
+CEC_ADAP_G_LOG_ADDRS = _ioc(2, 3, CEC_LOG_ADDRS.size)
+CEC_ADAP_S_LOG_ADDRS = _ioc(3, 4, CEC_LOG_ADDRS.size)
+CEC_TRANSMIT = _ioc(3, 5, CEC_MSG.size)
+CEC_RECEIVE = _ioc(3, 6, CEC_MSG.size)
+CEC_DQEVENT = _ioc(3, 7, CEC_EVENT_SIZE)
+CEC_S_MODE = _ioc(1, 9, 4)
+
+CEC_MODE_INITIATOR = 0x01
+CEC_MODE_FOLLOWER = 0x10
+CEC_TX_STATUS_OK = 0x01
+CEC_RX_STATUS_OK = 0x01
+CEC_EVENT_STATE_CHANGE = 1
+CEC_LOG_ADDR_TYPE_PLAYBACK = 3
+CEC_OP_PRIM_DEVTYPE_PLAYBACK = 4
+CEC_OP_ALL_DEVTYPE_PLAYBACK = 0x10
+CEC_OP_CEC_VERSION_1_4 = 5
+CEC_VENDOR_ID_NONE = 0xFFFFFFFF
+
+
+class KernelBackend(FrameBackend):
+    """/dev/cecN: one ioctl per frame, ACK/NACK straight from the adapter"""
+
+    name = "kernel"
+
+    def __init__(self, device=None):
+        super().__init__()
+        self.device = device or CEC_DEVICE
+        self.fd = None
+        self.claimed = False
+        self.running = False
+        self.reader_thread = None
+
+    def start(self):
+        """Open the adapter, claim a playback address and start receiving"""
+        fd = os.open(self.device, os.O_RDWR)
+        try:
+            fcntl.ioctl(fd, CEC_S_MODE, struct.pack("=I", CEC_MODE_INITIATOR | CEC_MODE_FOLLOWER))
+            addrs = bytearray(CEC_LOG_ADDRS.size)
+            fcntl.ioctl(fd, CEC_ADAP_G_LOG_ADDRS, addrs, True)
+            if CEC_LOG_ADDRS.unpack(addrs)[3] == 0:
+                # Blocks until the address is claimed on the bus
+                addrs = bytearray(CEC_LOG_ADDRS.pack(
+                    b"\xff" * 4, 0, CEC_OP_CEC_VERSION_1_4, 1, CEC_VENDOR_ID_NONE, 0,
+                    OSD_NAME.encode("ascii"), bytes([CEC_OP_PRIM_DEVTYPE_PLAYBACK, 0, 0, 0]),
+                    bytes([CEC_LOG_ADDR_TYPE_PLAYBACK, 0, 0, 0]),
+                    bytes([CEC_OP_ALL_DEVTYPE_PLAYBACK, 0, 0, 0]), bytes(48)))
+                fcntl.ioctl(fd, CEC_ADAP_S_LOG_ADDRS, addrs, True)
+                self.claimed = True
+            self._read_addresses(fd)
+        except OSError:
+            os.close(fd)
+            raise
+
+        self.fd = fd
+        self.running = True
+        self.reader_thread = threading.Thread(target=self._reader_loop)
+        self.reader_thread.daemon = True
+        self.reader_thread.start()
+        logger.info(f"Kernel CEC backend on {self.device}: logical {self.logical:x}, "
+                    f"physical {format_physical(self.physical >> 8, self.physical & 0xFF)}")
+        return True
+
+    def _read_addresses(self, fd):
+        addrs = bytearray(CEC_LOG_ADDRS.size)
+        fcntl.ioctl(fd, CEC_ADAP_G_LOG_ADDRS, addrs, True)
+        log_addr, _, _, count = CEC_LOG_ADDRS.unpack(addrs)[:4]
+        if count == 0 or log_addr[0] == 0xFF:
+            raise CECBackendError("No logical address claimed")
+        self.logical = log_addr[0]
+        physical = bytearray(2)
+        fcntl.ioctl(fd, CEC_ADAP_G_PHYS_ADDR, physical, True)
+        self.physical = struct.unpack("=H", physical)[0]
+
+    def stop(self):
+        self.running = False
+        if self.reader_thread:
+            self.reader_thread.join(timeout=2)
+        if self.fd is not None:
+            if self.claimed:
+                # Give the address back so cec-client can have the adapter again
+                try:
+                    fcntl.ioctl(self.fd, CEC_ADAP_S_LOG_ADDRS, bytearray(CEC_LOG_ADDRS.size), True)
+                except OSError:
+                    pass
+            os.close(self.fd)
+            self.fd = None
+
+    def transmit(self, frame, reply=None, timeout=REPLY_TIMEOUT):
+        if self.fd is None:
+            raise CECBackendError("CEC device not open")
+        msg = bytearray(CEC_MSG.pack(0, 0, len(frame), int(timeout * 1000) if reply else 0, 0, 0,
+                                     bytes(frame), reply or 0, 0, 0, 0, 0, 0, 0))
+        try:
+            fcntl.ioctl(self.fd, CEC_TRANSMIT, msg, True)
+        except OSError as e:
+            raise CECBackendError(f"CEC transmit failed: {e}")
+        _, _, length, _, _, _, data, _, rx_status, tx_status = CEC_MSG.unpack(msg)[:10]
+        acked = bool(tx_status & CEC_TX_STATUS_OK)
+        answer = None
+        if acked and reply and rx_status & CEC_RX_STATUS_OK:
+            # The kernel leaves the answer in place of the request
+            answer = data[:length]
+        return acked, answer
+
+    def _reader_loop(self):
+        while self.running:
+            try:
+                readable, _, exceptional = select.select([self.fd], [], [self.fd], 0.5)
+                if exceptional:
+                    self._dequeue_event()
+                if readable:
+                    msg = bytearray(CEC_MSG.size)
+                    fcntl.ioctl(self.fd, CEC_RECEIVE, msg, True)
+                    length, data = CEC_MSG.unpack(msg)[2], CEC_MSG.unpack(msg)[6]
+                    self.notify("<<", data[:length])
+            except OSError as e:
+                if self.running:
+                    logger.error(f"CEC receive error: {e}")
+                    time.sleep(0.5)
+
+    def _dequeue_event(self):
+        event = bytearray(CEC_EVENT_SIZE)
+        fcntl.ioctl(self.fd, CEC_DQEVENT, event, True)
+        kind = struct.unpack_from("=I", event, 8)[0]
+        if kind != CEC_EVENT_STATE_CHANGE:
+            return
+        physical, mask = struct.unpack_from("=HH", event, 16)
+        self.physical = physical
+        if mask:
+            self.logical = (mask & -mask).bit_length() - 1
+        # Same wording cec-client uses, so the device cache drops its entries
+        self.notify_line(f"physical address changed to {format_physical(physical >> 8, physical & 0xFF)}")
+
+
+# Simulated bus for FakeBackend: logical address -> device
+FAKE_DEVICES = {
+    0x0: {"name": "TV", "vendor_id": 0x0000F0, "power": 0, "physical": 0x0000},
+    0x5: {"name": "Soundbar", "vendor_id": 0x00E091, "power": 1, "physical": 0x2000},
+}
+
+
+class FakeBackend(FrameBackend):
+    """Devices in memory that ACK, change power state and answer queries
+
+    A device with "wake" seconds reports standby-to-on (2) that long after it
+    was woken, like a projector warming up."""
+
+    name = "fake"
+
+    def __init__(self, devices=None, delay=None, label=None):
+        super().__init__()
+        self.devices = {logical: dict(device) for logical, device in (devices or FAKE_DEVICES).items()}
+        if label and 0x0 in self.devices:
+            # One fake bus per adapter: its TV goes by the adapter's label
+            self.devices[0x0]["name"] = label
+        self.delay = float(os.environ.get("FAKE_CEC_CMD_DELAY", "0")) if delay is None else delay
+        self.sent = []             # Every frame put on the bus, for the tools to check
+
+    def transmit(self, frame, reply=None, timeout=REPLY_TIMEOUT):
+        if self.delay:
+            time.sleep(self.delay)
+        self.sent.append(bytes(frame))
+        destination = frame[0] & 0xF
+        targets = list(self.devices) if destination == BROADCAST else [destination]
+        if destination != BROADCAST and destination not in self.devices:
+            return False, None
+
+        opcode = frame[1] if len(frame) > 1 else None
+        for logical in targets:
+            device = self.devices[logical]
+            if opcode in (OP_IMAGE_VIEW_ON, OP_TEXT_VIEW_ON):
+                if device.get("wake") and device["power"] == 1:
+                    device["power"] = 2
+                    device["on_at"] = time.monotonic() + device["wake"]
+                elif device["power"] != 2:
+                    device["power"] = 0
+            elif opcode == OP_STANDBY:
+                device["power"] = 1
+                device.pop("on_at", None)
+
+        answer = self._answer(destination, opcode) if reply and destination != BROADCAST else None
+        return True, answer
+
+    def _answer(self, logical, opcode):
+        device = self.devices[logical]
+        header = bytes([(logical << 4) | self.logical])
+        if opcode == OP_GIVE_POWER_STATUS:
+            if device.get("on_at") and time.monotonic() >= device["on_at"]:
+                device["power"] = 0
+                del device["on_at"]
+            return header + bytes([OP_REPORT_POWER_STATUS, device["power"]])
+        if opcode == OP_GIVE_DEVICE_VENDOR_ID:
+            return header + bytes([OP_DEVICE_VENDOR_ID]) + device["vendor_id"].to_bytes(3, "big")
+        if opcode == OP_GIVE_OSD_NAME:
+            return header + bytes([OP_SET_OSD_NAME]) + device["name"].encode("ascii")
+        if opcode == OP_GET_CEC_VERSION:
+            return header + bytes([OP_CEC_VERSION, CEC_OP_CEC_VERSION_1_4])
+        if opcode == OP_GIVE_PHYSICAL_ADDRESS:
+            return header + bytes([OP_REPORT_PHYSICAL_ADDRESS]) + device["physical"].to_bytes(2, "big") + bytes([0])
+        return None
+
+    def receive(self, frame):
+        """A device on the simulated bus sent frame on its own"""
+        self.notify("<<", bytes(frame))
+
+
+def adapter_specs(text=None):
+    """[(name, backend, device)] from CEC_ADAPTERS; one adapter, main, when it is empty"""
+    text = CEC_ADAPTERS if text is None else text
+    specs = []
+    for entry in filter(None, (part.strip() for part in text.split(","))):
+        name, _, backend = entry.partition("=")
+        kind, _, device = backend.partition(":")
+        if not name.strip() or not kind.strip():
+            raise CECBackendError(f"Bad CEC_ADAPTERS entry '{entry}', expected name=backend[:device]")
+        specs.append((name.strip(), kind.strip(), device.strip() or None))
+    return specs or [("main", CEC_BACKEND, None)]
+
+
+def open_backend(kind=None, device=None):
+    """The backend CEC_BACKEND asks for, started except for the lazy cec-client session
+
+    device is the kernel device, the cec-client port or the fake bus's label."""
+    kind = (kind or CEC_BACKEND).lower()
+    if kind in ("auto", "kernel"):
+        backend = KernelBackend(device)
+        try:
+            backend.start()
+            return backend
+        except (OSError, CECBackendError) as e:
+            if kind == "kernel":
+                raise CECBackendError(f"Cannot use {backend.device}: {e}")
+            logger.info(f"No kernel CEC on {backend.device} ({e}), using cec-client")
+    elif kind == "fake":
+        backend = FakeBackend(label=device)
+        backend.start()
+        return backend
+    elif kind != "cec-client":
+        raise CECBackendError(f"Unknown CEC backend '{kind}'")
+
+    from cec_session import CECSession
+    return CECSession(port=device if kind == "cec-client" else None)
+
+
+_backend = None
+_backend_lock = threading.Lock()
+
+
+def get_backend():
+    """Shared backend used by every command path in the daemon"""
+    global _backend
+    with _backend_lock:
+        if _backend is None:
+            _, kind, device = adapter_specs()[0]
+            _backend = open_backend(kind, device)
+            logger.info(f"Using {_backend.name} CEC backend")
+        return _backend
+
+
+def stop_backend():
+    global _backend
+    with _backend_lock:
+        if _backend is not None:
+            _backend.stop()
+            _backend = None
@@ -8,6 +8,13 @@ import logging
 import json
 import os
 from datetime import datetime
+from cec_backend import get_backend, CECTimeout
+from scheduler import get_scheduler
+from command_journal import CommandHistory
+from device_cache import DeviceCache
+from bus_state import get_bus_state
+from sequence import parse_sequence
+from power_timing import run_adaptive, get_timing_store
 
 # Enhanced logging setup
 logging.basicConfig(
@@ -20,9 +27,12 @@ logging.basicConfig(
 )
 logger = logging.getLogger("cec_control")
 
-# Global command history for tracking successful commands
-COMMAND_HISTORY = []
-SUCCESSFUL_COMMANDS = []
+# Command history: a fixed-size ring in memory, every command in the on-disk journal
+HISTORY = CommandHistory()
+
+# Devices from the last scan, so commands do not rescan the bus each time
+DEVICE_CACHE = DeviceCache()
+_cache_listening = False
 
 def log_command(command, result, success=False, vendor="unknown"):
     """Log command with timestamp and result"""
@@ -36,50 +46,31 @@ def log_command(command, result, success=False, vendor="unknown"):
         "raw_cec_command": command if command.startswith("tx ") else None
     }
     
-    # Add to history
-    COMMAND_HISTORY.append(command_entry)
-    
-    # Track successful commands separately
-    if success:
-        SUCCESSFUL_COMMANDS.append(command_entry)
+    # Add to history; successful tx commands are converted for BrightSign here, once
+    HISTORY.record(command_entry)
     
     # Log to file
     logger.info(f"CEC_CMD: {command} | SUCCESS: {success} | VENDOR: {vendor}")
     
     return command_entry
 
-def get_command_history(successful_only=False):
-    """Get command history in various formats"""
-    commands = SUCCESSFUL_COMMANDS if successful_only else COMMAND_HISTORY
-    return commands
+def get_command_history(successful_only=False, limit=None):
+    """Get the newest commands, by default as many as the in-memory ring holds"""
+    if limit is None:
+        limit = HISTORY.recent.maxlen
+    return HISTORY.last(limit, successful_only)
 
-def export_successful_commands():
-    """Export successful commands for BrightSign"""
-    successful = get_command_history(successful_only=True)
-    
+def export_successful_commands(limit=None):
+    """Export successful commands for BrightSign, the newest limit up to CEC_EXPORT_LIMIT
+
+    save_command_log() streams every journaled one to a file instead.
+    """
     export_data = {
         "export_time": datetime.now().isoformat(),
-        "total_successful_commands": len(successful),
-        "commands": successful,
-        "brightsign_format": []
+        "total_successful_commands": HISTORY.successful,
+        "commands": get_command_history(successful_only=True),
+        "brightsign_format": HISTORY.brightsign_export(limit)
     }
-    
-    # Convert to BrightSign format
-    for cmd in successful:
-        if cmd.get("raw_cec_command"):
-            # Convert tx commands to BrightSign ASCII format
-            cec_cmd = cmd["raw_cec_command"]
-            if cec_cmd.startswith("tx "):
-                # Remove "tx " and convert to ASCII string
-                hex_part = cec_cmd[3:].replace(":", "")
-                brightsign_cmd = {
-                    "description": f"Vendor: {cmd['vendor']} | Original: {cec_cmd}",
-                    "brightsign_ascii": hex_part,
-                    "brightsign_command": f'BrightControl Send Ascii String "{hex_part}"',
-                    "timestamp": cmd["timestamp"]
-                }
-                export_data["brightsign_format"].append(brightsign_cmd)
-    
     return export_data
 
 def save_command_log(filename=None):
@@ -87,10 +78,7 @@ def save_command_log(filename=None):
     if not filename:
         filename = f"/tmp/cec_commands_{datetime.now().strftime('%Y%m%d_%H%M%S')}.json"
     
-    export_data = export_successful_commands()
-    
-    with open(filename, 'w') as f:
-        json.dump(export_data, f, indent=2)
+    HISTORY.write_export(filename)
     
     logger.info(f"Command history saved to {filename}")
     return filename
@@ -199,30 +187,20 @@ CORE_COMMANDS = {
 }
 
 def execute_cec_command(command, timeout=15, vendor="unknown"):
-    """Execute CEC command and return result with logging"""
+    """Execute CEC command through the shared scheduler and return result with logging"""
     try:
         logger.info(f"Executing CEC command: {command}")
         
-        process = subprocess.Popen(
-            ['cec-client', '-s', '-d', '1'],
-            stdin=subprocess.PIPE,
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            universal_newlines=True
-        )
+        success, output = get_scheduler().execute(command, timeout=timeout)
         
-        stdout, stderr = process.communicate(input=command + '\n', timeout=timeout)
-        
-        success = process.returncode == 0
-        result = f"Command executed: {command}\nOutput: {stdout}" if success else f"Command failed: {stderr}"
+        result = f"Command executed: {command}\nOutput: {output}" if success else f"Command failed: {output}"
         
         # Log the command
         log_command(command, result, success, vendor)
         
         return result
             
-    except subprocess.TimeoutExpired:
-        process.kill()
+    except CECTimeout:
         result = f"Command timed out: {command}"
         log_command(command, result, False, vendor)
         return result
@@ -231,58 +209,107 @@ def execute_cec_command(command, timeout=15, vendor="unknown"):
         log_command(command, result, False, vendor)
         return result
 
+def _watch_bus():
+    """Let bus traffic seen by the backend invalidate the device cache"""
+    global _cache_listening
+    if not _cache_listening:
+        get_backend().add_listener(DEVICE_CACHE.on_session_line)
+        _cache_listening = True
+
+def _scan_bus(timeout=15):
+    """Run a scan and refresh the device cache from its output"""
+    _watch_bus()
+    try:
+        success, output = get_scheduler().execute("scan", timeout=timeout)
+    except CECTimeout:
+        result = "Command timed out: scan"
+        log_command("scan", result, False)
+        return result, []
+    
+    result = f"Command executed: scan\nOutput: {output}" if success else f"Command failed: {output}"
+    log_command("scan", result, success)
+    devices = DEVICE_CACHE.update_from_scan(output) if success else []
+    return result, devices
+
+def classify_vendor(devices):
+    """Map scanned devices onto a VENDOR_CONFIGS key"""
+    vendor_lower = " ".join(
+        f"{device.get('vendor', '')} {device.get('name', '')}" for device in devices
+    ).lower()
+    
+    if "optoma" in vendor_lower:
+        return "optoma"
+    elif "nec" in vendor_lower:
+        return "nec"
+    elif "epson" in vendor_lower:
+        return "epson"
+    elif "samsung" in vendor_lower:
+        return "samsung"
+    elif "lg" in vendor_lower:
+        return "lg"
+    else:
+        return "generic"
+
 def get_device_vendor():
-    """Detect device vendor from CEC scan"""
+    """Detect device vendor, scanning the bus only when the cache is cold"""
     try:
-        scan_result = execute_cec_command("scan", timeout=10)
-        vendor_lower = scan_result.lower()
-        
-        if "optoma" in vendor_lower:
-            return "optoma"
-        elif "nec" in vendor_lower:
-            return "nec"
-        elif "epson" in vendor_lower:
-            return "epson"
-        elif "samsung" in vendor_lower:
-            return "samsung"
-        elif "lg" in vendor_lower:
-            return "lg"
+        devices = DEVICE_CACHE.get_devices()
+        if devices is None:
+            # Vendors announced on the bus are as good as a scan
+            devices = [device for device in get_bus_state().devices_known() if device["vendor"] != "Unknown"]
+            if devices:
+                logger.info("Using vendors seen on the bus")
+                return classify_vendor(devices)
+            _, devices = _scan_bus(timeout=10)
         else:
-            return "generic"
+            logger.info("Using cached device list")
+        return classify_vendor(devices)
     except Exception as e:
         logger.error(f"Error detecting vendor: {e}")
         return "generic"
 
-def epson_cec_reset():
-    """Reset CEC link for Epson projectors (simulates manual CEC toggle)"""
-    logger.info("Performing Epson CEC reset sequence")
-    reset_commands = [
-        "tx 10:8C",  # Get Vendor ID
-        "tx 10:83",  # Get Physical Address
-        "tx 10:46",  # Get OSD Name
-    ]
+def refresh_devices():
+    """Drop the device cache and rescan the bus"""
+    DEVICE_CACHE.invalidate("refresh requested")
+    return scan_devices()
+
+# Wakes the CEC link of Epson projectors (simulates manual CEC toggle)
+EPSON_RESET_COMMANDS = [
+    "tx 10:8C",  # Get Vendor ID
+    "tx 10:83",  # Get Physical Address
+    "tx 10:46",  # Get OSD Name
+]
+
+def vendor_power_on_sequence(vendor):
+    """VENDOR_CONFIGS power-on recipe as a SEQUENCE request"""
+    config = VENDOR_CONFIGS[vendor]
+    steps = []
     
-    for cmd in reset_commands:
-        execute_cec_command(cmd)
-        time.sleep(0.5)
+    # Epson-specific: CEC reset first, then wait before waking
+    if vendor == "epson" and config.get("requires_cec_reset", False):
+        steps.extend({"cec": cmd, "delay": 0.5} for cmd in EPSON_RESET_COMMANDS)
+        steps[-1]["delay"] += 1.0
     
-    logger.info("Epson CEC reset complete")
+    steps.extend({"cec": cmd, "delay": config.get("power_on_delay", 0.5)} for cmd in config["power_on_sequence"])
+    
+    return {
+        "command": "SEQUENCE",
+        "steps": steps,
+        "attempts": config.get("retry_count", 1),
+        "settle": 2.0,  # Longest wait for the device to respond
+        "until": {"cec": "pow 0", "match": r"power status:\s*on\b"},
+        # Delays are upper bounds: stop waiting once the device is on, and learn how long it took
+        "adaptive": True,
+    }
 
 def vendor_specific_power_on(vendor="generic"):
     """Execute vendor-specific power-on sequence with logging"""
-    if vendor not in VENDOR_CONFIGS:
+    if vendor not in VENDOR_CONFIGS or "power_on_sequence" not in VENDOR_CONFIGS[vendor]:
         return execute_cec_command("on 0", vendor=vendor)
     
     config = VENDOR_CONFIGS[vendor]
-    results = []
-    
     logger.info(f"Starting {vendor} power-on sequence")
     
-    # Epson-specific: Perform CEC reset first
-    if vendor == "epson" and config.get("requires_cec_reset", False):
-        epson_cec_reset()
-        time.sleep(1)  # Wait after reset
-    
     # Set CEC version if required (NEC projectors)
     if "requires_cec_version" in config:
         version_cmd = f"cec-ctl -d0 --tv --cec-version-{config['requires_cec_version']}"
@@ -292,34 +319,14 @@ def vendor_specific_power_on(vendor="generic"):
         except Exception as e:
             logger.warning(f"Failed to set CEC version: {e}")
     
-    # Execute power-on sequence
-    for attempt in range(config.get("retry_count", 1)):
-        logger.info(f"Power-on attempt {attempt + 1} for {vendor}")
-        
-        sequence_success = True
-        for cmd in config["power_on_sequence"]:
-            result = execute_cec_command(cmd, vendor=vendor)
-            results.append(result)
-            
-            # Check if individual command succeeded
-            if "failed" in result.lower() or "error" in result.lower():
-                sequence_success = False
-            
-            time.sleep(config.get("power_on_delay", 0.5))
-        
-        # Check if successful
-        time.sleep(2)  # Wait for device to respond
-        status = execute_cec_command("pow 0", vendor=vendor)
-        if "on" in status.lower():
-            # Log successful sequence
-            sequence_cmd = " && ".join(config["power_on_sequence"])
-            log_command(f"SEQUENCE: {sequence_cmd}", f"Power-on successful after {attempt + 1} attempts", True, vendor)
-            return f"✅ Power-on successful after {attempt + 1} attempts\n" + "\n".join(results)
+    # Whole recipe, retries included, runs through the shared scheduler
+    steps = []
+    success, summary = run_adaptive(get_scheduler(), parse_sequence(vendor_power_on_sequence(vendor)),
+                                    get_timing_store(), steps.append)
     
-    # Log failed sequence
     sequence_cmd = " && ".join(config["power_on_sequence"])
-    log_command(f"SEQUENCE: {sequence_cmd}", f"Power-on failed after {config.get('retry_count', 1)} attempts", False, vendor)
-    return f"❌ Power-on failed after {config.get('retry_count', 1)} attempts\n" + "\n".join(results)
+    log_command(f"SEQUENCE: {sequence_cmd}", summary, success, vendor)
+    return summary + "\n" + "\n".join(steps)
 
 def vendor_specific_power_off(vendor="generic"):
     """Execute vendor-specific power-off sequence"""
@@ -402,30 +409,8 @@ def send_core_command(command_name):
 
 def scan_devices():
     """Enhanced device scanning with vendor detection"""
-    raw_result = execute_cec_command("scan", timeout=15)
-    
-    # Parse and extract useful info
-    devices = []
-    lines = raw_result.split('\n')
-    
-    current_device = {}
-    for line in lines:
-        line = line.strip()
-        if line.startswith('device #'):
-            if current_device:
-                devices.append(current_device)
-            current_device = {'number': line.split(':')[0].replace('device #', '')}
-        elif line.startswith('address:'):
-            current_device['address'] = line.split(':', 1)[1].strip()
-        elif line.startswith('vendor:'):
-            current_device['vendor'] = line.split(':', 1)[1].strip()
-        elif line.startswith('osd string:'):
-            current_device['name'] = line.split(':', 1)[1].strip()
-        elif line.startswith('power status:'):
-            current_device['power'] = line.split(':', 1)[1].strip()
-    
-    if current_device:
-        devices.append(current_device)
+    # Always a live scan; it also warms the cache for later commands
+    _, devices = _scan_bus(timeout=15)
     
     # Filter out the Pi itself
     real_devices = []
@@ -469,9 +454,10 @@ def get_brightsign_export():
 def get_command_log():
     """Get recent command history"""
     return {
-        "recent_commands": COMMAND_HISTORY[-10:],  # Last 10 commands
-        "successful_commands": len(SUCCESSFUL_COMMANDS),
-        "total_commands": len(COMMAND_HISTORY)
+        "recent_commands": HISTORY.last(10),  # Last 10 commands
+        "successful_commands": HISTORY.successful,
+        "total_commands": HISTORY.total,
+        "journaled_commands": HISTORY.journaled()
     }
 
 def get_device_info():
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Persistent cec-client session
+Keeps one cec-client process (and one adapter registration) alive for the
+whole daemon lifetime instead of starting a new client for every command.
+"""
+import os
+import re
+import subprocess
+import threading
+import time
+import logging
+import latency
+from cec_backend import CECBackendError, CECTimeout
+
+logger = logging.getLogger("cec_session")
+
+# Overridable so the daemon can be driven by a stand-in client on a host
+CEC_CLIENT_BIN = os.environ.get("CEC_CLIENT_BIN", "cec-client")
+
+# Printed by cec-client once the adapter is open and it accepts commands
+READY_MARKER = "waiting for input"
+
+# Error + traffic logging, so transmits are confirmed by a ">>" line
+DEFAULT_LOG_LEVEL = 9
+
+# Output line that completes a query, keyed by cec-client command verb
+DONE_PATTERNS = {
+    "scan": re.compile(r"currently active source", re.I),
+    "pow": re.compile(r"power status:", re.I),
+    "ven": re.compile(r"vendor id:", re.I),
+    "name": re.compile(r"osd name", re.I),
+    "ver": re.compile(r"cec version", re.I),
+    "poll": re.compile(r"POLL message", re.I),
+    "lad": re.compile(r"logical address", re.I),
+}
+
+# Commands that put a frame on the bus and finish with a traffic line
+TRANSMIT_VERBS = ("tx", "txn", "on", "standby", "as", "is", "volup", "voldown", "mute", "osd")
+
+ERROR_PATTERN = re.compile(r"ERROR|not acked|failed", re.I)
+TRAFFIC_OUT_PATTERN = re.compile(r">>\s")
+
+# Grace period after the completing line to catch a trailing error
+TRANSMIT_GRACE = 0.05
+# Quiet period that ends a command without a known completion line
+SETTLE_TIME = 0.5
+
+STARTUP_TIMEOUT = 15
+
+
+class CECSessionError(CECBackendError):
+    """Raised when the cec-client session cannot run a command"""
+
+
+class CECSessionTimeout(CECSessionError, CECTimeout):
+    """Raised when a command produced no completion within its timeout"""
+
+
+class CECSession:
+    name = "cec-client"
+    min_gap = 0.0              # libcec paces the bus itself
+
+    def __init__(self, binary=None, port=None, log_level=DEFAULT_LOG_LEVEL):
+        self.binary = binary or CEC_CLIENT_BIN
+        self.port = port
+        self.log_level = log_level
+        self.process = None
+        self.reader_thread = None
+        self.listeners = []
+        self.restart_count = 0
+
+        # Serialises commands; only one command owns the output at a time
+        self.command_lock = threading.Lock()
+        self.cond = threading.Condition()
+        self.ready = False
+        self.capture = None
+        self.last_output = 0.0
+
+    def add_listener(self, callback):
+        """Register callback(line) for every line cec-client prints"""
+        self.listeners.append(callback)
+
+    def is_alive(self):
+        return self.process is not None and self.process.poll() is None
+
+    def start(self):
+        """Start cec-client and wait until the adapter is open"""
+        args = [self.binary, '-d', str(self.log_level)]
+        if self.port:
+            args.append(self.port)
+
+        logger.info("Starting cec-client session: " + " ".join(args))
+        with self.cond:
+            self.ready = False
+            self.capture = None
+
+        self.process = subprocess.Popen(
+            args,
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            universal_newlines=True,
+            bufsize=1
+        )
+
+        self.reader_thread = threading.Thread(target=self._reader_loop, args=(self.process,))
+        self.reader_thread.daemon = True
+        self.reader_thread.start()
+
+        deadline = time.monotonic() + STARTUP_TIMEOUT
+        with self.cond:
+            while not self.ready and self.process.poll() is None:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    break
+                self.cond.wait(remaining)
+            ready = self.ready
+
+        if not ready:
+            self._terminate()
+            raise CECSessionError("cec-client did not become ready")
+
+        logger.info("cec-client session ready")
+        return True
+
+    def stop(self):
+        """Quit cec-client and release the adapter"""
+        with self.command_lock:
+            if self.is_alive():
+                try:
+                    self.process.stdin.write("q\n")
+                    self.process.stdin.flush()
+                    self.process.wait(timeout=2)
+                except Exception:
+                    pass
+            self._terminate()
+
+    def _terminate(self):
+        if self.process is None:
+            return
+        if self.process.poll() is None:
+            self.process.kill()
+            try:
+                self.process.wait(timeout=2)
+            except Exception:
+                pass
+        self.process = None
+
+    def _ensure_running(self):
+        if not self.is_alive():
+            if self.process is not None:
+                self.restart_count += 1
+                logger.warning("cec-client exited, restarting session")
+            self._terminate()
+            self.start()
+
+    def _reader_loop(self, process):
+        for line in process.stdout:
+            line = line.rstrip('\r\n')
+            if not line:
+                continue
+            with self.cond:
+                if not self.ready and READY_MARKER in line:
+                    self.ready = True
+                if self.capture is not None:
+                    self.capture.append(line)
+                self.last_output = time.monotonic()
+                self.cond.notify_all()
+            for callback in self.listeners:
+                try:
+                    callback(line)
+                except Exception as e:
+                    logger.error("Session listener error: " + str(e))
+
+        # EOF: the child died, wake up anyone waiting on it
+        with self.cond:
+            self.cond.notify_all()
+
+    def execute(self, command, timeout=10):
+        """Run one command on the session, returns (success, output)"""
+        queued = time.monotonic()
+        with self.command_lock:
+            started = time.monotonic()
+            # A session (re)started for this command is not started again when it fails
+            fresh = not self.is_alive()
+            try:
+                self._ensure_running()
+                return self._execute_locked(command, timeout)
+            except (BrokenPipeError, CECSessionError) as e:
+                if isinstance(e, CECSessionTimeout):
+                    raise
+                if fresh:
+                    raise CECSessionError(str(e) or "cec-client session lost") from e
+                # Child died underneath us: restart once and retry
+                logger.warning("cec-client session lost (" + str(e) + "), retrying")
+                self._terminate()
+                self.restart_count += 1
+                self.start()
+                return self._execute_locked(command, timeout)
+            finally:
+                latency.note_cec(started - queued, time.monotonic() - started)
+
+    def _execute_locked(self, command, timeout):
+        verb = command.split(' ', 1)[0].lower()
+        done_pattern = DONE_PATTERNS.get(verb)
+        is_transmit = verb in TRANSMIT_VERBS
+        process = self.process
+
+        with self.cond:
+            self.capture = []
+            self.last_output = time.monotonic()
+
+        try:
+            process.stdin.write(command + '\n')
+            process.stdin.flush()
+
+            start = time.monotonic()
+            deadline = start + timeout
+            done_at = None
+            with self.cond:
+                while True:
+                    now = time.monotonic()
+                    if process.poll() is not None:
+                        raise CECSessionError("cec-client exited during command")
+
+                    if done_at is None:
+                        for line in self.capture:
+                            if done_pattern is not None and done_pattern.search(line):
+                                done_at = now
+                            elif is_transmit and TRAFFIC_OUT_PATTERN.search(line):
+                                done_at = now + TRANSMIT_GRACE
+                            elif ERROR_PATTERN.search(line):
+                                done_at = now
+                            if done_at is not None:
+                                break
+
+                    if done_at is not None and now >= done_at:
+                        break
+                    if done_pattern is None and done_at is None and now - self.last_output >= SETTLE_TIME:
+                        break
+                    if now >= deadline:
+                        raise CECSessionTimeout("Command timed out: " + command)
+
+                    wake = deadline
+                    if done_at is not None:
+                        wake = min(wake, done_at)
+                    elif done_pattern is None:
+                        wake = min(wake, self.last_output + SETTLE_TIME)
+                    self.cond.wait(max(wake - now, 0.001))
+
+                output = "\n".join(self.capture)
+        finally:
+            with self.cond:
+                self.capture = None
+
+        success = not ERROR_PATTERN.search(output)
+        if is_transmit and done_at is None:
+            # No traffic line: cec-client never said the frame went out
+            return False, (output + "\n" if output else "") + "ERROR:   transmit unconfirmed: " + command
+        return success, output
+
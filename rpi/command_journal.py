@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Bounded command history with an append-only on-disk journal
+Recent commands live in fixed-size in-memory rings. Every entry is also
+appended to a journal of JSON lines, split into segments that rotate by
+size, with an index file per segment holding the byte offset of each line.
+"Last N" reads and exports seek through the index instead of walking or
+re-formatting the whole history, so their cost depends on N only.
+Successful commands get a journal of their own for the same reason, and an
+export returns the newest EXPORT_LIMIT records unless asked for fewer; the
+whole retained export is only ever streamed to a file (write_export()).
+
+Layout of a journal called "commands" in its directory:
+  commands.000001.jsonl   one JSON object per line
+  commands.000001.idx     little-endian u64 offset of each line, 8 bytes each
+"""
+import os
+import re
+import json
+import struct
+import threading
+import logging
+from collections import deque
+from datetime import datetime
+
+logger = logging.getLogger("command_journal")
+
+DEFAULT_DIR = os.environ.get("CEC_JOURNAL_DIR", "/var/tmp/cec_journal")   # survives reboots
+DEFAULT_RING_SIZE = int(os.environ.get("CEC_HISTORY_SIZE", "100"))
+DEFAULT_SEGMENT_BYTES = int(os.environ.get("CEC_JOURNAL_SEGMENT_BYTES", str(256 * 1024)))
+DEFAULT_SEGMENTS = int(os.environ.get("CEC_JOURNAL_SEGMENTS", "4"))
+# BrightSign records an export returns at most; write_export() has them all
+EXPORT_LIMIT = int(os.environ.get("CEC_EXPORT_LIMIT", "500"))
+
+INDEX_ENTRY = struct.Struct("<Q")
+
+
+def brightsign_entry(entry):
+    """BrightSign export record for a logged tx command, None for anything else"""
+    cec_cmd = entry.get("raw_cec_command")
+    if not cec_cmd or not cec_cmd.startswith("tx "):
+        return None
+    # Remove "tx " and convert to ASCII string
+    hex_part = cec_cmd[3:].replace(":", "")
+    return {
+        "description": f"Vendor: {entry['vendor']} | Original: {cec_cmd}",
+        "brightsign_ascii": hex_part,
+        "brightsign_command": f'BrightControl Send Ascii String "{hex_part}"',
+        "timestamp": entry["timestamp"]
+    }
+
+
+class Journal:
+    """Append-only JSON lines in rotating segments, each with an offset index"""
+
+    def __init__(self, directory, name, segment_bytes=DEFAULT_SEGMENT_BYTES, segments=DEFAULT_SEGMENTS):
+        self.directory = directory
+        self.name = name
+        self.segment_bytes = segment_bytes
+        self.max_segments = max(1, segments)
+        self.lock = threading.Lock()
+        self.pattern = re.compile(re.escape(name) + r"\.(\d{6})\.jsonl$")
+
+        os.makedirs(directory, exist_ok=True)
+        self.segments = self._find_segments()
+        if not self.segments:
+            self.segments = [1]
+        self.data = None
+        self.index = None
+        self._open(self.segments[-1])
+
+    def _find_segments(self):
+        numbers = []
+        for filename in os.listdir(self.directory):
+            match = self.pattern.match(filename)
+            if match:
+                numbers.append(int(match.group(1)))
+        return sorted(numbers)
+
+    def _paths(self, number):
+        base = os.path.join(self.directory, f"{self.name}.{number:06d}")
+        return base + ".jsonl", base + ".idx"
+
+    def _open(self, number):
+        data_path, index_path = self._paths(number)
+        self.data = open(data_path, "ab+")
+        self.index = open(index_path, "ab+")
+        self._recover(number)
+
+    def _recover(self, number):
+        """Make the index match the data after a crash between the two writes"""
+        data_size = self.data.seek(0, os.SEEK_END)
+        index_size = self.index.seek(0, os.SEEK_END)
+        count = index_size // INDEX_ENTRY.size
+        last = self._offsets(self.index, count - 1, 1)[0] if count else None
+
+        # Normal case: the last indexed line ends exactly at the end of the data
+        if index_size % INDEX_ENTRY.size == 0 and last is not None:
+            self.data.seek(last)
+            if last + len(self.data.readline()) == data_size:
+                return
+        elif index_size == 0 and data_size == 0:
+            return
+
+        logger.warning(f"Rebuilding index of {self.name} segment {number}")
+        offsets = []
+        self.data.seek(0)
+        offset = 0
+        for line in self.data:
+            if not line.endswith(b"\n"):
+                break
+            offsets.append(offset)
+            offset += len(line)
+        # Drop a torn last line and rewrite the index from scratch
+        self.data.truncate(offset)
+        self.index.truncate(0)
+        self.index.write(b"".join(INDEX_ENTRY.pack(o) for o in offsets))
+        self.index.flush()
+
+    @staticmethod
+    def _offsets(index, first, count):
+        index.seek(first * INDEX_ENTRY.size)
+        raw = index.read(count * INDEX_ENTRY.size)
+        return [INDEX_ENTRY.unpack_from(raw, i)[0] for i in range(0, len(raw), INDEX_ENTRY.size)]
+
+    def _rotate(self):
+        self.data.close()
+        self.index.close()
+        self.segments.append(self.segments[-1] + 1)
+        while len(self.segments) > self.max_segments:
+            for path in self._paths(self.segments.pop(0)):
+                try:
+                    os.remove(path)
+                except OSError:
+                    pass
+        self._open(self.segments[-1])
+        logger.info(f"Journal {self.name} rotated to segment {self.segments[-1]}")
+
+    def append(self, record):
+        """Append one record; the line is written before its index entry"""
+        line = (json.dumps(record, ensure_ascii=False) + "\n").encode("utf-8")
+        with self.lock:
+            offset = self.data.seek(0, os.SEEK_END)
+            if offset and offset + len(line) > self.segment_bytes:
+                self._rotate()
+                offset = 0
+            self.data.write(line)
+            self.data.flush()
+            self.index.write(INDEX_ENTRY.pack(offset))
+            self.index.flush()
+
+    def _segment_count(self, number):
+        _, index_path = self._paths(number)
+        try:
+            return os.path.getsize(index_path) // INDEX_ENTRY.size
+        except OSError:
+            return 0
+
+    def count(self):
+        """Records in the retained segments, from index sizes alone"""
+        with self.lock:
+            return sum(self._segment_count(number) for number in self.segments)
+
+    def last(self, n):
+        """The newest n records, oldest first"""
+        if n <= 0:
+            return []
+        records = []
+        with self.lock:
+            for number in reversed(self.segments):
+                wanted = n - len(records)
+                if wanted <= 0:
+                    break
+                records[:0] = self._read_segment_tail(number, wanted)
+        return records
+
+    def _read_segment_tail(self, number, wanted):
+        data_path, index_path = self._paths(number)
+        try:
+            with open(index_path, "rb") as index, open(data_path, "rb") as data:
+                count = os.fstat(index.fileno()).st_size // INDEX_ENTRY.size
+                first = max(0, count - wanted)
+                records = []
+                for offset in self._offsets(index, first, count - first):
+                    data.seek(offset)
+                    records.append(json.loads(data.readline()))
+                return records
+        except (OSError, ValueError) as e:
+            logger.error(f"Journal {self.name} segment {number} unreadable: {e}")
+            return []
+
+    def iter_lines(self):
+        """Every retained record as its raw JSON line, oldest first"""
+        with self.lock:
+            paths = [self._paths(number)[0] for number in self.segments]
+        for path in paths:
+            try:
+                with open(path, "rb") as data:
+                    for line in data:
+                        if line.endswith(b"\n"):
+                            yield line.decode("utf-8").rstrip("\n")
+            except OSError:
+                continue
+
+    def clear(self):
+        with self.lock:
+            self.data.close()
+            self.index.close()
+            for number in self.segments:
+                for path in self._paths(number):
+                    try:
+                        os.remove(path)
+                    except OSError:
+                        pass
+            self.segments = [self.segments[-1] + 1]
+            self._open(self.segments[-1])
+
+
+class CommandHistory:
+    """Recent commands in memory, every command in the journal"""
+
+    def __init__(self, directory=DEFAULT_DIR, ring_size=DEFAULT_RING_SIZE, **journal_options):
+        self.lock = threading.Lock()
+        self.recent = deque(maxlen=ring_size)
+        self.recent_successful = deque(maxlen=ring_size)
+        self.total = 0           # Since start, like the lists this replaces
+        self.successful = 0
+        try:
+            self.commands = Journal(directory, "commands", **journal_options)
+            self.successful_commands = Journal(directory, "successful", **journal_options)
+            self.brightsign = Journal(directory, "brightsign", **journal_options)
+        except OSError as e:
+            # Keep running on memory alone when the disk is read-only or full
+            logger.error(f"Command journal disabled: {e}")
+            self.commands = None
+            self.successful_commands = None
+            self.brightsign = None
+
+    def record(self, entry):
+        """Add one log_command() entry; BrightSign format is computed here, once"""
+        export = brightsign_entry(entry) if entry["success"] else None
+        with self.lock:
+            self.recent.append(entry)
+            self.total += 1
+            if entry["success"]:
+                self.recent_successful.append(entry)
+                self.successful += 1
+        if self.commands is None:
+            return
+        try:
+            self.commands.append(entry)
+            if entry["success"]:
+                self.successful_commands.append(entry)
+            if export:
+                self.brightsign.append(export)
+        except OSError as e:
+            logger.error(f"Command journal write failed: {e}")
+
+    def last(self, n, successful_only=False):
+        """The newest n entries, from the ring while it holds enough and from the journal beyond"""
+        if n <= 0:
+            return []
+        with self.lock:
+            ring = list(self.recent_successful if successful_only else self.recent)
+        journal = self.successful_commands if successful_only else self.commands
+        if n <= len(ring) or journal is None:
+            return ring[-n:]
+        return journal.last(n)
+
+    def journaled(self):
+        """Commands kept on disk, across restarts and up to the rotation limit"""
+        return self.commands.count() if self.commands is not None else 0
+
+    def brightsign_export(self, limit=None):
+        """The newest limit pre-converted BrightSign records, never more than EXPORT_LIMIT"""
+        if self.brightsign is None:
+            return []
+        return self.brightsign.last(EXPORT_LIMIT if limit is None else min(limit, EXPORT_LIMIT))
+
+    def write_export(self, filename):
+        """Stream the export to a file without holding every record in memory"""
+        with self.lock:
+            recent = list(self.recent_successful)
+            successful = self.successful
+        with open(filename, "w") as f:
+            f.write("{\n")
+            f.write(f'  "export_time": {json.dumps(datetime.now().isoformat())},\n')
+            f.write(f'  "total_successful_commands": {successful},\n')
+            f.write(f'  "commands": {json.dumps(recent, indent=2)},\n')
+            f.write('  "brightsign_format": [')
+            first = True
+            for line in (self.brightsign.iter_lines() if self.brightsign else []):
+                f.write(("\n    " if first else ",\n    ") + line)
+                first = False
+            f.write("\n  ]\n}\n" if not first else "]\n}\n")
+
+    def clear(self):
+        with self.lock:
+            self.recent.clear()
+            self.recent_successful.clear()
+            self.total = 0
+            self.successful = 0
+        if self.commands is not None:
+            self.commands.clear()
+            self.successful_commands.clear()
+            self.brightsign.clear()
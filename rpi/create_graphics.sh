@@ -64,4 +64,5 @@ echo "🎯 Graphics system ready!"
 echo "   ✅ 4 status images created in $USER_HOME"
 echo "   ✅ Ready for instant display updates"
 echo ""
-echo "Test with: python3 $USER_HOME/update_display.py ready"
+echo "Load them with: sudo systemctl restart cec-display"
+echo "Test with: python3 /opt/cec-flipper/update_display.py ready"
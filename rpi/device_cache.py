@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Cache of CEC devices found by scan, keyed by logical and physical address
+Entries expire after a TTL and are dropped as soon as bus traffic says a
+device changed: a hot-plug notice from cec-client or a Report Physical
+Address that does not match clears the cache, as does a Device Vendor ID
+that differs from the cached vendor. The same vendor announced again, as
+devices do when they wake up, changes nothing.
+"""
+import os
+import re
+import threading
+import time
+import logging
+
+logger = logging.getLogger("device_cache")
+
+DEFAULT_TTL = float(os.environ.get("CEC_DEVICE_CACHE_TTL", "300"))
+
+# CEC opcodes that announce a (possibly new) device identity
+OPCODE_REPORT_PHYSICAL_ADDRESS = 0x84
+OPCODE_DEVICE_VENDOR_ID = 0x87
+
+# Vendor IDs as libcec names them, so as cec-client prints them in scan output
+VENDOR_NAMES = {
+    0x000039: "Toshiba", 0x0000F0: "Samsung", 0x0005CD: "Denon", 0x000678: "Marantz", 0x000982: "Loewe",
+    0x0009B0: "Onkyo", 0x000CB8: "Medion", 0x000CE7: "Toshiba", 0x0010FA: "Apple", 0x001582: "Pulse Eight",
+    0x001950: "Harman/Kardon", 0x001A11: "Google", 0x0020C7: "Akai", 0x002467: "AOC", 0x008045: "Panasonic",
+    0x00903E: "Philips", 0x009053: "Daewoo", 0x00A0DE: "Yamaha", 0x00D0D5: "Grundig", 0x00E036: "Pioneer",
+    0x00E091: "LG", 0x08001F: "Sharp", 0x080046: "Sony", 0x18C086: "Broadcom", 0x534850: "Sharp",
+    0x6B746D: "Vizio", 0x8065E9: "Benq", 0x9C645E: "Harman/Kardon",
+}
+
+# Received frame in cec-client output: "TRAFFIC: [  1234]\t<< 4f:84:10:00:04"
+TRAFFIC_PATTERN = re.compile(r"<<\s+([0-9a-fA-F]{2}(?::[0-9a-fA-F]{2})*)")
+HOTPLUG_PATTERN = re.compile(r"hot.?plug|physical address changed", re.IGNORECASE)
+
+
+def parse_scan(output):
+    """Turn cec-client scan output into a list of device dicts"""
+    devices = []
+    current_device = {}
+    for line in output.split('\n'):
+        line = line.strip()
+        if line.startswith('device #'):
+            if current_device:
+                devices.append(current_device)
+            current_device = {'number': line.split(':')[0].replace('device #', '')}
+        elif line.startswith('address:'):
+            current_device['address'] = line.split(':', 1)[1].strip()
+        elif line.startswith('vendor:'):
+            current_device['vendor'] = line.split(':', 1)[1].strip()
+        elif line.startswith('osd string:'):
+            current_device['name'] = line.split(':', 1)[1].strip()
+        elif line.startswith('power status:'):
+            current_device['power'] = line.split(':', 1)[1].strip()
+
+    if current_device:
+        devices.append(current_device)
+    return devices
+
+
+def format_physical(high, low):
+    """Two physical address bytes as the dotted form scan prints"""
+    return f"{high >> 4:x}.{high & 0xF:x}.{low >> 4:x}.{low & 0xF:x}"
+
+
+class DeviceCache:
+    def __init__(self, ttl=DEFAULT_TTL):
+        self.ttl = ttl
+        self.lock = threading.Lock()
+        self.devices = {}        # logical address -> device dict
+        self.by_physical = {}    # physical address -> logical address
+        self.updated = None      # monotonic time of the last scan, None when cold
+        self.hits = 0
+        self.misses = 0
+
+    def is_fresh(self):
+        with self.lock:
+            return self._fresh()
+
+    def _fresh(self):
+        return self.updated is not None and time.monotonic() - self.updated < self.ttl
+
+    def update_from_scan(self, output):
+        """Replace the cache with the devices in one scan"""
+        devices = parse_scan(output)
+        with self.lock:
+            self.devices = {}
+            self.by_physical = {}
+            for device in devices:
+                try:
+                    logical = int(device.get('number', ''), 16)
+                except ValueError:
+                    continue
+                self.devices[logical] = device
+                if 'address' in device:
+                    self.by_physical[device['address']] = logical
+            self.updated = time.monotonic()
+        return devices
+
+    def get_devices(self):
+        """Cached devices, or None when the cache is cold or expired"""
+        with self.lock:
+            if not self._fresh():
+                self.misses += 1
+                return None
+            self.hits += 1
+            return list(self.devices.values())
+
+    def get_device(self, logical):
+        with self.lock:
+            return self.devices.get(logical) if self._fresh() else None
+
+    def get_device_at(self, physical):
+        """Device at a dotted physical address such as 1.0.0.0"""
+        with self.lock:
+            if not self._fresh() or physical not in self.by_physical:
+                return None
+            return self.devices.get(self.by_physical[physical])
+
+    def invalidate(self, reason="", logical=None, physical=None):
+        """Forget the bus after a change; an address that still matches is a no-op
+
+        Vendor detection looks at every device, so any real change clears
+        the whole cache rather than a single entry.
+        """
+        with self.lock:
+            if logical is None and physical is None:
+                if self.updated is not None:
+                    logger.info(f"Device cache cleared: {reason}")
+                self.devices = {}
+                self.by_physical = {}
+                self.updated = None
+                return
+
+            device = self.devices.get(logical)
+            if device and physical is not None and device.get('address') == physical:
+                # Same device at the same address, nothing changed
+                return
+
+            # A device appeared or moved; vendor detection must look again
+            logger.info(f"Device cache invalidated ({reason}): logical {logical} physical {physical}")
+            self.devices = {}
+            self.by_physical = {}
+            self.updated = None
+
+    def note_vendor(self, logical, vendor_id):
+        """Device Vendor ID seen on the bus; clears the cache if it names another vendor
+
+        A device the last scan did not see is left to its Report Physical
+        Address, which it announces first.
+        """
+        vendor = VENDOR_NAMES.get(vendor_id, f"0x{vendor_id:06x}")
+        with self.lock:
+            device = self.devices.get(logical)
+            if device is None or device.get('vendor', '').lower() == vendor.lower():
+                return
+            previous = device.get('vendor')
+        self.invalidate(f"vendor of {logical:x} changed from {previous} to {vendor}")
+
+    def on_session_line(self, line):
+        """cec-client session listener: watch the bus for identity changes"""
+        if HOTPLUG_PATTERN.search(line):
+            self.invalidate("hot plug")
+            return
+
+        match = TRAFFIC_PATTERN.search(line)
+        if not match:
+            return
+        frame = [int(b, 16) for b in match.group(1).split(':')]
+        if len(frame) < 2:
+            return
+        initiator = frame[0] >> 4
+        opcode = frame[1]
+        if opcode == OPCODE_REPORT_PHYSICAL_ADDRESS and len(frame) >= 4:
+            self.invalidate("report physical address", logical=initiator,
+                            physical=format_physical(frame[2], frame[3]))
+        elif opcode == OPCODE_DEVICE_VENDOR_ID and len(frame) >= 5:
+            self.note_vendor(initiator, (frame[2] << 16) | (frame[3] << 8) | frame[4])
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Incremental CEC device discovery
+Polls logical addresses 0-14 one by one and asks vendor, OSD name and
+power status only of addresses that ACK, handing each device record to a
+callback as soon as it is known instead of waiting for a full cec-client
+scan. Later runs re-query only devices that are new or whose bus traffic
+(standby, vendor ID, OSD name, power or address reports) showed a change;
+everything else is answered from the previous run.
+"""
+import re
+import threading
+import time
+import logging
+
+logger = logging.getLogger("discovery")
+
+LOGICAL_ADDRESSES = range(15)        # 15 is broadcast / unregistered
+
+POLL_TIMEOUT = 2
+QUERY_TIMEOUT = 3
+
+# Traffic after our own queries that is still their replies
+QUIET_AFTER_RUN = 0.3
+
+# Opcodes a device sends when its identity or power state changes
+STATE_OPCODES = {
+    0x36,  # Standby
+    0x47,  # Set OSD Name
+    0x82,  # Active Source
+    0x84,  # Report Physical Address
+    0x87,  # Device Vendor ID
+    0x90,  # Report Power Status
+    0x9D,  # Inactive Source
+}
+
+RECEIVED_PATTERN = re.compile(r"<<\s+([0-9a-fA-F]{2}):([0-9a-fA-F]{2})")
+POLL_ACK_PATTERN = re.compile(r"POLL message sent", re.I)
+VENDOR_PATTERN = re.compile(r"vendor id:\s*(.+)", re.I)
+NAME_PATTERN = re.compile(r"osd name of device \w+ is '([^']*)'", re.I)
+POWER_PATTERN = re.compile(r"power status:\s*(.+)", re.I)
+
+
+def format_device(device):
+    """One device as the line sent to the Flipper"""
+    if not device.get("present", True):
+        return f"#{device['logical']:X} gone"
+    return f"#{device['logical']:X} {device['name'] or '?'} ({device['vendor']}) - {device['power']}"
+
+
+class Discovery:
+    def __init__(self, session):
+        self.session = session
+        self.lock = threading.Lock()
+        self.run_lock = threading.Lock()   # One discovery at a time
+        self.devices = {}          # logical address -> last known record
+        self.dirty = set()         # addresses whose traffic showed a change
+        self.running = False
+        self.quiet_until = 0.0
+        session.add_listener(self.on_session_line)
+
+    def on_session_line(self, line):
+        """Mark devices dirty when they announce a state change on the bus"""
+        match = RECEIVED_PATTERN.search(line)
+        if not match:
+            return
+        initiator = int(match.group(1), 16) >> 4
+        opcode = int(match.group(2), 16)
+        if opcode not in STATE_OPCODES:
+            return
+        with self.lock:
+            # Replies to our own queries are not changes
+            if self.running or time.monotonic() < self.quiet_until:
+                return
+            self.dirty.add(initiator)
+
+    def _query(self, command, pattern, default):
+        success, output = self.session.execute(command, timeout=QUERY_TIMEOUT)
+        match = pattern.search(output) if success else None
+        return match.group(1).strip() if match else default
+
+    def _poll(self, logical):
+        success, output = self.session.execute(f"poll {logical:x}", timeout=POLL_TIMEOUT)
+        return success and bool(POLL_ACK_PATTERN.search(output))
+
+    def _identify(self, logical):
+        return {
+            "logical": logical,
+            "present": True,
+            "vendor": self._query(f"ven {logical:x}", VENDOR_PATTERN, "Unknown"),
+            "name": self._query(f"name {logical:x}", NAME_PATTERN, ""),
+            "power": self._query(f"pow {logical:x}", POWER_PATTERN, "unknown"),
+        }
+
+    def run(self, on_device=None, full=False):
+        """Discover devices, calling on_device(record) as each one is known
+
+        Returns (devices present, number of devices queried).
+        """
+        with self.run_lock:
+            return self._run_locked(on_device, full)
+
+    def _run_locked(self, on_device, full):
+        with self.lock:
+            self.running = True
+            if full:
+                self.devices = {}
+            dirty = set(self.dirty)
+            self.dirty.clear()
+
+        found = []
+        queried = 0
+        try:
+            for logical in LOGICAL_ADDRESSES:
+                known = self.devices.get(logical)
+                if not self._poll(logical):
+                    if known:
+                        del self.devices[logical]
+                        if on_device:
+                            on_device(dict(known, present=False))
+                    continue
+
+                if known is None or logical in dirty:
+                    known = self._identify(logical)
+                    self.devices[logical] = known
+                    queried += 1
+                found.append(known)
+                if on_device:
+                    on_device(known)
+        finally:
+            with self.lock:
+                self.running = False
+                self.quiet_until = time.monotonic() + QUIET_AFTER_RUN
+
+        logger.info(f"Discovery found {len(found)} devices, queried {queried}")
+        return found, queried
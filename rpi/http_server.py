@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+HTTP control endpoint
+An asyncio server on its own thread: one event loop holds every connection,
+kept alive between requests, and commands run exactly as UART JSON lines
+do (CECController.process_request), so they share the scheduler, merging
+and bus state. They run on HTTP_WORKERS threads of their own, so a full
+batch or a busy HTTP client cannot take the workers the Flipper's requests
+need; HTTP requests beyond that wait for a free one.
+
+  GET  /?cmd=POWER_ON[&adapter=all&refresh=1...]   query string as a command
+  POST /            {"command": "POWER_ON", ...}   one JSON command
+  POST /batch       [{"command": ...}, ...]        JSON array in, array out
+
+A batch's commands are handed to the workers together and answered in
+their order; the scheduler decides what reaches the bus first, so commands
+that must follow each other belong in a SEQUENCE. Replies are the same JSON
+the UART gets, with status 200 whether or not the command succeeded; other
+statuses are for requests that could not be read.
+
+CEC_HTTP_PORT (8080, 0 turns it off) and CEC_HTTP_HOST pick the socket.
+"""
+import asyncio
+import json
+import logging
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from urllib.parse import urlsplit, parse_qsl
+
+logger = logging.getLogger("http_server")
+
+HTTP_HOST = os.environ.get("CEC_HTTP_HOST", "0.0.0.0")
+HTTP_PORT = int(os.environ.get("CEC_HTTP_PORT", "8080"))
+
+MAX_HEADER = 8192
+MAX_BODY = 65536
+MAX_BATCH = 64
+# HTTP commands handled at once, apart from the UART's workers
+HTTP_WORKERS = 8
+# An idle keep-alive connection is closed after this many seconds
+IDLE_TIMEOUT = 30
+
+# Query parameters that are flags in a JSON command
+FLAG_FIELDS = ("refresh", "full", "reset")
+
+REASONS = {200: "OK", 400: "Bad Request", 404: "Not Found", 405: "Method Not Allowed", 411: "Length Required",
+           413: "Payload Too Large", 431: "Request Header Fields Too Large", 500: "Internal Server Error"}
+
+
+class HTTPError(Exception):
+    def __init__(self, status, text):
+        super().__init__(text)
+        self.status = status
+
+
+def command_from_query(query):
+    """?cmd=STATUS&refresh=1 -> {"command": "STATUS", "refresh": True}; repeated keys become lists"""
+    command = {}
+    for key, value in parse_qsl(query, keep_blank_values=True):
+        if key == "cmd":
+            key = "command"
+        if key in FLAG_FIELDS:
+            value = value.lower() in ("1", "true", "yes", "on")
+        if key in command:
+            previous = command[key]
+            command[key] = (previous if isinstance(previous, list) else [previous]) + [value]
+        else:
+            command[key] = value
+    if not command.get("command"):
+        raise HTTPError(400, "Missing cmd")
+    return command
+
+
+def encode_response(status, body, keep_alive):
+    data = json.dumps(body).encode("utf-8")
+    head = (f"HTTP/1.1 {status} {REASONS.get(status, 'Error')}\r\n"
+            f"Content-Type: application/json\r\n"
+            f"Content-Length: {len(data)}\r\n"
+            f"Connection: {'keep-alive' if keep_alive else 'close'}\r\n\r\n")
+    return head.encode("latin-1") + data
+
+
+class HTTPServer:
+    """Serves handle(command dict) -> reply dict, run on workers of its own, over HTTP/1.1"""
+    def __init__(self, handle, host=HTTP_HOST, port=HTTP_PORT, workers=HTTP_WORKERS):
+        self.handle = handle
+        self.executor = ThreadPoolExecutor(max_workers=workers)
+        self.host = host
+        self.port = port
+        self.loop = None
+        self.thread = None
+        self.stopped = None
+        self.started = threading.Event()
+        self.error = None
+        self.connections = 0          # Accepted since start, for the load test
+        self.requests = 0
+
+    def start(self):
+        """Listen on a thread of its own; returns once the socket is bound or failed"""
+        self.thread = threading.Thread(target=lambda: asyncio.run(self._main()))
+        self.thread.daemon = True
+        self.thread.start()
+        self.started.wait(5)
+        if self.error:
+            raise self.error
+        logger.info(f"🌐 HTTP interface on {self.host}:{self.port}")
+
+    def stop(self):
+        if self.loop and self.stopped:
+            self.loop.call_soon_threadsafe(self.stopped.set)
+        if self.thread:
+            self.thread.join(timeout=2)
+        self.executor.shutdown(wait=False)
+
+    async def _main(self):
+        self.loop = asyncio.get_running_loop()
+        self.stopped = asyncio.Event()
+        try:
+            server = await asyncio.start_server(self._serve, self.host, self.port, limit=MAX_HEADER)
+        except OSError as e:
+            self.error = e
+            self.started.set()
+            return
+        # Port 0 asks the kernel for a free one
+        self.port = server.sockets[0].getsockname()[1]
+        self.started.set()
+        async with server:
+            await self.stopped.wait()
+
+    async def _serve(self, reader, writer):
+        self.connections += 1
+        try:
+            keep_alive = True
+            while keep_alive:
+                try:
+                    head = await asyncio.wait_for(reader.readuntil(b"\r\n\r\n"), IDLE_TIMEOUT)
+                except asyncio.LimitOverrunError:
+                    writer.write(encode_response(431, {"status": "error", "result": "Header too large"}, False))
+                    break
+                except (asyncio.IncompleteReadError, asyncio.TimeoutError, ConnectionError):
+                    break
+                try:
+                    method, target, headers, keep_alive = self._parse_head(head)
+                    length = int(headers.get("content-length", "0") or 0)
+                    if length > MAX_BODY:
+                        raise HTTPError(413, f"Body over {MAX_BODY} bytes")
+                    body = await reader.readexactly(length) if length else b""
+                    status, reply = 200, await self._route(method, target, body)
+                except HTTPError as e:
+                    status, reply = e.status, {"status": "error", "result": str(e)}
+                    # The body of a refused request may still be on the wire
+                    keep_alive = keep_alive and e.status not in (411, 413)
+                except (ValueError, asyncio.IncompleteReadError):
+                    status, reply, keep_alive = 400, {"status": "error", "result": "Malformed request"}, False
+                self.requests += 1
+                writer.write(encode_response(status, reply, keep_alive))
+                await writer.drain()
+        except ConnectionError:
+            pass
+        except Exception as e:
+            logger.error(f"HTTP connection error: {e}")
+        finally:
+            writer.close()
+
+    def _parse_head(self, head):
+        lines = head.decode("latin-1").split("\r\n")
+        method, target, version = lines[0].split(" ", 2)
+        headers = {}
+        for line in lines[1:]:
+            if line:
+                name, _, value = line.partition(":")
+                headers[name.strip().lower()] = value.strip()
+        connection = headers.get("connection", "").lower()
+        keep_alive = connection != "close" if version == "HTTP/1.1" else connection == "keep-alive"
+        if "chunked" in headers.get("transfer-encoding", "").lower():
+            raise HTTPError(411, "Send Content-Length, chunked bodies are not read")
+        return method, target, headers, keep_alive
+
+    async def _route(self, method, target, body):
+        url = urlsplit(target)
+        if url.path in ("/", "/command"):
+            if method == "GET":
+                return await self._run(command_from_query(url.query))
+            if method == "POST":
+                command = self._json(body)
+                if not isinstance(command, dict):
+                    raise HTTPError(400, "Expected a JSON object, POST arrays to /batch")
+                return await self._run(command)
+        elif url.path == "/batch":
+            if method == "POST":
+                commands = self._json(body)
+                if not isinstance(commands, list):
+                    raise HTTPError(400, "Expected a JSON array of commands")
+                if len(commands) > MAX_BATCH:
+                    raise HTTPError(413, f"At most {MAX_BATCH} commands per batch")
+                return list(await asyncio.gather(*(self._run(command) for command in commands)))
+        else:
+            raise HTTPError(404, f"No such path: {url.path}")
+        raise HTTPError(405, f"{method} not allowed on {url.path}")
+
+    @staticmethod
+    def _json(body):
+        try:
+            return json.loads(body)
+        except ValueError:
+            raise HTTPError(400, "Invalid JSON")
+
+    async def _run(self, command):
+        if not isinstance(command, dict):
+            return {"status": "error", "result": "Invalid command"}
+        return await self.loop.run_in_executor(self.executor, self.handle, command)
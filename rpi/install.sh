@@ -21,7 +21,7 @@ apt update && apt upgrade -y
 
 echo "📦 Installing required packages..."
 apt install -y cec-utils python3-pip python3-venv
-apt install -y xorg feh imagemagick openbox xinit xserver-xorg-legacy
+apt install -y imagemagick
 
 echo "🔧 Enabling UART for Flipper communication..."
 CONFIG_FILE="/boot/firmware/config.txt"
@@ -73,12 +73,14 @@ source $INSTALL_DIR/venv/bin/activate
 pip install pyserial
 
 echo "📥 Downloading CEC application..."
-if curl -sSL "https://raw.githubusercontent.com/dannykeren/cec-flipper-control/main/rpi/main.py" > $INSTALL_DIR/main.py; then
-    echo "✅ Downloaded main.py"
-else
-    echo "❌ Failed to download main.py"
-    exit 1
-fi
+for APP_FILE in main.py cec_control.py cec_backend.py scheduler.py adapters.py http_server.py cec_session.py device_cache.py uart_protocol.py discovery.py sequence.py power_timing.py command_journal.py latency.py baud_rate.py key_hold.py bus_state.py status_display.py update_display.py; do
+    if curl -sSL "https://raw.githubusercontent.com/dannykeren/cec-flipper-control/main/rpi/$APP_FILE" > $INSTALL_DIR/$APP_FILE; then
+        echo "✅ Downloaded $APP_FILE"
+    else
+        echo "❌ Failed to download $APP_FILE"
+        exit 1
+    fi
+done
 
 chmod +x $INSTALL_DIR/main.py
 
@@ -131,6 +133,9 @@ After=network.target
 Type=simple
 ExecStart=/opt/cec-flipper/venv/bin/python /opt/cec-flipper/main.py
 WorkingDirectory=/opt/cec-flipper
+# Several displays: one adapter each, see adapters.py
+#Environment=CEC_ADAPTERS=lobby=kernel:/dev/cec0,bar=cec-client:/dev/ttyACM0
+#Environment=CEC_DEFAULT_TARGET=all
 Restart=always
 RestartSec=5
 User=root
@@ -144,49 +149,35 @@ systemctl enable cec-flipper.service
 
 echo "🖥️ Setting up display auto-start..."
 
-# Configure auto-login
-mkdir -p /etc/systemd/system/getty@tty1.service.d
-cat > /etc/systemd/system/getty@tty1.service.d/autologin.conf << EOF
-[Service]
-ExecStart=
-ExecStart=-/sbin/agetty --autologin $ACTUAL_USER --noclear %I \$TERM
-EOF
-
-# Configure X11 permissions
-cat > /etc/X11/Xwrapper.config << 'EOF'
-allowed_users=anybody
-needs_root_rights=yes
-EOF
-
-# Create display startup script
-cat > "$USER_HOME/start_icss_display.sh" << EOF
-#!/bin/bash
-export DISPLAY=:0
-export HOME=$USER_HOME
+# The status renderer draws straight to the framebuffer; X, feh and the
+# autologin that started them are no longer needed
+rm -f /etc/systemd/system/getty@tty1.service.d/autologin.conf
+rm -f "$USER_HOME/start_icss_display.sh"
+if [ -f "$USER_HOME/.bash_profile" ]; then
+    sed -i '/^if \[ -z "\$DISPLAY" \]/,/^fi$/d' "$USER_HOME/.bash_profile"
+fi
 
-# Start X11 in background
-startx -- :0 vt1 &
-sleep 15
+cat > /etc/systemd/system/cec-display.service << EOF
+[Unit]
+Description=ICSS CEC status display
+After=systemd-user-sessions.service
 
-# Disable screensaver
-DISPLAY=:0 xset s off
-DISPLAY=:0 xset s noblank  
-DISPLAY=:0 xset -dpms
+[Service]
+Type=simple
+ExecStart=/opt/cec-flipper/venv/bin/python /opt/cec-flipper/status_display.py
+Environment=CEC_DISPLAY_DIR=$USER_HOME
+Restart=always
+RestartSec=2
+User=root
+Group=root
 
-# Show static ICSS display
-DISPLAY=:0 feh --fullscreen --hide-pointer $USER_HOME/icss_display.png &
+[Install]
+WantedBy=multi-user.target
 EOF
 
-chmod +x "$USER_HOME/start_icss_display.sh"
-
-# Create auto-start on login
-cat > "$USER_HOME/.bash_profile" << EOF
-if [ -z "\$DISPLAY" ] && [ "\$(tty)" = "/dev/tty1" ]; then
-    $USER_HOME/start_icss_display.sh
-fi
-EOF
+systemctl enable cec-display.service
 
-chown $ACTUAL_USER:$ACTUAL_USER "$USER_HOME/.bash_profile" "$USER_HOME/start_icss_display.sh" "$USER_HOME/icss_display.png"
+chown $ACTUAL_USER:$ACTUAL_USER "$USER_HOME/icss_display.png"
 
 # Add user to required groups
 usermod -a -G dialout,tty,video $ACTUAL_USER
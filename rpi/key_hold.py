@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Press-and-hold remote keys, Pi side
+The Flipper streams a held key as OP_KEY events: DOWN once, REPEAT while
+its button auto-repeats, UP on release. The Pi turns them into CEC
+<User Control Pressed> / <User Control Released>:
+  DOWN    Pressed right away
+  held    Pressed again every REPEAT_INTERVAL, the repeat rate CEC asks an
+          initiator for (200-500 ms), whatever rate the Flipper repeats at
+  UP      Released
+The Flipper's repeats only keep the hold alive: without one for
+HOLD_TIMEOUT (key up lost, cable pulled) the Pi releases on its own, well
+before a TV's own 550 ms press-and-hold timeout would.
+
+Only one key is held at a time; DOWN for another key releases the first.
+Frames go out through send(command) on a thread of its own, so the UART
+thread never waits on the bus.
+"""
+import collections
+import threading
+import time
+import logging
+from uart_protocol import KEY_DOWN, KEY_REPEAT, KEY_UP, KEY_DEST_AUTO
+
+logger = logging.getLogger("key_hold")
+
+REPEAT_INTERVAL = 0.3      # seconds between Pressed frames while a key is held
+HOLD_TIMEOUT = 0.6         # release when the Flipper has been silent this long
+                           # (its first repeat comes ~300 ms after the press)
+
+# Volume keys go to the audio system when one answers, like cec-client's volup
+VOLUME_KEYS = (0x41, 0x42, 0x43)
+AUDIO_SYSTEM = 0x5
+TV = 0x0
+
+
+class Hold:
+    def __init__(self, key, destination, now):
+        self.key = key
+        self.destination = destination    # As asked for, may be KEY_DEST_AUTO
+        self.target = None                # Device the Pressed frames reached
+        self.down = now
+        self.repeats = 0
+
+
+class KeyHold:
+    def __init__(self, send, clock=time.monotonic):
+        self.send = send
+        self.clock = clock
+        self.cond = threading.Condition()
+        self.events = collections.deque()  # ("press" | "release", Hold) for the thread
+        self.held = None                   # Key the Flipper is holding
+        self.last_seen = 0.0               # Last DOWN or REPEAT for it
+        self.active = None                 # Hold whose Pressed frames are on the bus, thread-only
+        self.next_repeat = None
+        self.timeouts = 0
+        self.running = True
+        self.thread = None
+
+    def event(self, action, key, destination=KEY_DEST_AUTO):
+        """One OP_KEY event from the UART thread; never blocks on the bus"""
+        now = self.clock()
+        with self.cond:
+            if action == KEY_REPEAT:
+                if self.held and self.held.key == key:
+                    self.last_seen = now
+                    return
+                action = KEY_DOWN          # Its DOWN was lost on the way
+            if action == KEY_DOWN:
+                if self.held:
+                    self.events.append(("release", self.held))
+                self.held = Hold(key, destination, now)
+                self.last_seen = now
+                self.events.append(("press", self.held))
+            elif action == KEY_UP:
+                if not self.held or self.held.key != key:
+                    return
+                self.events.append(("release", self.held))
+                self.held = None
+            if self.thread is None:
+                self.thread = threading.Thread(target=self._loop)
+                self.thread.daemon = True
+                self.thread.start()
+            self.cond.notify()
+
+    def _wait_time(self):
+        """Seconds until the held key needs a repeat or times out, None when idle"""
+        if self.active is None or self.active is not self.held:
+            return None
+        due = min(self.next_repeat, self.last_seen + HOLD_TIMEOUT)
+        return max(0.0, due - self.clock())
+
+    def _loop(self):
+        while True:
+            with self.cond:
+                while self.running and not self.events:
+                    wait = self._wait_time()
+                    if wait == 0.0:
+                        break
+                    self.cond.wait(wait)
+                if not self.running:
+                    break
+                event = self.events.popleft() if self.events else None
+                timed_out = (event is None and self.active is not None and self.active is self.held
+                             and self.clock() - self.last_seen >= HOLD_TIMEOUT)
+                if timed_out:
+                    self.held = None
+                    self.timeouts += 1
+
+            if event is not None:
+                kind, hold = event
+                if kind == "press":
+                    self._press(hold)
+                elif hold is self.active:
+                    self._release()
+            elif timed_out:
+                logger.warning(f"⌨️ Key 0x{self.active.key:02X} not repeated for {HOLD_TIMEOUT} s, releasing")
+                self._release()
+            elif self.active is not None:
+                self.active.repeats += 1
+                self._pressed(self.active.target, self.active.key)
+                # Keep the cadence, but never catch up with a burst after a slow frame
+                self.next_repeat += REPEAT_INTERVAL
+                if self.next_repeat < self.clock():
+                    self.next_repeat = self.clock() + REPEAT_INTERVAL
+
+        if self.active is not None:
+            self._release()
+
+    def _frame(self, command):
+        try:
+            success, _ = self.send(command)
+            return success
+        except Exception as e:
+            logger.error(f"Key frame error: {e}")
+            return False
+
+    def _pressed(self, destination, key):
+        return self._frame(f"tx 1{destination:X}:44:{key:02X}")
+
+    def _press(self, hold):
+        if hold.destination != KEY_DEST_AUTO:
+            targets = (hold.destination,)
+        elif hold.key in VOLUME_KEYS:
+            targets = (AUDIO_SYSTEM, TV)
+        else:
+            targets = (TV,)
+        for target in targets:
+            if self._pressed(target, hold.key):
+                hold.target = target
+                self.active = hold
+                self.next_repeat = self.clock() + REPEAT_INTERVAL
+                logger.info(f"⌨️ Key 0x{hold.key:02X} down on {target:X}")
+                return
+        logger.error(f"❌ Key 0x{hold.key:02X} was not acked")
+
+    def _release(self):
+        hold = self.active
+        self.active = None
+        self._frame(f"tx 1{hold.target:X}:45")
+        logger.info(f"⌨️ Key 0x{hold.key:02X} up after {self.clock() - hold.down:.1f} s, "
+                    f"{hold.repeats} repeats")
+
+    def stop(self):
+        with self.cond:
+            self.running = False
+            self.cond.notify_all()
+        if self.thread:
+            self.thread.join(timeout=2)
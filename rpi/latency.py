@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+End-to-end latency tracing
+Every UART request carries a Trace stamped with time.monotonic() as it
+moves through the daemon:
+  received   bytes read in uart_loop
+  dispatched picked up by a worker
+  cec        each CEC command, split into waiting in the scheduler and
+             for the backend, and the command itself
+  replied    reply encoded
+  written    reply on the wire
+Finished traces go into fixed-size log-scale histograms per command type
+and stage, so STATS reports p50/p95/p99 without keeping any samples.
+"""
+import math
+import threading
+import time
+
+# Stage name -> what it measures, in report order
+STAGES = {
+    "total": "received -> written",
+    "queue": "received -> dispatched",
+    "wait": "waiting for the CEC backend",
+    "cec": "CEC commands",
+    "other": "dispatched -> replied, without wait and cec",
+    "write": "replied -> written",
+}
+
+# Histogram buckets: 0.05 ms up to ~2 min, each 25% wider than the last
+BUCKET_BASE = 0.05
+BUCKET_GROWTH = 1.25
+BUCKET_COUNT = 66
+
+_local = threading.local()
+
+
+class Histogram:
+    def __init__(self):
+        self.buckets = [0] * BUCKET_COUNT
+        self.count = 0
+        self.max = 0.0
+
+    def add(self, ms):
+        if ms <= BUCKET_BASE:
+            index = 0
+        else:
+            index = min(BUCKET_COUNT - 1, int(math.log(ms / BUCKET_BASE, BUCKET_GROWTH)) + 1)
+        self.buckets[index] += 1
+        self.count += 1
+        self.max = max(self.max, ms)
+
+    def percentile(self, p):
+        """Upper bound of the bucket holding the p-th percentile, in ms"""
+        if not self.count:
+            return 0.0
+        rank = math.ceil(self.count * p / 100.0)
+        seen = 0
+        for index, count in enumerate(self.buckets):
+            seen += count
+            if seen >= rank:
+                return min(BUCKET_BASE * BUCKET_GROWTH ** index, self.max)
+        return self.max
+
+
+class Trace:
+    """Timestamps of one request; cec time accumulates over all its commands"""
+
+    def __init__(self, received=None):
+        self.command = "UNKNOWN"
+        self.received = received if received is not None else time.monotonic()
+        self.dispatched = None
+        self.replied = None
+        self.written = None
+        self.wait = 0.0
+        self.cec = 0.0
+
+    def stages(self):
+        """Stage durations in ms"""
+        dispatched = self.dispatched or self.received
+        replied = self.replied or dispatched
+        written = self.written or replied
+        seconds = {
+            "total": written - self.received,
+            "queue": dispatched - self.received,
+            "wait": self.wait,
+            "cec": self.cec,
+            "other": max(0.0, replied - dispatched - self.wait - self.cec),
+            "write": written - replied,
+        }
+        return {stage: value * 1000.0 for stage, value in seconds.items()}
+
+
+def activate(trace):
+    """Make trace the one CEC timings of this thread are added to"""
+    _local.trace = trace
+
+
+def current():
+    return getattr(_local, "trace", None)
+
+
+def note_cec(wait, run, trace=None):
+    """Called for every CEC command, in seconds; trace defaults to this thread's"""
+    trace = trace or current()
+    if trace is not None:
+        trace.wait += wait
+        trace.cec += run
+
+
+def _format_ms(ms):
+    return f"{ms:.1f}" if ms < 10 else f"{ms:.0f}"
+
+
+class LatencyStats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.histograms = {}     # (command, stage) -> Histogram
+        self.requests = 0
+        self.since = time.monotonic()
+
+    def record(self, trace):
+        stages = trace.stages()
+        with self.lock:
+            self.requests += 1
+            for stage, ms in stages.items():
+                key = (trace.command, stage)
+                if key not in self.histograms:
+                    self.histograms[key] = Histogram()
+                self.histograms[key].add(ms)
+
+    def reset(self):
+        with self.lock:
+            self.histograms = {}
+            self.requests = 0
+            self.since = time.monotonic()
+
+    def to_dict(self):
+        """Per command: count and p50/p95/p99/max of every stage, in ms"""
+        with self.lock:
+            commands = {}
+            for (command, stage), histogram in self.histograms.items():
+                entry = commands.setdefault(command, {"count": 0, "stages": {}})
+                if stage == "total":
+                    entry["count"] = histogram.count
+                entry["stages"][stage] = {
+                    "p50": round(histogram.percentile(50), 3),
+                    "p95": round(histogram.percentile(95), 3),
+                    "p99": round(histogram.percentile(99), 3),
+                    "max": round(histogram.max, 3),
+                }
+            return {
+                "requests": self.requests,
+                "seconds": round(time.monotonic() - self.since, 1),
+                "commands": commands,
+            }
+
+    def format_text(self):
+        """Short lines for the Flipper's result screen"""
+        data = self.to_dict()
+        lines = [f"📊 {data['requests']} requests in {data['seconds']:.0f} s", "ms p50/p95/p99"]
+        commands = sorted(data["commands"].items(), key=lambda item: -item[1]["count"])
+        for command, entry in commands:
+            lines.append(f"{command} n={entry['count']}")
+            for stage in STAGES:
+                values = entry["stages"].get(stage)
+                # Stages that never took measurable time are left out
+                if not values or (stage != "total" and values["p99"] < 0.1):
+                    continue
+                lines.append(f" {stage} " + "/".join(_format_ms(values[p]) for p in ("p50", "p95", "p99")))
+        if not commands:
+            lines.append("No requests yet")
+        return "\n".join(lines)
+
+
+STATS = LatencyStats()
@@ -11,90 +11,469 @@ import json
 import threading
 import serial
 import os
-import subprocess
+import select
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime
+from cec_backend import stop_backend, CECTimeout
+from scheduler import get_scheduler, stop_scheduler, BULK
+from adapters import get_adapters, stop_adapters, format_results, AdapterError
+from http_server import HTTPServer, HTTP_PORT
+import latency
+from discovery import Discovery, format_device, POLL_ACK_PATTERN
+from sequence import SequenceError, parse_sequence, run_sequence
+from power_timing import run_adaptive, get_timing_store
+from baud_rate import BaudRate, DEFAULT_RATE
+from key_hold import KeyHold
+from bus_state import get_bus_state, stop_bus_state
+from uart_protocol import (FrameDecoder, ProtocolError, PROTOCOL_VERSION, OP_RESULT, OP_RESULT_PART,
+                           OP_BAUD, OP_KEY, OP_WATCH, BAUD_PROPOSE, BAUD_PATTERN, STATUS_OK, EVENT_READY,
+                           EVENT_NO_DEVICE, request_from_frame,
+                           baud_from_payload, key_from_payload, watch_from_payload, encode_frame,
+                           encode_result_frame, encode_event_frame)
 
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger("main")
 
+# Requests handled at once; they mostly wait on the scheduler, which orders CEC access
+COMMAND_WORKERS = 16
+
+# A held key's frames are dropped rather than queued for long behind other commands
+KEY_TIMEOUT = 2
+
+# While the Flipper watches, known devices are polled this often so ones that left are reported
+PRESENCE_INTERVAL = float(os.environ.get("CEC_PRESENCE_INTERVAL", "60"))
+
+# Open the CEC adapter at startup instead of on the first command (0 only to measure the difference)
+WARM_UP = os.environ.get("CEC_WARM_UP", "1") != "0"
+
+def uptime():
+    """Seconds since the kernel booted, which on a Pi powered by the Flipper is since power-on"""
+    try:
+        with open("/proc/uptime") as f:
+            return float(f.read().split()[0])
+    except (OSError, ValueError, IndexError):
+        return None
+
 def execute_cec_command(command, vendor="Unknown", timeout=10):
-    """Execute CEC command - clean and simple"""
+    """Execute CEC command through the shared scheduler"""
     try:
         logger.info("Executing CEC command: " + command)
         
-        process = subprocess.Popen(
-            ['cec-client', '-s', '-d', '1'],
-            stdin=subprocess.PIPE,
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            universal_newlines=True
-        )
-        
-        stdout, stderr = process.communicate(input=command + '\n', timeout=timeout)
+        success, output = get_scheduler().execute(command, timeout=timeout)
         
-        if process.returncode == 0:
+        if success:
             logger.info("✅ Command successful: " + command)
             return "✅ Command executed: " + command
         else:
-            logger.error("❌ Command failed: " + command + " - " + stderr)
-            return "❌ Command failed: " + stderr
+            logger.error("❌ Command failed: " + command + " - " + output)
+            return "❌ Command failed: " + output
             
-    except subprocess.TimeoutExpired:
-        process.kill()
+    except CECTimeout:
         return "❌ Command timed out: " + command
     except Exception as e:
         return "❌ Error executing command: " + str(e)
 
 class CECController:
-    def __init__(self):
+    def __init__(self, uart_port=None):
         self.running = False
         self.uart_serial = None
+        self.uart_port = uart_port or os.environ.get("CEC_UART_PORT", "/dev/ttyAMA0")
+        self.decoder = FrameDecoder()
+        # Requests run concurrently and are answered as they finish
+        self.executor = ThreadPoolExecutor(max_workers=COMMAND_WORKERS)
+        self.write_lock = threading.Lock()
+        self.uart_thread = None
+        # Written by stop() so the reader's select() returns immediately
+        self.wake_read, self.wake_write = os.pipe()
+        self.discovery = None
+        self.discovery_lock = threading.Lock()
+        # Only touched by the UART thread
+        self.baud = BaudRate(self.set_uart_rate)
+        self.keys = KeyHold(self.send_key)
+        # Bus events are pushed to the Flipper while it watches
+        self.watching = False
+        self.presence_thread = None
+        self.presence_stop = threading.Event()
+        # Seconds after boot the daemon started, was ready and ran its first command
+        self.startup = {}
+        self.http = None
     
     def start_uart_interface(self):
         """Start UART interface for Flipper Zero"""
         try:
-            self.uart_serial = serial.Serial('/dev/ttyAMA0', 115200, timeout=1)
-            uart_thread = threading.Thread(target=self.uart_loop)
-            uart_thread.daemon = True
-            uart_thread.start()
-            logger.info("UART interface started on /dev/ttyAMA0")
+            self.uart_serial = serial.Serial(self.uart_port, DEFAULT_RATE, timeout=1)
+            self.uart_thread = threading.Thread(target=self.uart_loop)
+            self.uart_thread.daemon = True
+            self.uart_thread.start()
+            logger.info("UART interface started on " + self.uart_port)
         except Exception as e:
             logger.error("Failed to start UART: " + str(e))
     
+    def start_http_interface(self, port=None):
+        """Serve the same commands over HTTP, see http_server.py; port 0 picks a free one"""
+        if port is None:
+            if not HTTP_PORT:
+                return
+            port = HTTP_PORT
+        try:
+            self.http = HTTPServer(self.process_request, port=port)
+            self.http.start()
+        except Exception as e:
+            logger.error("Failed to start HTTP: " + str(e))
+            self.http = None
+    
     def uart_loop(self):
         """Handle UART communication with Flipper"""
+        uart_fd = self.uart_serial.fileno()
         while self.running:
             try:
-                if self.uart_serial and self.uart_serial.in_waiting > 0:
-                    line = self.uart_serial.readline().decode('utf-8').strip()
-                    if line:
-                        logger.info("UART received: '" + line + "'")
-                        response = self.process_command(line)
-                        if self.uart_serial:
-                            self.uart_serial.write((response + '\n').encode('utf-8'))
-                            logger.info("UART sent: " + response)
-                time.sleep(0.1)
+                # Sleep in the kernel until bytes arrive, a rate switch times out or stop() wakes us
+                ready, _, _ = select.select([uart_fd, self.wake_read], [], [], self.baud.timeout())
+                if self.wake_read in ready or not self.running:
+                    break
+                self.baud.poll()
+                if not ready:
+                    continue
+                data = self.uart_serial.read(self.uart_serial.in_waiting or 1)
+                received = time.monotonic()
+                errors = self.decoder.crc_errors + self.decoder.noise
+                messages = self.decoder.feed(data)
+                self.baud.note_errors(self.decoder.crc_errors + self.decoder.noise - errors)
+                for message in messages:
+                    if message[0] == "frame" and message[1] == OP_BAUD:
+                        self.handle_baud(message[2], message[3])
+                    elif message[0] == "frame" and message[1] == OP_KEY:
+                        self.handle_key(message[3])
+                    elif message[0] == "frame" and message[1] == OP_WATCH:
+                        self.handle_watch(message[3])
+                    else:
+                        self.executor.submit(self.dispatch_message, message, latency.Trace(received))
             except Exception as e:
                 logger.error("UART error: " + str(e))
                 time.sleep(1)
     
-    def process_command(self, command_json):
-        """Process CEC command - clean and simple"""
+    def dispatch_message(self, message, trace=None):
+        """Worker entry: run one request and write its reply"""
+        trace = trace or latency.Trace()
+        trace.dispatched = time.monotonic()
+        latency.activate(trace)
+        try:
+            reply = self.handle_message(message)
+            trace.replied = time.monotonic()
+            if reply:
+                self.send_reply(reply)
+            trace.written = time.monotonic()
+            latency.STATS.record(trace)
+        except Exception as e:
+            logger.error("Dispatch error: " + str(e))
+        finally:
+            latency.activate(None)
+    
+    def set_uart_rate(self, rate):
+        self.uart_serial.baudrate = rate
+    
+    def handle_baud(self, seq, payload):
+        """Rate negotiation on the UART thread, see baud_rate.py"""
+        try:
+            action, rate, pattern = baud_from_payload(payload)
+        except ProtocolError as e:
+            self.send_reply(encode_result_frame({"status": "error", "result": str(e)}, seq))
+            return
+        
+        if action == BAUD_PROPOSE:
+            ok, text = self.baud.propose(rate)
+            with self.write_lock:
+                self.uart_serial.write(encode_result_frame({"status": "success" if ok else "error", "result": text}, seq))
+                if ok:
+                    # The reply has to leave at the old rate before the port changes
+                    self.uart_serial.flush()
+                    self.baud.switch(rate)
+            return
+        
+        # BAUD_VERIFY: echo the pattern so both directions are checked at the new rate
+        if pattern == BAUD_PATTERN and self.baud.verify(rate):
+            self.send_reply(encode_frame(OP_RESULT, seq, bytes([STATUS_OK]) + pattern))
+        else:
+            self.send_reply(encode_result_frame({"status": "error", "result": "❌ Baud verify failed"}, seq))
+    
+    def handle_key(self, payload):
+        """Held key event on the UART thread, in arrival order; never answered"""
+        try:
+            action, key, destination = key_from_payload(payload)
+        except ProtocolError as e:
+            logger.warning("Key event dropped: " + str(e))
+            return
+        self.keys.event(action, key, destination)
+    
+    def send_key(self, command):
+        return get_scheduler().execute(command, timeout=KEY_TIMEOUT)
+    
+    def handle_watch(self, payload):
+        """Start or stop pushing bus events; a new watcher first gets what is known so far"""
+        state = get_bus_state()
+        if self.presence_thread is None:
+            state.add_watcher(self.push_event)
+            self.presence_thread = threading.Thread(target=self.presence_loop)
+            self.presence_thread.daemon = True
+            self.presence_thread.start()
+        self.watching = watch_from_payload(payload)
+        logger.info("👁️ Bus events " + ("on" if self.watching else "off"))
+        if self.watching:
+            for event in state.snapshot():
+                self.push_event(*event)
+    
+    def push_event(self, kind, logical, value):
+        """Bus state watcher: one OP_EVENT frame, between replies"""
+        if self.watching:
+            self.send_reply(encode_event_frame(kind, logical, value))
+    
+    def presence_loop(self):
+        """Poll known devices now and then, so devices that left are reported too"""
+        while not self.presence_stop.wait(PRESENCE_INTERVAL):
+            if not self.watching:
+                continue
+            state = get_bus_state()
+            for device in state.devices_known():
+                try:
+                    with get_scheduler().priority(BULK):
+                        success, output = get_scheduler().execute("poll %x" % device["logical"], timeout=2)
+                except Exception as e:
+                    logger.error("Presence poll error: " + str(e))
+                    continue
+                state.note_present(device["logical"], success and bool(POLL_ACK_PATTERN.search(output)))
+    
+    def send_reply(self, data):
+        """Write one complete reply; workers never interleave on the wire"""
+        with self.write_lock:
+            if self.uart_serial:
+                self.uart_serial.write(data)
+    
+    def handle_message(self, message):
+        """Run one decoded UART message and encode the reply the same way"""
+        if message[0] == "json":
+            line = message[1]
+            logger.info("UART received: '" + line + "'")
+            response = self.process_command(line, self.send_reply)
+            logger.info("UART sent: " + response)
+            return (response + '\n').encode('utf-8')
+        
+        opcode, seq, payload = message[1], message[2], message[3]
+        logger.info("UART received frame: op=0x%02X seq=%d len=%d" % (opcode, seq, len(payload)))
+        try:
+            command = request_from_frame(opcode, payload)
+        except ProtocolError as e:
+            return encode_result_frame({"status": "error", "result": str(e)}, seq)
+        
+        def progress(text):
+            part = {"status": "success", "result": text}
+            self.send_reply(encode_result_frame(part, seq, OP_RESULT_PART))
+        
+        response = self.handle_command(command, progress)
+        self.note_command(command, response)
+        logger.info("UART sent frame: seq=%d %s" % (seq, response.get("result", "")))
+        return encode_result_frame(response, seq)
+    
+    def process_command(self, command_json, send_partial=None):
+        """Process a JSON CEC command line and return the JSON reply"""
         try:
             command = json.loads(command_json)
+        except json.JSONDecodeError:
+            return json.dumps({"status": "error", "result": "Invalid JSON"})
+        return json.dumps(self.process_request(command, send_partial))
+    
+    def process_request(self, command, send_partial=None):
+        """Run one decoded JSON command and return the reply dict; UART and HTTP both come here"""
+        progress = None
+        if send_partial and isinstance(command, dict):
+            def progress(text):
+                part = {"status": "success", "partial": True, "result": text}
+                if 'id' in command:
+                    part["id"] = command['id']
+                send_partial((json.dumps(part) + '\n').encode('utf-8'))
+        
+        response = self.handle_command(command, progress)
+        self.note_command(command, response)
+        if isinstance(command, dict) and 'id' in command:
+            response["id"] = command['id']
+        return response
+    
+    def get_discovery(self):
+        with self.discovery_lock:
+            if self.discovery is None:
+                self.discovery = Discovery(get_scheduler())
+            return self.discovery
+    
+    def discover(self, full=False, progress=None):
+        """Poll the bus, streaming each device through progress(text)"""
+        start = time.monotonic()
+        
+        def on_device(device):
+            get_bus_state().note_present(device["logical"], device.get("present", True))
+            if progress:
+                progress(format_device(device))
+        
+        with get_scheduler().priority(BULK):
+            devices, queried = self.get_discovery().run(on_device, full=full)
+        # Every address was polled, so devices only seen on the bus and not found now are gone
+        found = set(device["logical"] for device in devices)
+        for device in get_bus_state().devices_known():
+            if device["logical"] not in found:
+                get_bus_state().note_present(device["logical"], False)
+        elapsed = int((time.monotonic() - start) * 1000)
+        lines = ["🔍 " + str(len(devices)) + " devices (" + str(queried) + " queried) in " + str(elapsed) + " ms"]
+        lines.extend(format_device(device) for device in devices)
+        return "\n".join(lines)
+    
+    def warm_up(self):
+        """Open the CEC adapter and learn the TV's power, then tell the Flipper the Pi is ready"""
+        start = time.monotonic()
+        adapter_ok = True
+        if WARM_UP:
+            try:
+                self.status(refresh=True)
+            except Exception as e:
+                logger.error("❌ CEC adapter failed to open: " + str(e))
+                adapter_ok = False
+        self.startup["adapter_ms"] = int((time.monotonic() - start) * 1000)
+        self.startup["ready_after_boot_s"] = uptime()
+        logger.info("🔥 Ready for the Flipper, adapter took " + str(self.startup["adapter_ms"]) + " ms" +
+                    self.format_boot_time(self.startup["ready_after_boot_s"]))
+        self.send_reply(encode_event_frame(EVENT_READY, EVENT_NO_DEVICE, 1 if adapter_ok else 0))
+        
+        # Further adapters open after that, together; the Flipper only waits for the first
+        if WARM_UP:
+            try:
+                others = get_adapters().adapters[1:]
+                for name, success, output in get_adapters().run(others, "pow 0", timeout=5):
+                    lines = output.strip().splitlines()
+                    logger.info(("✅ " if success else "❌ ") + "Adapter " + name + ": " + (lines[-1] if lines else "no answer"))
+            except Exception as e:
+                logger.error("❌ CEC adapters: " + str(e))
+    
+    def note_command(self, command, response):
+        """Remember when the first real command succeeded"""
+        if "first_command_after_boot_s" in self.startup or response.get("status") != "success":
+            return
+        cmd_type = command.get('command', '').upper() if isinstance(command, dict) else ''
+        if cmd_type in ('', 'PING', 'STATS'):
+            return
+        self.startup["first_command_after_boot_s"] = uptime()
+        logger.info("⏱️ First command (" + cmd_type + ")" +
+                    self.format_boot_time(self.startup["first_command_after_boot_s"]))
+    
+    def format_boot_time(self, seconds):
+        return "" if seconds is None else ", %.1f s after boot" % seconds
+    
+    def format_startup(self):
+        """One line for STATS: boot to service start, ready and first command"""
+        parts = []
+        for key, label in (("started_after_boot_s", "start"), ("ready_after_boot_s", "ready"),
+                           ("first_command_after_boot_s", "first cmd")):
+            if self.startup.get(key) is not None:
+                parts.append(label + " %.1fs" % self.startup[key])
+        if "adapter_ms" in self.startup:
+            parts.append("adapter " + str(self.startup["adapter_ms"]) + "ms")
+        return "⏱️ Boot: " + (", ".join(parts) if parts else "n/a")
+    
+    def status(self, refresh=False):
+        """TV power and active source from the bus state; asks the TV when refresh is set or power is unknown"""
+        state = get_bus_state()
+        if refresh or state.get(0, "power") is None:
+            try:
+                success, output = get_scheduler().execute("pow 0", timeout=5)
+            except CECTimeout:
+                return {"status": "error", "result": "❌ Command timed out: pow 0"}
+            if not success:
+                return {"status": "error", "result": "❌ Command failed: " + output}
+            # libcec may answer from its own cache without a frame on the bus
+            state.note_output("pow 0", output)
+        return {"status": "success", "result": state.format_status(), "state": state.to_dict()}
+    
+    def run_cec(self, adapters, cec_command, vendor="Unknown", timeout=10):
+        """One CEC command on the request's adapters, all at once and answered per display"""
+        if adapters == [get_adapters().primary] and adapters[0].scheduler:
+            return {"status": "success", "result": execute_cec_command(cec_command, vendor, timeout)}
+        logger.info("Executing CEC command on " + ", ".join(adapter.name for adapter in adapters) + ": " + cec_command)
+        return format_results(cec_command, get_adapters().run(adapters, cec_command, timeout))
+    
+    def handle_command(self, command, progress=None):
+        """Process CEC command - clean and simple"""
+        try:
             cmd_type = command.get('command', '').upper()
             vendor = "Unknown"
+            trace = latency.current()
+            if trace:
+                trace.command = cmd_type or "UNKNOWN"
+            
+            # Which displays the command is for; PING and STATS are about the Pi itself
+            if cmd_type not in ('PING', 'STATS'):
+                try:
+                    adapters = get_adapters().resolve(command.get('adapter'))
+                except AdapterError as e:
+                    return {"status": "error", "result": "❌ " + str(e)}
+                single = adapters == [get_adapters().primary]
+                if not single and (cmd_type in ('DISCOVER', 'SEQUENCE') or
+                                   (cmd_type == 'SCAN' and command.get('refresh'))):
+                    return {"status": "error", "result": "❌ " + cmd_type + " runs on the first adapter only"}
             
             if cmd_type == 'PING':
-                return json.dumps({"status": "success", "result": "pong"})
+                response = {"status": "success", "result": "pong"}
+                if 'proto' in command:
+                    # A Flipper (re)connecting asks for events again once it is ready for them
+                    self.watching = False
+                if command.get('proto') == PROTOCOL_VERSION:
+                    # Offer binary framing to Flippers speaking our version
+                    response["proto"] = PROTOCOL_VERSION
+                return response
             
             elif cmd_type == 'SCAN':
-                result = execute_cec_command("scan", "System", timeout=15)
-                return json.dumps({"status": "success", "result": result})
+                if command.get('refresh'):
+                    # Rescans into the device cache vendor detection reads, dropping what it held;
+                    # imported here so the daemon's logging and startup do not pull in cec_control
+                    from cec_control import refresh_devices
+                    return {"status": "success", "result": refresh_devices()}
+                return self.run_cec(adapters, "scan", "System", timeout=15)
+            
+            elif cmd_type == 'DISCOVER':
+                result = self.discover(bool(command.get('full')), progress)
+                return {"status": "success", "result": result}
+            
+            elif cmd_type == 'SEQUENCE':
+                try:
+                    recipe = parse_sequence(command)
+                except SequenceError as e:
+                    return {"status": "error", "result": "❌ Bad sequence: " + str(e)}
+                if recipe["adaptive"]:
+                    success, result = run_adaptive(get_scheduler(), recipe, get_timing_store(), progress)
+                else:
+                    success, result = run_sequence(get_scheduler(), recipe, progress)
+                return {"status": "success" if success else "error", "result": result}
+            
+            elif cmd_type == 'STATS':
+                # Still answered when the first adapter did not open
+                primary = get_adapters().primary
+                if command.get('reset'):
+                    latency.STATS.reset()
+                    if primary.scheduler:
+                        primary.scheduler.reset_stats()
+                    return {"status": "success", "result": "✅ Latency stats reset"}
+                # Full numbers for tools, short lines for the Flipper screen
+                response = {"status": "success",
+                            "result": latency.STATS.format_text() + "\n" +
+                                      (primary.scheduler.format_text() if primary.scheduler else primary.error) +
+                                      "\n" + self.format_startup(),
+                            "stats": latency.STATS.to_dict(),
+                            "scheduler": primary.scheduler.to_dict() if primary.scheduler else None,
+                            "startup": self.startup}
+                if len(get_adapters().adapters) > 1:
+                    response["adapters"] = get_adapters().to_dict()
+                return response
             
             elif cmd_type == 'STATUS':
-                result = execute_cec_command("pow 0", "System", timeout=5)
-                return json.dumps({"status": "success", "result": result})
+                if not single:
+                    # Only the first adapter's bus is followed, the others are asked
+                    return self.run_cec(adapters, "pow 0", timeout=5)
+                return self.status(bool(command.get('refresh')))
             
             elif cmd_type == 'CUSTOM':
                 cec_command = command.get('cec_command', '')
@@ -107,67 +486,71 @@ class CECController:
                     elif "10:" in cec_command:
                         vendor = "Generic/Projector"
                     
-                    result = execute_cec_command(cec_command, vendor)
-                    return json.dumps({"status": "success", "result": result})
+                    # pow, ven and name the bus already told us about need no round trip
+                    if single and not command.get('refresh'):
+                        known = get_bus_state().answer(cec_command)
+                        if known:
+                            return {"status": "success", "result": "✅ " + known}
+                    
+                    return self.run_cec(adapters, cec_command, vendor)
                 else:
-                    return json.dumps({"status": "error", "result": "No CEC command provided"})
+                    return {"status": "error", "result": "No CEC command provided"}
             
             # Direct power commands
             elif cmd_type == 'POWER_ON':
-                result = execute_cec_command("on 0", vendor)
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "on 0", vendor)
             
             elif cmd_type == 'POWER_OFF':
-                result = execute_cec_command("standby 0", vendor)
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "standby 0", vendor)
             
             # HDMI input switching
             elif cmd_type == 'HDMI_1':
-                result = execute_cec_command("tx 4F:82:10:00", "Samsung")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "tx 4F:82:10:00", "Samsung")
             
             elif cmd_type == 'HDMI_2':
-                result = execute_cec_command("tx 4F:82:20:00", "Samsung")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "tx 4F:82:20:00", "Samsung")
             
             elif cmd_type == 'HDMI_3':
-                result = execute_cec_command("tx 4F:82:30:00", "Samsung")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "tx 4F:82:30:00", "Samsung")
             
             elif cmd_type == 'HDMI_4':
-                result = execute_cec_command("tx 4F:82:40:00", "Samsung")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "tx 4F:82:40:00", "Samsung")
             
             # Volume commands
             elif cmd_type == 'VOLUME_UP':
-                result = execute_cec_command("volup", "Generic")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "volup", "Generic")
             
             elif cmd_type == 'VOLUME_DOWN':
-                result = execute_cec_command("voldown", "Generic")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "voldown", "Generic")
             
             elif cmd_type == 'MUTE':
-                result = execute_cec_command("mute", "Generic")
-                return json.dumps({"status": "success", "result": result})
+                return self.run_cec(adapters, "mute", "Generic")
             
             else:
-                return json.dumps({"status": "error", "result": "Unknown command: " + cmd_type})
+                return {"status": "error", "result": "Unknown command: " + cmd_type}
                 
-        except json.JSONDecodeError:
-            return json.dumps({"status": "error", "result": "Invalid JSON"})
         except Exception as e:
             logger.error("Command processing error: " + str(e))
-            return json.dumps({"status": "error", "result": str(e)})
+            return {"status": "error", "result": str(e)}
     
     def run(self):
         """Main application loop"""
         self.running = True
         
         logger.info("🚀 ICSS CEC Controller v3.0 - Professional Field Tool")
+        self.startup["started_after_boot_s"] = uptime()
+        
+        # Follow bus traffic from the start, so STATUS rarely has to ask; an adapter
+        # that does not open yet is followed once a command opens it, see get_adapters()
+        try:
+            get_bus_state()
+        except Exception as e:
+            logger.error("❌ CEC adapter failed to open: " + str(e))
         
-        # Start UART interface
+        # Start UART and HTTP interfaces; PINGs are answered while the adapter opens
         self.start_uart_interface()
+        self.start_http_interface()
+        self.warm_up()
         
         logger.info("CEC Controller running with static ICSS display")
         
@@ -178,11 +561,25 @@ class CECController:
     def stop(self):
         """Stop all interfaces"""
         self.running = False
+        os.write(self.wake_write, b'x')
+        if self.uart_thread:
+            self.uart_thread.join(timeout=2)
+        # Let in-flight commands write their replies before the port goes away
+        self.executor.shutdown(wait=True, cancel_futures=True)
         if self.uart_serial:
             try:
                 self.uart_serial.close()
             except:
                 pass
+        if self.http:
+            self.http.stop()
+        self.keys.stop()
+        self.watching = False
+        self.presence_stop.set()
+        stop_adapters()
+        stop_scheduler()
+        stop_bus_state()
+        stop_backend()
         logger.info("CEC Controller stopped")
 
 def signal_handler(sig, frame):
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Learned power-on timing per device
+An adaptive SEQUENCE (see sequence.py) checks the power status during its
+delays and reports when the device came on: after which step, and how many
+seconds into that wait. That is remembered per device (vendor ID and OSD
+name of the target) and recipe, in TIMING_FILE, so it survives restarts.
+
+The next power-on of the same device runs the recipe once with the learned
+timing: the first check comes shortly before the device is expected to be
+on, and that wait ends a little after it, well inside the recipe's own
+delay. The waits before it keep the recipe's values; they are spacing the
+vendor asked for, not a wake-up we can observe. If that run does not bring
+the device on, the recipe runs again with its own conservative delays and
+the timing is learned afresh from that run.
+"""
+import hashlib
+import json
+import logging
+import os
+import threading
+import time
+from datetime import datetime
+from command_journal import DEFAULT_DIR
+from bus_state import get_bus_state
+from sequence import run_sequence, STEP_TIMEOUT
+
+logger = logging.getLogger("power_timing")
+
+TIMING_FILE = os.environ.get("CEC_TIMING_FILE", os.path.join(DEFAULT_DIR, "power_timing.json"))
+
+# First check at this share of the learned time, last at this multiple plus MARGIN_SECONDS
+EARLY = 0.8
+LATE = 1.5
+MARGIN_SECONDS = 0.5
+
+
+def recipe_signature(recipe):
+    """Short hash of the steps and condition, so a changed recipe starts over"""
+    text = "|".join(step["cec"] for step in recipe["steps"]) + "|" + recipe["until"]["cec"]
+    return hashlib.sha1(text.encode()).hexdigest()[:8]
+
+
+def until_address(recipe):
+    """Logical address the condition asks about, "pow 0" -> 0"""
+    try:
+        return int(recipe["until"]["cec"].split()[1], 16) & 0xF
+    except (IndexError, ValueError):
+        return 0
+
+
+def identify(session, address):
+    """(vendor, OSD name) of a device, from the bus state or asked once; None when it does not say"""
+    state = get_bus_state()
+    fields = {}
+    for field, verb in (("vendor", "ven"), ("name", "name")):
+        known = state.get(address, field, max_age=float("inf"))
+        if known is None:
+            command = f"{verb} {address:x}"
+            try:
+                success, output = session.execute(command, timeout=STEP_TIMEOUT)
+            except Exception:
+                success = False
+            if success:
+                state.note_output(command, output)
+                known = state.get(address, field, max_age=float("inf"))
+        fields[field] = known[0] if known else None
+    if not fields["vendor"] and not fields["name"]:
+        return None
+    return fields["vendor"] or "Unknown", fields["name"] or ""
+
+
+class TimingStore:
+    """Learned wake-up per device and recipe, kept in a JSON file"""
+    def __init__(self, path=TIMING_FILE):
+        self.path = path
+        self.lock = threading.Lock()
+        self.devices = {}
+        try:
+            with open(path) as f:
+                self.devices = json.load(f).get("devices", {})
+        except FileNotFoundError:
+            pass
+        except (OSError, ValueError, AttributeError) as e:
+            logger.warning(f"⚠️ Ignoring power timing file {path}: {e}")
+
+    def _save(self):
+        try:
+            os.makedirs(os.path.dirname(self.path) or ".", exist_ok=True)
+            temp = self.path + ".tmp"
+            with open(temp, "w") as f:
+                json.dump({"devices": self.devices}, f, indent=1, sort_keys=True)
+            os.replace(temp, self.path)
+        except OSError as e:
+            logger.warning(f"⚠️ Could not save power timing: {e}")
+
+    def get(self, key):
+        with self.lock:
+            entry = self.devices.get(key)
+            return dict(entry) if entry else None
+
+    def learned_recipe(self, recipe, entry):
+        """One attempt of recipe with the learned wait; None when the entry no longer fits it"""
+        index, seen = entry["index"], entry["seconds"]
+        if index > len(recipe["steps"]):
+            return None
+        learned = dict(recipe, attempts=1, steps=[dict(step) for step in recipe["steps"]])
+        bound = seen * LATE + MARGIN_SECONDS
+        if index == len(recipe["steps"]):
+            learned["check_after"] = seen * EARLY
+            learned["settle"] = min(recipe["settle"], bound)
+        else:
+            step = learned["steps"][index]
+            step["check_after"] = seen * EARLY
+            step["delay"] = min(step["delay"], bound)
+        return learned
+
+    def learn(self, key, device, held, fallback):
+        """Remember where the condition held; held is (wait index, seconds) from run_sequence"""
+        with self.lock:
+            entry = self.devices.get(key, {"runs": 0, "fallbacks": 0})
+            entry.update({"vendor": device[0], "name": device[1], "index": held[0],
+                          "seconds": round(held[1], 3), "runs": entry["runs"] + 1,
+                          "fallbacks": entry["fallbacks"] + (1 if fallback else 0),
+                          "updated": datetime.now().isoformat(timespec="seconds")})
+            self.devices[key] = entry
+            self._save()
+
+    def forget(self, key):
+        with self.lock:
+            if self.devices.pop(key, None) is not None:
+                self._save()
+
+
+def run_adaptive(session, recipe, store, progress=None):
+    """Run an adaptive recipe with what store knows of its device, (success, summary text)"""
+    address = until_address(recipe)
+    device = identify(session, address)
+    key = f"{device[0]}|{device[1]}|{recipe_signature(recipe)}" if device else None
+    # A device that is on already says nothing about how long it takes to wake
+    power = get_bus_state().get(address, "power")
+    if power and power[0] == "on":
+        key = None
+    entry = store.get(key) if key else None
+    learned = store.learned_recipe(recipe, entry) if entry else None
+    start = time.monotonic()
+
+    if learned:
+        report = {}
+        success, summary = run_sequence(session, learned, progress, report)
+        if success and report.get("held"):
+            store.learn(key, device, report["held"], fallback=False)
+            return True, f"{summary}, learned timing for {device[1] or device[0]}"
+        logger.info(f"⏱️ Learned timing for {device[1] or device[0]} did not work, using the recipe's delays")
+        if progress:
+            progress("learned timing failed, using defaults")
+
+    report = {}
+    success, summary = run_sequence(session, recipe, progress, report)
+    if key and success and report.get("held"):
+        store.learn(key, device, report["held"], fallback=bool(learned))
+        index, seconds = report["held"]
+        logger.info(f"⏱️ {device[1] or device[0]} on {seconds:.2f} s into wait {index + 1}")
+    elif key and learned:
+        store.forget(key)
+    if learned:
+        summary += f", learned timing failed first ({time.monotonic() - start:.1f} s in all)"
+    return success, summary
+
+
+_store = None
+_store_lock = threading.Lock()
+
+
+def get_timing_store():
+    global _store
+    with _store_lock:
+        if _store is None:
+            _store = TimingStore()
+        return _store
@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+"""
+Priority scheduler in front of the CEC backend
+Every CEC command from the daemon is queued here and run by one worker,
+highest class first and oldest first within a class:
+  CONTROL  power, input switching, volume and raw frames
+  QUERY    power status and other questions to one device
+  BULK     scans and discovery
+A SCAN already queued no longer delays a POWER_OFF; DISCOVER runs as many
+short polls, so control commands get in between them. A single long
+command (cec-client's own "scan") still runs to the end once started.
+
+Queued commands are merged before they run:
+  - identical queries wait on one run
+  - volume steps queued together run as their net count in one job, so ten
+    VOLUME_UP presses become one job of ten steps and up/down pairs cancel
+  - a newer power or input command for the same device supersedes one still
+    queued; the older request is answered as superseded
+The worker leaves the backend's min_gap between commands on the bus.
+"""
+import contextlib
+import threading
+import time
+import logging
+import latency
+from cec_backend import get_backend
+
+logger = logging.getLogger("scheduler")
+
+CONTROL = 0
+QUERY = 1
+BULK = 2
+CLASS_NAMES = ("control", "query", "bulk")
+
+CONTROL_VERBS = ("on", "standby", "tx", "txn", "as", "is", "volup", "voldown", "mute")
+BULK_VERBS = ("scan",)
+VOLUME_STEPS = {"volup": 1, "voldown": -1}
+
+# CEC opcodes whose newest instance is the only one that matters
+POWER_OPCODES = (0x04, 0x0D, 0x36)        # Image View On, Text View On, Standby
+INPUT_OPCODES = (0x80, 0x82, 0x86)        # Routing Change, Active Source, Set Stream Path
+
+# A caller gives up on a job that has not finished this long after its own timeout
+QUEUE_TIMEOUT = 60
+
+_local = threading.local()
+
+
+def classify(command):
+    verb = command.split(" ", 1)[0].lower()
+    if verb in CONTROL_VERBS:
+        return CONTROL
+    if verb in BULK_VERBS:
+        return BULK
+    return QUERY
+
+
+def supersede_key(command):
+    """(kind, destination) for power and input commands, None for everything else"""
+    parts = command.split(None, 1)
+    verb = parts[0].lower() if parts else ""
+    if verb in ("on", "standby"):
+        try:
+            return ("power", int(parts[1].split()[0], 16) & 0xF)
+        except (IndexError, ValueError):
+            return ("power", 0)
+    if verb in ("tx", "txn") and len(parts) > 1:
+        try:
+            frame = [int(b, 16) for b in parts[1].replace(" ", ":").split(":") if b]
+        except ValueError:
+            return None
+        if len(frame) >= 2 and frame[1] in POWER_OPCODES:
+            return ("power", frame[0] & 0xF)
+        if len(frame) >= 2 and frame[1] in INPUT_OPCODES:
+            return ("input", frame[0] & 0xF)
+    return None
+
+
+class Job:
+    def __init__(self, command, timeout, priority):
+        self.command = command
+        self.timeout = timeout
+        self.priority = priority
+        self.verb = command.split(" ", 1)[0].lower()
+        self.key = supersede_key(command)
+        self.steps = VOLUME_STEPS.get(self.verb, 0)  # Net volume steps, + up, - down
+        self.waiters = [(time.monotonic(), latency.current())]
+        self.done = threading.Event()
+        self.result = None
+        self.error = None
+
+    def finish(self, result=None, error=None):
+        self.result = result
+        self.error = error
+        self.done.set()
+
+
+class ClassStats:
+    def __init__(self):
+        self.depth = 0
+        self.max_depth = 0
+        self.jobs = 0
+        self.merged = 0
+        self.superseded = 0
+        self.wait = latency.Histogram()
+
+
+class CommandScheduler:
+    def __init__(self, backend):
+        self.backend = backend
+        self.name = backend.name
+        self.min_gap = backend.min_gap
+        self.cond = threading.Condition()
+        self.queues = ([], [], [])
+        self.stats = [ClassStats() for _ in CLASS_NAMES]
+        self.since = time.monotonic()
+        self.last_end = 0.0
+        self.running = True
+        self.worker = threading.Thread(target=self._worker_loop)
+        self.worker.daemon = True
+        self.worker.start()
+
+    def add_listener(self, callback):
+        self.backend.add_listener(callback)
+
+    @contextlib.contextmanager
+    def priority(self, priority):
+        """Commands issued by this thread inside the block go into priority"""
+        previous = getattr(_local, "priority", None)
+        _local.priority = priority
+        try:
+            yield
+        finally:
+            _local.priority = previous
+
+    def execute(self, command, timeout=10, priority=None):
+        """Queue one command and wait for its (success, output)"""
+        return self.wait(self.submit(command, timeout, priority), timeout)
+
+    def submit(self, command, timeout=10, priority=None):
+        """Queue one command without waiting; hand the job to wait()"""
+        if priority is None:
+            priority = getattr(_local, "priority", None)
+        if priority is None:
+            priority = classify(command)
+        job = Job(command, timeout, priority)
+
+        with self.cond:
+            target = self._merge(job)
+            if target is None:
+                target = job
+                self.queues[priority].append(job)
+                stats = self.stats[priority]
+                stats.depth += 1
+                stats.max_depth = max(stats.max_depth, stats.depth)
+                self.cond.notify()
+        return target
+
+    def wait(self, job, timeout=10):
+        """(success, output) of a submitted job, or the error it raised"""
+        if not job.done.wait(timeout + QUEUE_TIMEOUT):
+            return False, f"Command not scheduled in time: {job.command}"
+        if job.error is not None:
+            raise job.error
+        return job.result
+
+    def _merge(self, job):
+        """Fold job into a queued one; returns the job to wait on, None to queue it"""
+        queue = self.queues[job.priority]
+        stats = self.stats[job.priority]
+        if job.steps:
+            for queued in queue:
+                if queued.verb in VOLUME_STEPS:
+                    queued.steps += job.steps
+                    queued.waiters += job.waiters
+                    stats.merged += 1
+                    return queued
+        elif job.key is not None:
+            for queued in queue:
+                if queued.key == job.key:
+                    queue.remove(queued)
+                    stats.depth -= 1
+                    stats.superseded += 1
+                    logger.info(f"⏭️ '{queued.command}' superseded by '{job.command}'")
+                    queued.finish((True, f"⏭️ Superseded by {job.command}"))
+                    break
+        elif job.priority != CONTROL:
+            for queued in queue:
+                if queued.command == job.command:
+                    queued.waiters += job.waiters
+                    stats.merged += 1
+                    return queued
+        return None
+
+    def _next_job(self):
+        for priority, queue in enumerate(self.queues):
+            if queue:
+                self.stats[priority].depth -= 1
+                return queue.pop(0)
+        return None
+
+    def _worker_loop(self):
+        while True:
+            with self.cond:
+                job = self._next_job()
+                while job is None and self.running:
+                    self.cond.wait()
+                    job = self._next_job()
+                if job is None:
+                    return
+
+            gap = self.last_end + self.min_gap - time.monotonic()
+            if gap > 0:
+                time.sleep(gap)
+            started = time.monotonic()
+            with self.cond:
+                stats = self.stats[job.priority]
+                stats.jobs += 1
+                for submitted, _ in job.waiters:
+                    stats.wait.add((started - submitted) * 1000.0)
+            try:
+                result, error = self._run(job), None
+            except Exception as e:
+                result, error = None, e
+            self.last_end = time.monotonic()
+
+            for submitted, trace in job.waiters:
+                if trace is not None:
+                    latency.note_cec(started - submitted, self.last_end - started, trace)
+            job.finish(result, error)
+
+    def _run(self, job):
+        if job.verb not in VOLUME_STEPS:
+            return self.backend.execute(job.command, timeout=job.timeout)
+        if job.steps == 0:
+            return True, "🔊 Volume unchanged, up and down steps cancelled out"
+        verb = "volup" if job.steps > 0 else "voldown"
+        success, output = True, ""
+        for step in range(abs(job.steps)):
+            if step:
+                time.sleep(self.min_gap)
+            success, output = self.backend.execute(verb, timeout=job.timeout)
+            if not success:
+                break
+        if abs(job.steps) > 1:
+            output += f"\n{verb} x{abs(job.steps)}"
+        return success, output
+
+    def reset_stats(self):
+        with self.cond:
+            for stats in self.stats:
+                stats.max_depth = stats.depth
+                stats.jobs = stats.merged = stats.superseded = 0
+                stats.wait = latency.Histogram()
+            self.since = time.monotonic()
+
+    def to_dict(self):
+        """Per class: queue depth now and at most, jobs run, merges and waits in ms"""
+        with self.cond:
+            classes = {}
+            for name, stats in zip(CLASS_NAMES, self.stats):
+                classes[name] = {
+                    "depth": stats.depth,
+                    "max_depth": stats.max_depth,
+                    "jobs": stats.jobs,
+                    "merged": stats.merged,
+                    "superseded": stats.superseded,
+                    "wait": {p: round(stats.wait.percentile(int(p[1:])), 3) for p in ("p50", "p95", "p99")},
+                }
+            return {"seconds": round(time.monotonic() - self.since, 1), "classes": classes}
+
+    def format_text(self):
+        """Short lines for the Flipper's result screen"""
+        lines = ["🚦 Queue wait ms p50/p95/p99"]
+        for name, entry in self.to_dict()["classes"].items():
+            if not entry["jobs"] and not entry["depth"]:
+                continue
+            lines.append(f"{name} n={entry['jobs']} q={entry['depth']}/{entry['max_depth']} "
+                         f"m={entry['merged'] + entry['superseded']}")
+            lines.append(" wait " + "/".join(f"{entry['wait'][p]:.0f}" for p in ("p50", "p95", "p99")))
+        if len(lines) == 1:
+            lines.append("No commands yet")
+        return "\n".join(lines)
+
+    def stop(self):
+        with self.cond:
+            self.running = False
+            self.cond.notify_all()
+        self.worker.join(timeout=2)
+
+
+_scheduler = None
+_scheduler_lock = threading.Lock()
+
+
+def get_scheduler():
+    """Shared scheduler every command path in the daemon queues on"""
+    global _scheduler
+    with _scheduler_lock:
+        if _scheduler is None:
+            _scheduler = CommandScheduler(get_backend())
+        return _scheduler
+
+
+def stop_scheduler():
+    global _scheduler
+    with _scheduler_lock:
+        if _scheduler is not None:
+            _scheduler.stop()
+            _scheduler = None
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+Sequence engine for multi-step CEC recipes
+Runs a list of cec-client commands on the shared CEC backend with per-step
+delays and retries, checks a completion condition and repeats the whole
+recipe up to a number of attempts, so a vendor wake-up is one request
+from the Flipper instead of one per step.
+
+A sequence is a dict:
+  {"steps": [{"cec": "tx 10:04", "delay": 1.5, "retries": 1}, ...],
+   "attempts": 2,                  # whole-recipe retries
+   "settle": 2.0,                  # wait before checking the condition
+   "until": {"cec": "pow 0", "match": "power status:\\s*on"}}
+"until" is optional; without it the sequence succeeds when every step did.
+
+With "adaptive": true (needs "until") the delays and the settle time are
+upper bounds instead of fixed sleeps: the condition is checked during each
+of them with backoff from POLL_FIRST to POLL_MAX_INTERVAL, and once it holds
+the remaining steps run without waiting. A step may carry "check_after",
+the time to wait before the first check, which power_timing.py sets from
+what it learned about the device.
+"""
+import re
+import time
+import logging
+
+logger = logging.getLogger("sequence")
+
+MAX_STEPS = 16
+MAX_ATTEMPTS = 5
+MAX_RETRIES = 5
+MAX_DELAY = 10.0
+
+STEP_TIMEOUT = 10
+
+# Checks of the condition during an adaptive wait: first after POLL_FIRST, then doubling
+POLL_FIRST = 0.1
+POLL_MAX_INTERVAL = 1.0
+
+
+class SequenceError(Exception):
+    """Raised for sequences that are malformed or exceed the limits"""
+
+
+def _number(value, name, limit):
+    try:
+        number = float(value)
+    except (TypeError, ValueError):
+        raise SequenceError(f"{name} must be a number")
+    if number < 0 or number > limit:
+        raise SequenceError(f"{name} must be between 0 and {limit}")
+    return number
+
+
+def parse_sequence(command):
+    """Validate a SEQUENCE request and return the normalised recipe"""
+    steps = command.get("steps")
+    if not isinstance(steps, list) or not steps:
+        raise SequenceError("No steps provided")
+    if len(steps) > MAX_STEPS:
+        raise SequenceError(f"Too many steps (max {MAX_STEPS})")
+
+    recipe = {"steps": [], "until": None}
+    for index, step in enumerate(steps, start=1):
+        if isinstance(step, str):
+            step = {"cec": step}
+        if not isinstance(step, dict) or not str(step.get("cec", "")).strip():
+            raise SequenceError(f"Step {index} has no cec command")
+        recipe["steps"].append({
+            "cec": str(step["cec"]).strip(),
+            "delay": _number(step.get("delay", 0), f"step {index} delay", MAX_DELAY),
+            "retries": int(_number(step.get("retries", 0), f"step {index} retries", MAX_RETRIES)),
+        })
+
+    recipe["attempts"] = max(1, int(_number(command.get("attempts", 1), "attempts", MAX_ATTEMPTS)))
+    recipe["settle"] = _number(command.get("settle", 0), "settle", MAX_DELAY)
+    recipe["adaptive"] = bool(command.get("adaptive"))
+
+    until = command.get("until")
+    if until:
+        if not isinstance(until, dict) or not until.get("cec"):
+            raise SequenceError("until needs a cec command")
+        try:
+            pattern = re.compile(until.get("match", "."), re.I)
+        except re.error as e:
+            raise SequenceError(f"Bad until match: {e}")
+        recipe["until"] = {"cec": str(until["cec"]).strip(), "pattern": pattern}
+    elif recipe["adaptive"]:
+        raise SequenceError("adaptive needs an until condition")
+    return recipe
+
+
+def _run_step(session, step):
+    """Run one step with its retries, returns (success, output)"""
+    for attempt in range(step["retries"] + 1):
+        try:
+            success, output = session.execute(step["cec"], timeout=STEP_TIMEOUT)
+        except Exception as e:
+            success, output = False, str(e)
+        if success:
+            return True, output
+        logger.warning(f"Step '{step['cec']}' failed (try {attempt + 1}): {output}")
+    return False, output
+
+
+def _check(session, until):
+    """(condition holds, status output)"""
+    try:
+        _, status = session.execute(until["cec"], timeout=STEP_TIMEOUT)
+    except Exception as e:
+        status = str(e)
+    return bool(until["pattern"].search(status)), status
+
+
+def _wait_for(session, until, bound, check_after, report):
+    """Wait up to bound seconds for the condition, checking with backoff; (holds, waited, status)"""
+    start = time.monotonic()
+    interval = POLL_FIRST
+    pause = max(POLL_FIRST, min(check_after, bound))
+    status = ""
+    while True:
+        remaining = bound - (time.monotonic() - start)
+        if remaining <= 0:
+            return False, bound, status
+        time.sleep(min(pause, remaining))
+        holds, status = _check(session, until)
+        report["checks"] = report.get("checks", 0) + 1
+        if holds:
+            return True, time.monotonic() - start, status
+        pause = interval = min(interval * 2, POLL_MAX_INTERVAL)
+
+
+def run_sequence(session, recipe, progress=None, report=None):
+    """Run a parsed recipe, returns (success, summary text)
+
+    progress(text), when given, receives one line per step as it finishes.
+    An adaptive recipe fills report, when given, with "held": (index of
+    the wait, seconds into it) where the condition first held on the
+    last attempt, index len(steps) being the settle time, and "checks".
+    """
+    start = time.monotonic()
+    steps = recipe["steps"]
+    until = recipe["until"]
+    adaptive = recipe.get("adaptive") and until
+    report = {} if report is None else report
+    status = ""
+
+    for attempt in range(1, recipe["attempts"] + 1):
+        failed = 0
+        report["held"] = None
+        for index, step in enumerate(steps, start=1):
+            success, _ = _run_step(session, step)
+            if not success:
+                failed += 1
+            if progress:
+                progress(f"{attempt}.{index} {step['cec']} {'ok' if success else 'failed'}")
+            if not step["delay"]:
+                continue
+            if not adaptive:
+                time.sleep(step["delay"])
+            elif report["held"] is None:
+                holds, waited, status = _wait_for(session, until, step["delay"], step.get("check_after", 0), report)
+                if holds:
+                    report["held"] = (index - 1, waited)
+
+        if adaptive and report["held"] is not None:
+            # Held after an earlier step already: one more look instead of the settle time
+            done, status = _check(session, until)
+            report["checks"] = report.get("checks", 0) + 1
+        elif adaptive:
+            done, waited, status = _wait_for(session, until, recipe["settle"], recipe.get("check_after", 0), report)
+            if done:
+                report["held"] = (len(steps), waited)
+            elif not recipe["settle"]:
+                done, status = _check(session, until)
+        elif until:
+            if recipe["settle"]:
+                time.sleep(recipe["settle"])
+            done, status = _check(session, until)
+        else:
+            done = failed == 0
+
+        if done:
+            elapsed = time.monotonic() - start
+            return True, (f"✅ Sequence complete after {attempt} attempt{'s' if attempt > 1 else ''} "
+                          f"({len(steps)} steps, {elapsed:.1f} s)")
+        logger.info(f"Sequence attempt {attempt} incomplete ({failed} failed steps)")
+
+    elapsed = time.monotonic() - start
+    reason = status.strip().splitlines()[-1] if until and status.strip() else f"{failed} steps failed"
+    return False, f"❌ Sequence failed after {recipe['attempts']} attempts ({elapsed:.1f} s): {reason}"
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+Status renderer for the HDMI output
+Runs for as long as the Pi is up and draws straight to the Linux framebuffer
+(/dev/fb0, which KMS provides on top of DRM too), so no X server, window
+manager or image viewer is involved. Every status image is decoded and
+converted to the framebuffer's pixel layout once, at startup; a status change
+is then a single copy into the mapped framebuffer.
+
+Statuses are asked for over a Unix datagram socket (SOCKET_PATH), one name
+per datagram, e.g. b"sending". A sender with an address of its own gets
+b"ok" or b"unknown" back once the image is on screen; update_display.py
+is the client.
+
+Images come from IMAGE_DIR. Binary PPMs of the screen's size are read
+directly; anything else (the PNGs create_graphics.sh makes) goes through
+ImageMagick's convert once, at startup.
+"""
+import fcntl
+import logging
+import mmap
+import os
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+logger = logging.getLogger("status_display")
+
+SOCKET_PATH = os.environ.get("CEC_DISPLAY_SOCKET", "/run/cec-display.sock")
+FB_DEVICE = os.environ.get("CEC_FB_DEVICE", "/dev/fb0")
+IMAGE_DIR = os.environ.get("CEC_DISPLAY_DIR", os.path.expanduser("~"))
+CONSOLE = "/dev/tty1"
+
+# Status name -> image file in IMAGE_DIR; 'idle' is shown at startup
+STATUS_IMAGES = {
+    "idle": "icss_display.png",
+    "ready": "status_ready.png",
+    "sending": "status_sending.png",
+    "success": "status_success.png",
+    "error": "status_error.png",
+}
+
+FBIOGET_VSCREENINFO = 0x4600
+FBIOGET_FSCREENINFO = 0x4602
+FBIOBLANK = 0x4611
+FB_BLANK_UNBLANK = 0
+KDSETMODE = 0x4B3A
+KD_TEXT = 0x00
+KD_GRAPHICS = 0x01
+
+# struct fb_var_screeninfo up to the colour bitfields, and struct fb_fix_screeninfo
+VAR_SCREENINFO = struct.Struct("8I12I")
+VAR_SCREENINFO_SIZE = 160
+FIX_SCREENINFO = struct.Struct("@16sL4I3HI")
+FIX_SCREENINFO_SIZE = 80
+
+
+class Framebuffer:
+    """A mapped framebuffer and its pixel layout"""
+    def __init__(self, path=FB_DEVICE, geometry=None):
+        self.fd = os.open(path, os.O_RDWR)
+        if geometry:
+            # A plain file standing in for the device: WIDTHxHEIGHTxBPP, RGB565 or XRGB8888
+            self.width, self.height, self.bpp = (int(value) for value in geometry.split("x"))
+            self.stride = self.width * self.bpp // 8
+            self.channels = [(11, 5), (5, 6), (0, 5)] if self.bpp == 16 else [(16, 8), (8, 8), (0, 8)]
+        else:
+            var = VAR_SCREENINFO.unpack_from(fcntl.ioctl(self.fd, FBIOGET_VSCREENINFO, bytes(VAR_SCREENINFO_SIZE)))
+            fix = FIX_SCREENINFO.unpack(fcntl.ioctl(self.fd, FBIOGET_FSCREENINFO,
+                                                    bytes(FIX_SCREENINFO_SIZE))[:FIX_SCREENINFO.size])
+            self.width, self.height, self.bpp = var[0], var[1], var[6]
+            self.stride = fix[-1]
+            # (offset, length) of red, green and blue in a pixel
+            self.channels = [(var[8], var[9]), (var[11], var[12]), (var[14], var[15])]
+            try:
+                fcntl.ioctl(self.fd, FBIOBLANK, FB_BLANK_UNBLANK)
+            except OSError:
+                pass
+        if self.bpp != 16 and not all(length == 8 and offset % 8 == 0 for offset, length in self.channels):
+            raise ValueError(f"unsupported framebuffer layout: {self.bpp} bpp, {self.channels}")
+        self.size = self.stride * self.height
+        if geometry and os.fstat(self.fd).st_size < self.size:
+            os.ftruncate(self.fd, self.size)
+        self.map = mmap.mmap(self.fd, self.size)
+
+    def convert(self, rgb):
+        """Packed 8-bit RGB rows of the screen's size -> bytes in this framebuffer's layout"""
+        red, green, blue = rgb[0::3], rgb[1::3], rgb[2::3]
+        pixels = len(red)
+        step = self.bpp // 8
+        out = bytearray(pixels * step)
+        if all(length == 8 and offset % 8 == 0 for offset, length in self.channels):
+            for (offset, _), channel in zip(self.channels, (red, green, blue)):
+                out[offset // 8::step] = channel
+            # The spare byte of a 32 bpp pixel is alpha on some drivers: opaque
+            for spare in set(range(step)) - {offset // 8 for offset, _ in self.channels}:
+                out[spare::step] = b"\xff" * pixels
+        else:
+            # 16 bpp: each channel's share of the low and high byte through a lookup table,
+            # then the three shares OR-ed together as big integers
+            low, high = 0, 0
+            for (offset, length), channel in zip(self.channels, (red, green, blue)):
+                values = [(value >> (8 - length)) << offset for value in range(256)]
+                low |= int.from_bytes(channel.translate(bytes(v & 0xFF for v in values)), "big")
+                high |= int.from_bytes(channel.translate(bytes(v >> 8 for v in values)), "big")
+            out[0::2] = low.to_bytes(pixels, "big")
+            out[1::2] = high.to_bytes(pixels, "big")
+        row = self.width * step
+        if row == self.stride:
+            return bytes(out)
+        padding = bytes(self.stride - row)
+        return b"".join(bytes(out[y * row:(y + 1) * row]) + padding for y in range(self.height))
+
+    def show(self, image):
+        self.map[0:len(image)] = image
+
+    def close(self):
+        self.map.close()
+        os.close(self.fd)
+
+
+def parse_ppm(data):
+    """(width, height, rgb) of a binary 8-bit PPM, or None"""
+    fields = []
+    position = 0
+    while len(fields) < 4:
+        while position < len(data) and data[position:position + 1].isspace():
+            position += 1
+        if data[position:position + 1] == b"#":
+            position = data.index(b"\n", position)
+            continue
+        end = position
+        while end < len(data) and not data[end:end + 1].isspace():
+            end += 1
+        if end == position:
+            return None
+        fields.append(data[position:end])
+        position = end
+    if fields[0] != b"P6" or fields[3] != b"255":
+        return None
+    width, height = int(fields[1]), int(fields[2])
+    rgb = data[position + 1:position + 1 + width * height * 3]
+    return (width, height, rgb) if len(rgb) == width * height * 3 else None
+
+
+def load_image(path, width, height):
+    """Packed 8-bit RGB of an image file scaled to width x height"""
+    with open(path, "rb") as image:
+        ppm = parse_ppm(image.read())
+    if not ppm or ppm[:2] != (width, height):
+        result = subprocess.run(["convert", path, "-resize", f"{width}x{height}!", "-depth", "8", "ppm:-"],
+                                capture_output=True, check=True)
+        ppm = parse_ppm(result.stdout)
+        if not ppm:
+            raise ValueError(f"convert gave no usable image for {path}")
+    return ppm[2]
+
+
+class StatusDisplay:
+    """Preloaded status images, swapped into the framebuffer on request"""
+    def __init__(self, framebuffer, image_dir=IMAGE_DIR, images=None):
+        self.framebuffer = framebuffer
+        self.images = {}
+        self.current = None
+        start = time.monotonic()
+        for status, name in (images or STATUS_IMAGES).items():
+            path = os.path.join(image_dir, name)
+            if not os.path.exists(path):
+                logger.warning(f"⚠️ No image for '{status}': {path}")
+                continue
+            try:
+                self.images[status] = framebuffer.convert(load_image(path, framebuffer.width, framebuffer.height))
+            except (OSError, ValueError, subprocess.CalledProcessError) as e:
+                logger.warning(f"⚠️ Could not load {path}: {e}")
+        logger.info(f"🖼️ {len(self.images)} status images ready for {framebuffer.width}x{framebuffer.height}"
+                    f"x{framebuffer.bpp} in {time.monotonic() - start:.1f}s")
+
+    def show(self, status):
+        image = self.images.get(status)
+        if image is None:
+            return False
+        self.framebuffer.show(image)
+        self.current = status
+        return True
+
+    def serve(self, path=SOCKET_PATH):
+        """Answer status requests on a datagram socket until the process ends"""
+        if os.path.exists(path):
+            os.unlink(path)
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+        sock.bind(path)
+        os.chmod(path, 0o666)
+        logger.info(f"📺 Status display listening on {path}")
+        try:
+            while True:
+                data, sender = sock.recvfrom(64)
+                status = data.decode("ascii", "replace").strip()
+                ok = self.show(status)
+                if not ok:
+                    logger.warning(f"⚠️ Unknown status: {status}")
+                if sender:
+                    try:
+                        sock.sendto(b"ok" if ok else b"unknown", sender)
+                    except OSError:
+                        pass
+        finally:
+            sock.close()
+            os.unlink(path)
+
+
+def console_mode(mode):
+    """Keep the text console (login prompt, cursor) from drawing over the image, or give it back"""
+    try:
+        fd = os.open(CONSOLE, os.O_RDWR)
+    except OSError:
+        return
+    try:
+        fcntl.ioctl(fd, KDSETMODE, mode)
+    except OSError:
+        pass
+    finally:
+        os.close(fd)
+
+
+def main():
+    logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(name)s - %(levelname)s - %(message)s')
+    signal.signal(signal.SIGTERM, lambda sig, frame: sys.exit(0))
+    geometry = os.environ.get("CEC_FB_GEOMETRY")
+    framebuffer = Framebuffer(FB_DEVICE, geometry)
+    display = StatusDisplay(framebuffer)
+    if not geometry:
+        console_mode(KD_GRAPHICS)
+    try:
+        display.show("idle") or display.show("ready")
+        display.serve()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if not geometry:
+            console_mode(KD_TEXT)
+        framebuffer.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+Multi-adapter fan-out check
+Runs the daemon's command handling with three fake adapters (lobby, bar
+and stage, each a fake bus of its own) and a group front=lobby+bar. Every
+fake frame takes FRAME_DELAY seconds, so a command on all three buses one
+after another would take three times as long as on one. Checks that
+requests without a target stay on the first adapter as before, that a
+group, a single adapter and "all" reach exactly those buses, that a
+broadcast runs in parallel, that results come back per display, and that
+one failing display does not hide the others. Last, an adapter whose
+backend does not open, second or first, fails only the commands sent to
+it, and a daemon whose first adapter does not open keeps running and
+follows the bus once a command opens it.
+"""
+import os
+import sys
+import threading
+import time
+
+from checks import check, finish, use_fake_backend
+
+FRAME_DELAY = 0.2
+use_fake_backend(FRAME_DELAY)
+os.environ["CEC_ADAPTERS"] = "lobby=fake:Lobby TV,bar=fake:Bar TV,stage=fake:Stage TV"
+os.environ["CEC_ADAPTER_GROUPS"] = "front=lobby+bar"
+os.environ.setdefault("CEC_HTTP_PORT", "0")
+
+import cec_backend  # noqa: E402
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+import bus_state  # noqa: E402
+from adapters import get_adapters, stop_adapters  # noqa: E402
+from scheduler import stop_scheduler  # noqa: E402
+
+
+def tv_power(adapters):
+    """{adapter: TV power code} straight from each fake bus"""
+    return {adapter.name: adapter.backend.devices.get(0, {}).get("power") for adapter in adapters.adapters}
+
+
+def timed(controller, command):
+    start = time.monotonic()
+    response = controller.handle_command(command)
+    return response, time.monotonic() - start
+
+
+def reconfigure(spec):
+    """Open the adapters again from spec, the first one included"""
+    stop_adapters()
+    stop_scheduler()
+    cec_backend.stop_backend()
+    cec_backend.CEC_ADAPTERS = spec
+    return get_adapters()
+
+
+def check_failed_open(controller, failures):
+    adapters = reconfigure("lobby=fake:Lobby TV,bar=bogus:")
+    check(f"second adapter did not open: {adapters.to_dict()['bar']}",
+          adapters.by_name["bar"].scheduler is None and adapters.primary.scheduler is not None, failures)
+    response = controller.handle_command({"command": "POWER_ON", "adapter": "all"})
+    lines = response["result"].splitlines()
+    check(f"all -> the open display still works: {lines[1]!r}",
+          lines[:2] == ["❌ on 0: 1/2 displays", "✅ lobby: on 0"]
+          and lines[2].startswith("❌ bar: ❌ Adapter did not open"), failures)
+
+    adapters = reconfigure("lobby=bogus:,bar=fake:Bar TV")
+    response = controller.handle_command({"command": "POWER_ON", "adapter": "bar"})
+    check(f"first adapter did not open, the second still works: {response['result']!r}",
+          adapters.primary.scheduler is None and response["status"] == "success", failures)
+    response = controller.handle_command({"command": "POWER_ON"})
+    check(f"commands for the first adapter fail alone: {response['result'].splitlines()[-1]!r}",
+          response["status"] == "error" and "did not open" in response["result"], failures)
+    stats = controller.handle_command({"command": "STATS"})
+    check("STATS answers without the first adapter",
+          stats["status"] == "success" and stats["adapters"]["lobby"]["error"].startswith("❌"), failures)
+
+
+def check_failed_start(failures):
+    """run() and stop() with a first adapter that does not open, e.g. a missing /dev/cec0"""
+    reconfigure("lobby=kernel:/dev/nonexistent,bar=fake:Bar TV")
+    bus_state.stop_bus_state()
+    controller = CECController(uart_port="/dev/null")
+    thread = threading.Thread(target=controller.run)
+    thread.daemon = True
+    thread.start()
+    deadline = time.monotonic() + 5
+    while "adapter_ms" not in controller.startup and thread.is_alive() and time.monotonic() < deadline:
+        time.sleep(0.05)
+    check("run() survives a first adapter that does not open",
+          thread.is_alive() and "adapter_ms" in controller.startup, failures)
+
+    # The device shows up: the next command opens it and the bus state listens from then on
+    cec_backend.CEC_ADAPTERS = "lobby=fake:Lobby TV,bar=fake:Bar TV"
+    response = controller.handle_command({"command": "POWER_ON"})
+    state = bus_state._state
+    check(f"late first adapter opened and followed: {response['result']!r}",
+          response["status"] == "success" and state is not None
+          and state.on_line in cec_backend.get_backend().listeners, failures)
+
+    controller.stop()
+    thread.join(timeout=3)
+    check("stop() ends run()", not thread.is_alive(), failures)
+
+
+def main():
+    controller = CECController(uart_port="/dev/null")
+    adapters = get_adapters()
+    failures = []
+    try:
+        check(f"three adapters on fake buses: {[a.name for a in adapters.adapters]}",
+              [a.name for a in adapters.adapters] == ["lobby", "bar", "stage"]
+              and all(a.scheduler and a.scheduler.name == "fake" for a in adapters.adapters), failures)
+        for adapter in adapters.adapters:
+            adapter.backend.devices[0]["power"] = 1
+
+        # No target: the first adapter, answered the way it always was
+        response, single = timed(controller, {"command": "POWER_ON"})
+        check(f"no target -> first adapter only in {single * 1000:.0f} ms: {response['result']!r}",
+              response == {"status": "success", "result": "✅ Command executed: on 0"}
+              and tv_power(adapters) == {"lobby": 0, "bar": 1, "stage": 1}, failures)
+
+        response, elapsed = timed(controller, {"command": "POWER_ON", "adapter": "all"})
+        check(f"all -> every TV on in {elapsed * 1000:.0f} ms, one bus took {single * 1000:.0f} ms",
+              response["status"] == "success" and set(tv_power(adapters).values()) == {0}
+              and elapsed < single * 1.5, failures)
+        check("result per display",
+              set(response["displays"]) == {"lobby", "bar", "stage"}
+              and response["result"].splitlines() == ["✅ on 0: 3/3 displays", "✅ lobby: on 0", "✅ bar: on 0",
+                                                      "✅ stage: on 0"], failures)
+
+        response = controller.handle_command({"command": "POWER_OFF", "adapter": "front"})
+        check(f"group front -> lobby and bar only: {tv_power(adapters)}",
+              response["status"] == "success" and list(response["displays"]) == ["lobby", "bar"]
+              and tv_power(adapters) == {"lobby": 1, "bar": 1, "stage": 0}, failures)
+
+        response = controller.handle_command({"command": "CUSTOM", "cec_command": "standby 0", "adapter": "stage"})
+        check("single adapter by name",
+              list(response["displays"]) == ["stage"] and tv_power(adapters)["stage"] == 1, failures)
+
+        response = controller.handle_command({"command": "POWER_ON", "adapter": ["stage", "front"]})
+        check("list of names, in adapter order", list(response["displays"]) == ["lobby", "bar", "stage"], failures)
+
+        response = controller.handle_command({"command": "STATUS", "adapter": "all"})
+        check("STATUS asks every TV",
+              response["status"] == "success"
+              and all("power status: on" in d["result"] for d in response["displays"].values()), failures)
+
+        # A display whose TV does not answer fails alone
+        adapters.by_name["bar"].backend.devices.pop(0)
+        response = controller.handle_command({"command": "POWER_OFF", "adapter": "all"})
+        lines = response["result"].splitlines()
+        check(f"one display failing: {lines[0]!r}, {lines[2]!r}",
+              response["status"] == "error" and lines[0] == "❌ standby 0: 2/3 displays"
+              and lines[2].startswith("❌ bar:") and response["displays"]["lobby"]["status"] == "success"
+              and tv_power(adapters) == {"lobby": 1, "bar": None, "stage": 1}, failures)
+
+        response = controller.handle_command({"command": "POWER_ON", "adapter": "kitchen"})
+        check(f"unknown target refused: {response['result']!r}",
+              response["status"] == "error" and "kitchen" in response["result"], failures)
+
+        response = controller.handle_command({"command": "DISCOVER", "adapter": "all"})
+        check("DISCOVER stays on the first adapter", response["status"] == "error", failures)
+
+        # A Flipper's binary request with all displays as the default target
+        adapters.default = "all"
+        reply = controller.handle_message(("frame", proto.OP_POWER_ON, 9, b"\x00"))
+        messages = proto.FrameDecoder().feed(reply)
+        text = messages[0][3][1:].decode()
+        check(f"binary request fans out to the default target: {text.splitlines()[0]!r}",
+              messages[0][2] == 9 and text.startswith("❌ on 0: 2/3 displays") and "stage" in text, failures)
+
+        stats = controller.handle_command({"command": "STATS"})
+        check("STATS lists every adapter's queue",
+              set(stats["adapters"]) == {"lobby", "bar", "stage"}
+              and stats["adapters"]["stage"]["scheduler"]["classes"]["control"]["jobs"] >= 4, failures)
+
+        check_failed_open(controller, failures)
+        check_failed_start(failures)
+    finally:
+        controller.stop()
+
+    return finish(failures, "adapter")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Adaptive power-on timing check
+Runs an NEC-like power-on recipe (Image View On, Active Source, 2 s after
+each, 2 s settle, two attempts) against the fake CEC backend, whose TV
+takes WAKE seconds to report "on" after it is woken, like a projector
+warming up. Compares the fixed-delay run with the adaptive one, then checks
+that the learned timing is saved, read back by a fresh store and used with
+fewer status checks; that a device that is on already teaches nothing; that
+a device slower than the learned timing still comes on through the recipe's
+own delays; and that another device at the same address does not share the
+timing.
+"""
+import os
+import sys
+import tempfile
+import time
+
+from checks import check, finish, use_fake_backend
+
+use_fake_backend()
+TIMING_FILE = os.path.join(tempfile.mkdtemp(prefix="cec_timing_"), "power_timing.json")
+os.environ["CEC_TIMING_FILE"] = TIMING_FILE
+
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+from bus_state import get_bus_state  # noqa: E402
+from cec_backend import get_backend, OP_GIVE_POWER_STATUS  # noqa: E402
+from power_timing import TimingStore, run_adaptive  # noqa: E402
+from scheduler import get_scheduler  # noqa: E402
+from sequence import parse_sequence  # noqa: E402
+
+WAKE = 1.2
+RECIPE = {
+    "command": "SEQUENCE",
+    "steps": [{"cec": "tx 10:04", "delay": 2.0}, {"cec": "tx 1F:82:10:00", "delay": 2.0}],
+    "attempts": 2,
+    "settle": 2.0,
+    "until": {"cec": "pow 0", "match": r"power status:\s*on\b"},
+}
+
+
+def standby(wake):
+    """Put the fake TV in standby through the bus, so the bus state sees it, with a new wake time"""
+    get_scheduler().execute("standby 0")
+    get_backend().devices[0]["wake"] = wake
+
+
+def power_checks():
+    return sum(1 for frame in get_backend().sent if frame[1:2] == bytes([OP_GIVE_POWER_STATUS]))
+
+
+def run(store, wake):
+    """(success, summary, seconds, power status checks) of one adaptive power-on"""
+    standby(wake)
+    checks = power_checks()
+    start = time.monotonic()
+    success, summary = run_adaptive(get_scheduler(), parse_sequence(dict(RECIPE, adaptive=True)), store)
+    return success, summary, time.monotonic() - start, power_checks() - checks
+
+
+def only_entry(store):
+    return next(iter(store.devices.values())) if len(store.devices) == 1 else {}
+
+
+def main():
+    controller = CECController(uart_port="/dev/null")
+    failures = []
+    try:
+        standby(WAKE)
+        start = time.monotonic()
+        response = controller.handle_command(dict(RECIPE))
+        blind = time.monotonic() - start
+        check(f"fixed delays: TV on after {blind:.1f} s ({response['result']})",
+              response["status"] == "success" and blind > 5.5, failures)
+
+        standby(WAKE)
+        checks = power_checks()
+        start = time.monotonic()
+        response = controller.handle_command(dict(RECIPE, adaptive=True))
+        first = time.monotonic() - start
+        first_checks = power_checks() - checks
+        store = TimingStore(TIMING_FILE)
+        entry = only_entry(store)
+        check(f"adaptive: TV on after {first:.1f} s with {first_checks} status checks, "
+              f"learned {entry.get('seconds')} s after step 1",
+              response["status"] == "success" and first < 2.0 and entry.get("index") == 0
+              and WAKE <= entry.get("seconds", 0) < WAKE + 0.5, failures)
+        check(f"timing saved per device: {list(store.devices)}",
+              list(store.devices)[0].startswith("Samsung|TV|"), failures)
+
+        success, summary, learned, checks = run(store, WAKE)
+        check(f"learned timing from a fresh store: on after {learned:.1f} s with {checks} status checks",
+              success and learned < first + 0.2 and checks < first_checks and "learned timing" in summary,
+              failures)
+
+        before = dict(only_entry(store))
+        success, summary = run_adaptive(get_scheduler(), parse_sequence(dict(RECIPE, adaptive=True)), store)
+        check("a TV that is on already teaches nothing",
+              success and only_entry(store)["seconds"] == before["seconds"], failures)
+
+        success, summary, slow, checks = run(store, 3.0)
+        entry = only_entry(store)
+        check(f"slower wake-up: on after {slow:.1f} s through the recipe's delays, "
+              f"learned {entry.get('seconds')} s after step {entry.get('index', 0) + 1}",
+              success and entry.get("index") == 1 and entry.get("fallbacks") == 0, failures)
+
+        # The learned run is a single attempt, the recipe then runs as written
+        success, summary, fallback, checks = run(store, 6.5)
+        check(f"too slow for the learned timing: fell back, on after {fallback:.1f} s",
+              success and "learned timing failed" in summary and only_entry(store).get("fallbacks") == 1,
+              failures)
+
+        # Another device at address 0, e.g. a swapped projector
+        get_bus_state().note_present(0, False)
+        get_backend().devices[0]["name"] = "Projector"
+        success, summary, other, checks = run(store, WAKE)
+        check(f"another device learns its own timing: {sorted(entry['name'] for entry in store.devices.values())}",
+              success and len(store.devices) == 2 and "learned timing" not in summary, failures)
+
+        payload = bytes([2, 20, proto.UNTIL_POWER_ON | proto.UNTIL_ADAPTIVE, 0, 20, 0, 2, 0x10, 0x04])
+        command = proto.sequence_from_payload(payload)
+        check("binary SEQUENCE carries the adaptive flag",
+              command.get("adaptive") is True and command["until"]["cec"] == "pow 0", failures)
+
+        payload = bytes([1, 20, proto.UNTIL_POWER_ON, 0xB, 0, 0, 2, 0xB0, 0x04])
+        command = proto.sequence_from_payload(payload)
+        check(f"binary SEQUENCE polls address 0xB in hex: {command['until']['cec']}",
+              command["until"]["cec"] == "pow b", failures)
+    finally:
+        controller.stop()
+
+    return finish(failures, "adaptive timing")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+UART rate negotiation over a pty pair
+Runs the daemon's UART loop on one end of a pty and plays the Flipper on
+the other, going through the rate switch the way the app does: propose,
+switch, verify, fall back. A pty carries bytes at any rate, so a rate
+mismatch is simulated by corrupting what the "Flipper" sends; the script
+checks the rate the daemon set on its port after every step.
+"""
+import os
+import pty
+import select
+import sys
+import time
+import tty
+
+from checks import check, finish, use_fake_cec_client
+
+use_fake_cec_client()
+
+import baud_rate  # noqa: E402
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+
+# Order the app tries rates in when it has none remembered
+APP_RATES = (921600, 460800)
+
+# What a 115200 baud frame looks like to a port at 921600: framing errors read as NULs
+LINE_NOISE = bytes([0x00, 0xF8, 0x00, 0x80, 0x00, 0xFE, 0x00, 0x00])
+
+
+class FakeFlipper:
+    def __init__(self, fd):
+        self.fd = fd
+        self.decoder = proto.FrameDecoder()
+        self.seq = 0
+        self.corrupt_next = False
+        self.corrupt_rates = set()  # Rates whose verify frame gets corrupted
+
+    def request(self, opcode, payload=b'', timeout=0.5):
+        """One frame out, its final reply back as (status, payload), None on timeout"""
+        self.seq = self.seq % 255 + 1
+        frame = bytearray(proto.encode_frame(opcode, self.seq, payload))
+        if self.corrupt_next:
+            frame[-3] ^= 0x10      # Arrives with a bad CRC, as at the wrong rate
+            self.corrupt_next = False
+        os.write(self.fd, bytes(frame))
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            ready, _, _ = select.select([self.fd], [], [], 0.05)
+            if not ready:
+                continue
+            for message in self.decoder.feed(os.read(self.fd, 4096)):
+                if message[0] == "frame" and message[2] == self.seq and message[1] == proto.OP_RESULT:
+                    return message[3][0], message[3][1:]
+        return None
+
+    def baud(self, action, rate, pattern=b''):
+        return self.request(proto.OP_BAUD, bytes([action]) + rate.to_bytes(4, "little") + pattern)
+
+    def ping(self):
+        reply = self.request(proto.OP_PING)
+        return reply is not None and reply[0] == proto.STATUS_OK
+
+    def try_rate(self, rate):
+        """The app's switch: propose, then verify at the new rate.
+        Returns (switched, link still up at the old rate when not)"""
+        reply = self.baud(proto.BAUD_PROPOSE, rate)
+        if reply is None or reply[0] != proto.STATUS_OK:
+            return False, reply is not None
+        switched = time.monotonic()
+        self.corrupt_next = rate in self.corrupt_rates
+        reply = self.baud(proto.BAUD_VERIFY, rate, proto.BAUD_PATTERN)
+        if reply == (proto.STATUS_OK, proto.BAUD_PATTERN):
+            return True, True
+        # Wait out the Pi's verify window, then make sure the link works at the old rate
+        time.sleep(max(0.0, switched + baud_rate.VERIFY_TIMEOUT + 0.2 - time.monotonic()))
+        return False, self.ping()
+
+    def negotiate(self, remembered=None):
+        """Remembered rate first, then the fastest; the rate the link ended up at"""
+        rates = ([remembered] if remembered else []) + [r for r in APP_RATES if r != remembered]
+        for rate in rates:
+            switched, alive = self.try_rate(rate)
+            if switched:
+                return rate
+            if not alive:
+                break
+        return baud_rate.DEFAULT_RATE
+
+
+def main():
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    controller = CECController(uart_port=os.ttyname(slave))
+    controller.running = True
+    controller.start_uart_interface()
+    flipper = FakeFlipper(master)
+    failures = []
+
+    def port_rate(expected=None):
+        # The daemon switches right after its reply is on the wire; give it a moment
+        deadline = time.monotonic() + 0.2
+        while expected is not None and controller.uart_serial.baudrate != expected and time.monotonic() < deadline:
+            time.sleep(0.005)
+        return controller.uart_serial.baudrate
+
+    try:
+        check("PING at 115200", flipper.ping(), failures)
+
+        reply = flipper.baud(proto.BAUD_PROPOSE, 12345)
+        check("unsupported rate refused", reply and reply[0] == proto.STATUS_ERROR and port_rate() == 115200,
+              failures)
+
+        reply = flipper.baud(proto.BAUD_PROPOSE, 921600)
+        check("propose 921600 answered, port switched",
+              reply and reply[0] == proto.STATUS_OK and port_rate(921600) == 921600, failures)
+        reply = flipper.baud(proto.BAUD_VERIFY, 921600, proto.BAUD_PATTERN)
+        check("verify echoes the pattern", reply == (proto.STATUS_OK, proto.BAUD_PATTERN), failures)
+        check("921600 committed", controller.baud.good == 921600 and flipper.ping(), failures)
+
+        os.write(master, LINE_NOISE)
+        time.sleep(0.1)
+        check("line noise falls back to 115200", port_rate(115200) == 115200, failures)
+        check("PING after fallback", flipper.ping(), failures)
+
+        flipper.baud(proto.BAUD_PROPOSE, 460800)
+        check("propose 460800 switched", port_rate(460800) == 460800, failures)
+        time.sleep(baud_rate.VERIFY_TIMEOUT + 0.2)
+        check("no verify: back to 115200", port_rate() == 115200 and flipper.ping(), failures)
+
+        flipper.baud(proto.BAUD_PROPOSE, 921600)
+        reply = flipper.baud(proto.BAUD_VERIFY, 921600, b"\x00" * len(proto.BAUD_PATTERN))
+        check("wrong pattern refused", reply and reply[0] == proto.STATUS_ERROR, failures)
+        time.sleep(baud_rate.VERIFY_TIMEOUT + 0.2)
+        check("wrong pattern: back to 115200", port_rate() == 115200, failures)
+
+        # The app's loop: 921600's verify is lost on the way, 460800 takes over
+        start = time.monotonic()
+        flipper.corrupt_rates = {921600}
+        rate = flipper.negotiate()
+        check("negotiation fell back to 460800 in %.1f s" % (time.monotonic() - start),
+              rate == 460800 and port_rate(460800) == 460800 and flipper.ping(), failures)
+
+        # Next connect: the app starts at 115200 again and tries the remembered rate first
+        os.write(master, LINE_NOISE)
+        time.sleep(0.1)
+        flipper.corrupt_rates = set()
+        start = time.monotonic()
+        rate = flipper.negotiate(remembered=460800)
+        check("reconnect at the remembered rate in %.2f s" % (time.monotonic() - start),
+              rate == 460800 and port_rate(460800) == 460800, failures)
+    finally:
+        controller.stop()
+        os.close(master)
+
+    return finish(failures, "baud")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
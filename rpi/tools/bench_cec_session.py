@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Latency comparison: fork-per-command cec-client vs the persistent session
+Runs the same command mix through both paths against the stand-in
+cec-client and prints mean / p95 / max per path.
+"""
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(TOOLS_DIR))
+
+FAKE_CLIENT = os.path.join(TOOLS_DIR, "fake_cec_client.py")
+os.environ.setdefault("CEC_CLIENT_BIN", FAKE_CLIENT)
+
+from cec_session import CECSession  # noqa: E402
+
+COMMANDS = ["on 0", "tx 4F:82:10:00", "volup", "pow 0", "standby 0"]
+
+
+def fork_per_command(command):
+    """The pre-session path: one cec-client -s per command"""
+    process = subprocess.Popen(
+        [os.environ["CEC_CLIENT_BIN"], '-s', '-d', '1'],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        universal_newlines=True
+    )
+    process.communicate(input=command + '\n', timeout=30)
+    return process.returncode == 0
+
+
+def measure(run, count):
+    samples = []
+    for i in range(count):
+        command = COMMANDS[i % len(COMMANDS)]
+        start = time.monotonic()
+        run(command)
+        samples.append((time.monotonic() - start) * 1000)
+    return samples
+
+
+def report(label, samples):
+    ordered = sorted(samples)
+    p95 = ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))]
+    print(f"{label:<22} n={len(samples):<4} mean={statistics.mean(samples):8.1f} ms"
+          f"  p95={p95:8.1f} ms  max={ordered[-1]:8.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("-n", "--count", type=int, default=20, help="commands per path")
+    args = parser.parse_args()
+
+    print(f"cec-client: {os.environ['CEC_CLIENT_BIN']}")
+    print(f"adapter open delay: {os.environ.get('FAKE_CEC_OPEN_DELAY', '1.0')} s")
+
+    fork_samples = measure(fork_per_command, args.count)
+
+    session = CECSession()
+    start = time.monotonic()
+    session.start()
+    startup_ms = (time.monotonic() - start) * 1000
+    session_samples = measure(lambda command: session.execute(command), args.count)
+    session.stop()
+
+    report("fork per command", fork_samples)
+    report("persistent session", session_samples)
+    print(f"{'session startup':<22} {startup_ms:.1f} ms (paid once)")
+    print(f"speedup (mean): {statistics.mean(fork_samples) / statistics.mean(session_samples):.1f}x")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""
+Throughput and latency benchmark for the daemon, with a regression check
+Starts main.py as its own process on one end of a pty pair (standing in
+for /dev/ttyAMA0), with tools/fake_cec_client.py as cec-client, and plays
+the Flipper on the other end. Each scenario sends a seeded mix of
+PING/POWER/HDMI/VOLUME/SCAN requests, keeping up to its concurrency in
+flight, and reports commands per second and p50/p95/p99 latency from
+request written to final reply read.
+
+  bench_daemon.py                    run and print
+  bench_daemon.py --check            also fail on a regression past the baseline
+  bench_daemon.py --update-baseline  store this run as the new baseline
+
+The baseline lives next to this script in bench_baseline.json. Almost all
+of the time goes to the fake cec-client's fixed delays, so the numbers
+move when the daemon's own overhead or concurrency changes, not with the
+speed of the machine.
+"""
+import argparse
+import json
+import os
+import pty
+import random
+import select
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+import tty
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+RPI_DIR = os.path.dirname(TOOLS_DIR)
+sys.path.insert(0, RPI_DIR)
+
+import uart_protocol as proto  # noqa: E402
+
+BASELINE_FILE = os.path.join(TOOLS_DIR, "bench_baseline.json")
+
+# Request kinds: name -> function(rng) giving (opcode, payload, JSON command)
+KINDS = {
+    "PING": lambda rng: (proto.OP_PING, b'', {"command": "PING"}),
+    "POWER": lambda rng: rng.choice([
+        (proto.OP_POWER_ON, bytes([0]), {"command": "CUSTOM", "cec_command": "on 0"}),
+        (proto.OP_POWER_OFF, bytes([0]), {"command": "CUSTOM", "cec_command": "standby 0"}),
+    ]),
+    "HDMI": lambda rng: (lambda port: (
+        proto.OP_TX, bytes([0x4F, 0x82, port << 4, 0x00]),
+        {"command": "CUSTOM", "cec_command": f"tx 4F:82:{port}0:00"}))(rng.randint(1, 4)),
+    "VOLUME": lambda rng: rng.choice([
+        (proto.OP_VOLUME_UP, b'', {"command": "CUSTOM", "cec_command": "volup"}),
+        (proto.OP_VOLUME_DOWN, b'', {"command": "CUSTOM", "cec_command": "voldown"}),
+    ]),
+    # What Scan Devices sends to a protocol 3 Pi
+    "SCAN": lambda rng: (proto.OP_DISCOVER, b'', {"command": "SCAN"}),
+}
+
+# name -> (requests in flight, requests, weight per kind, think time between requests in s)
+SCENARIOS = {
+    # Someone working through the menus, one request at a time
+    "field": (1, 150, {"PING": 5, "POWER": 10, "HDMI": 30, "VOLUME": 50, "SCAN": 5}, 0.005),
+    # Volume held down: as many requests in flight as the Flipper allows
+    "burst": (4, 200, {"PING": 5, "HDMI": 10, "VOLUME": 85}, 0.0),
+    # Everything at once, including scans that hold the bus
+    "mixed": (4, 200, {"PING": 20, "POWER": 15, "HDMI": 25, "VOLUME": 30, "SCAN": 10}, 0.0),
+}
+
+# Daemon and fake cec-client settings the baseline was taken with
+SETTINGS = {
+    "FAKE_CEC_OPEN_DELAY": "0.2",
+    "FAKE_CEC_CMD_DELAY": "0.01",
+    "FAKE_CEC_JITTER": "0.002",
+    "FAKE_CEC_SEED": "1",
+}
+
+METRICS = ("cps", "p50", "p95", "p99")
+
+# Sent before measuring: PING until the daemon is up, then STATUS opens the cec-client session
+WARMUP = [
+    (proto.OP_PING, b'', {"command": "PING"}),
+    (proto.OP_STATUS, b'', {"command": "STATUS"}),
+]
+STATS_RESET = (proto.OP_STATS, bytes([proto.STATS_RESET]), {"command": "STATS", "reset": True})
+STATS = (proto.OP_STATS, b'', {"command": "STATS"})
+
+
+def percentile(ordered, p):
+    """Nearest-rank percentile of a sorted list"""
+    index = max(0, min(len(ordered) - 1, -(-len(ordered) * p // 100) - 1))
+    return ordered[index]
+
+
+class Link:
+    """The Flipper's end of the pty, speaking binary frames or JSON lines"""
+
+    def __init__(self, fd, use_json):
+        self.fd = fd
+        self.use_json = use_json
+        self.decoder = proto.FrameDecoder()
+        self.parts = {}          # seq -> text of partial replies so far
+
+    def send(self, seq, kind):
+        opcode, payload, command = kind
+        if self.use_json:
+            os.write(self.fd, (json.dumps(dict(command, id=seq)) + "\n").encode())
+        else:
+            os.write(self.fd, proto.encode_frame(opcode, seq, payload))
+
+    def replies(self, timeout):
+        """(seq, text) of the final replies that arrived within timeout"""
+        ready, _, _ = select.select([self.fd], [], [], timeout)
+        if not ready:
+            return []
+        finished = []
+        for message in self.decoder.feed(os.read(self.fd, 4096)):
+            if message[0] == "frame":
+                _, opcode, seq, payload = message
+                text = self.parts.pop(seq, "") + payload[1:].decode("utf-8", "replace")
+                partial = opcode == proto.OP_RESULT_PART
+            else:
+                response = json.loads(message[1])
+                seq = response.get("id")
+                text = self.parts.pop(seq, "") + response.get("result", "")
+                partial = response.get("partial")
+                text += "\n" if partial else ""
+            if partial:
+                self.parts[seq] = text
+            else:
+                finished.append((seq, text))
+        return finished
+
+    def call(self, kind, seq=250, timeout=10):
+        """One request outside the measurement; its reply text, None on timeout"""
+        self.send(seq, kind)
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            for reply_seq, text in self.replies(0.05):
+                if reply_seq == seq:
+                    return text
+        return None
+
+
+def start_daemon(log):
+    """main.py on a fresh pty pair; returns (process, master fd, slave fd)"""
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    env = dict(os.environ, **SETTINGS)
+    env.update({
+        "CEC_UART_PORT": os.ttyname(slave),
+        "CEC_BACKEND": "cec-client",
+        "CEC_CLIENT_BIN": os.path.join(TOOLS_DIR, "fake_cec_client.py"),
+        "CEC_JOURNAL_DIR": os.path.join(os.path.dirname(log.name), "journal"),
+    })
+    process = subprocess.Popen([sys.executable, "main.py"], cwd=RPI_DIR, env=env,
+                               stdout=log, stderr=subprocess.STDOUT)
+    # Kept open: reads on the master fail with EIO until the daemon opens its end
+    return process, master, slave
+
+
+def run_scenario(link, name, seed):
+    concurrency, count, weights, think = SCENARIOS[name]
+    rng = random.Random(f"{seed}:{name}")
+    kinds = list(weights)
+    inflight = {}            # seq -> (kind name, sent at)
+    samples = {kind: [] for kind in kinds}
+    sent = 0
+    next_seq = 1
+
+    start = time.monotonic()
+    deadline = start + 120
+    while sent < count or inflight:
+        while sent < count and len(inflight) < concurrency:
+            while next_seq in inflight:
+                next_seq = next_seq % 200 + 1
+            kind = rng.choices(kinds, [weights[k] for k in kinds])[0]
+            inflight[next_seq] = (kind, time.monotonic())
+            link.send(next_seq, KINDS[kind](rng))
+            next_seq = next_seq % 200 + 1
+            sent += 1
+        for seq, _ in link.replies(0.5):
+            if seq in inflight:
+                kind, sent_at = inflight.pop(seq)
+                samples[kind].append((time.monotonic() - sent_at) * 1000)
+                if think:
+                    time.sleep(think)
+        if time.monotonic() > deadline:
+            raise TimeoutError(f"{name}: {len(inflight)} requests never answered")
+    elapsed = time.monotonic() - start
+
+    ordered = sorted(ms for kind_samples in samples.values() for ms in kind_samples)
+    result = {"cps": round(count / elapsed, 1)}
+    for p in (50, 95, 99):
+        result[f"p{p}"] = round(percentile(ordered, p), 2)
+    result["max"] = round(ordered[-1], 2)
+    result["kinds"] = {kind: {"n": len(values), "p95": round(percentile(sorted(values), 95), 2)}
+                       for kind, values in samples.items() if values}
+    return result
+
+
+def report(name, result):
+    print(f"{name:<7} {result['cps']:6.1f} cmd/s  p50={result['p50']:6.1f}  p95={result['p95']:6.1f}"
+          f"  p99={result['p99']:6.1f}  max={result['max']:6.1f} ms")
+    print("        " + "  ".join(f"{kind} n={entry['n']} p95={entry['p95']:.1f}"
+                                  for kind, entry in result["kinds"].items()))
+
+
+def regressions(results, baseline, tolerance, slack_ms):
+    """Messages for every metric worse than the baseline allows"""
+    failures = []
+    for name, result in results.items():
+        base = baseline.get("scenarios", {}).get(name)
+        if base is None:
+            continue
+        if result["cps"] < base["cps"] * (1 - tolerance):
+            failures.append(f"{name}: {result['cps']} cmd/s, baseline {base['cps']}")
+        for metric in METRICS[1:]:
+            limit = base[metric] * (1 + tolerance) + slack_ms
+            if result[metric] > limit:
+                failures.append(f"{name}: {metric} {result[metric]} ms, baseline {base[metric]} (limit {limit:.1f})")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("scenarios", nargs="*", default=list(SCENARIOS), help="scenarios to run")
+    parser.add_argument("--json", action="store_true", help="send JSON lines like older Flipper builds")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the request mix")
+    parser.add_argument("--check", action="store_true", help="exit non-zero on a regression past the baseline")
+    parser.add_argument("--update-baseline", action="store_true", help="write this run to " + BASELINE_FILE)
+    parser.add_argument("--tolerance", type=float, default=0.3, help="allowed relative regression (default 0.3)")
+    parser.add_argument("--slack-ms", type=float, default=5.0, help="allowed absolute latency regression")
+    parser.add_argument("--stats", action="store_true", help="print the daemon's STATS breakdown per scenario")
+    parser.add_argument("-o", "--output", help="also write the results as JSON here")
+    args = parser.parse_args()
+
+    unknown = [name for name in args.scenarios if name not in SCENARIOS]
+    if unknown:
+        parser.error("unknown scenario " + ", ".join(unknown))
+
+    workdir = tempfile.mkdtemp(prefix="cec_bench_")
+    log = open(os.path.join(workdir, "daemon.log"), "w")
+    process, master, slave = start_daemon(log)
+    link = Link(master, args.json)
+    results = {}
+    try:
+        # Opening the port flushes it, so PING is repeated until the daemon is listening
+        deadline = time.monotonic() + 15
+        while link.call(WARMUP[0], timeout=0.5) is None:
+            if time.monotonic() > deadline:
+                print(f"FAILED: daemon did not answer, see {log.name}")
+                return 1
+        for kind in WARMUP[1:]:
+            link.call(kind)
+        for name in args.scenarios:
+            link.call(STATS_RESET)
+            results[name] = run_scenario(link, name, args.seed)
+            report(name, results[name])
+            if args.stats:
+                print(link.call(STATS))
+    finally:
+        process.send_signal(signal.SIGTERM)
+        try:
+            process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            process.kill()
+        os.close(master)
+        os.close(slave)
+        log.close()
+
+    run = {
+        "encoding": "json" if args.json else "binary",
+        "seed": args.seed,
+        "settings": SETTINGS,
+        "scenarios": results,
+    }
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(run, f, indent=2)
+    if args.update_baseline:
+        with open(BASELINE_FILE, "w") as f:
+            json.dump(run, f, indent=2)
+            f.write("\n")
+        print(f"baseline written to {BASELINE_FILE}")
+        return 0
+    if not args.check:
+        return 0
+
+    with open(BASELINE_FILE) as f:
+        baseline = json.load(f)
+    if any(baseline.get(key) != run[key] for key in ("encoding", "seed", "settings")):
+        print("FAILED: baseline was taken with different settings, rerun with --update-baseline")
+        return 1
+    failures = regressions(results, baseline, args.tolerance, args.slack_ms)
+    for failure in failures:
+        print("REGRESSION " + failure)
+    if failures:
+        return 1
+    print(f"no regressions against baseline (tolerance {args.tolerance:.0%} + {args.slack_ms:.0f} ms)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
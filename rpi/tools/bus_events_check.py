@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Bus event push check over a pty pair
+Runs the daemon's UART loop on one end of a pty with the fake CEC backend
+and plays the Flipper on the other: sends OP_WATCH, expects what the Pi
+already knows as OP_EVENT frames, then injects traffic from the devices
+on the fake bus and checks each change arrives as one event, unasked and
+with sequence 0. Also checks that a device missing from a discovery is
+reported gone, that events and replies do not get in each other's way, and
+that a JSON PING (a Flipper reconnecting) stops the events.
+"""
+import json
+import os
+import pty
+import select
+import sys
+import time
+import tty
+
+from checks import check, finish, use_fake_backend
+
+use_fake_backend()
+
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+from scheduler import get_scheduler  # noqa: E402
+
+
+class Flipper:
+    """The Flipper's end of the pty: frames out, decoded frames in"""
+    def __init__(self, fd):
+        self.fd = fd
+        self.decoder = proto.FrameDecoder()
+        self.arrived = None        # When the first bytes of the last receive() came in
+
+    def send(self, opcode, seq=0, payload=b''):
+        os.write(self.fd, proto.encode_frame(opcode, seq, payload))
+
+    def receive(self, wait=0.3):
+        """Every message arriving within wait seconds of the last one"""
+        messages = []
+        self.arrived = None
+        while True:
+            ready, _, _ = select.select([self.fd], [], [], wait)
+            if not ready:
+                return messages
+            self.arrived = self.arrived or time.monotonic()
+            messages.extend(self.decoder.feed(os.read(self.fd, 4096)))
+
+    def events(self, wait=0.3):
+        """(type, logical address, data) of the OP_EVENT frames received"""
+        return [(m[3][0], m[3][1], bytes(m[3][2:])) for m in self.receive(wait)
+                if m[0] == "frame" and m[1] == proto.OP_EVENT]
+
+
+def main():
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    controller = CECController(uart_port=os.ttyname(slave))
+    controller.running = True
+    controller.start_uart_interface()
+    backend = get_scheduler().backend
+    flipper = Flipper(master)
+    failures = []
+
+    try:
+        # The TV's power and name are known before anybody watches
+        controller.handle_command({"command": "STATUS", "refresh": True})
+        backend.receive([0x0F, 0x47] + list(b"Living TV"))
+
+        flipper.send(proto.OP_WATCH, 0, b"\x01")
+        messages = flipper.receive()
+        events = [(m[3][0], m[3][1], bytes(m[3][2:])) for m in messages if m[1] == proto.OP_EVENT]
+        check(f"snapshot on watch: {events}",
+              events == [(proto.EVENT_DEVICE, 0, b"Living TV"), (proto.EVENT_POWER, 0, b"\x00")], failures)
+        check("snapshot uses seq 0 and watch is not answered",
+              all(m[0] == "frame" and m[1] == proto.OP_EVENT and m[2] == 0 for m in messages), failures)
+
+        # Changes on the bus, one event each
+        start = time.monotonic()
+        backend.receive([0x0F, 0x36])
+        events = flipper.events()
+        check(f"TV standby -> {events} after {(flipper.arrived - start) * 1000:.1f} ms",
+              events == [(proto.EVENT_POWER, 0, b"\x01")], failures)
+
+        backend.receive([0x0F, 0x36])
+        check("repeated standby sends nothing", flipper.events(0.1) == [], failures)
+
+        backend.receive([0x4F, 0x82, 0x20, 0x00])
+        events = flipper.events()
+        check(f"player becomes active source -> {events}",
+              (proto.EVENT_DEVICE, 4, b"") in events and (proto.EVENT_POWER, 4, b"\x00") in events
+              and events[-1] == (proto.EVENT_SOURCE, 4, b"\x20\x00"), failures)
+
+        backend.receive([0x0F, 0x80, 0x20, 0x00, 0x30, 0x00])
+        events = flipper.events()
+        check(f"routing to an unknown input -> {events}",
+              events == [(proto.EVENT_SOURCE, proto.EVENT_NO_DEVICE, b"\x30\x00")], failures)
+
+        backend.receive([0x40, 0x47] + list(b"Player"))
+        check("rename is sent again", flipper.events() == [(proto.EVENT_DEVICE, 4, b"Player")], failures)
+
+        # Nothing answers at 4 on the fake bus, so discovery finds it gone
+        controller.handle_command({"command": "DISCOVER"})
+        events = flipper.events()
+        check(f"missing from discovery -> {events}",
+              (proto.EVENT_GONE, 4, b"") in events and all(e[1] != 0 or e[0] != proto.EVENT_GONE for e in events),
+              failures)
+
+        # A reply in between events keeps its own sequence number
+        flipper.send(proto.OP_PING, 7)
+        backend.receive([0x01, 0x90, 0x01])
+        messages = flipper.receive()
+        kinds = sorted((m[1], m[2]) for m in messages if m[0] == "frame")
+        check(f"reply and event side by side: {kinds}",
+              kinds == [(proto.OP_RESULT, 7), (proto.OP_EVENT, 0)], failures)
+
+        # A Flipper reconnecting starts with a JSON PING; events stop until it watches again
+        os.write(master, (json.dumps({"command": "PING", "proto": proto.PROTOCOL_VERSION}) + "\n").encode())
+        flipper.receive()
+        backend.receive([0x0F, 0x36])
+        check("JSON PING stops events", flipper.events(0.2) == [], failures)
+    finally:
+        controller.stop()
+        os.close(master)
+
+    return finish(failures, "bus event")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Bus state check
+Runs the daemon's command handling on the fake CEC backend, with a delay
+per frame like a real bus, and injects the traffic a TV and a soundbar
+send on their own. Checks that the table follows power reports, standby,
+active source and routing, names and vendors; that STATUS and pow/ven/name
+queries are answered from it without a frame on the bus, in well under a
+millisecond against tens of milliseconds for a refresh; that a refresh
+and our own power commands go to the bus; and that a hot plug clears it.
+"""
+import sys
+import time
+
+from checks import check, finish, use_fake_backend
+
+use_fake_backend(delay=0.02)
+
+from bus_state import get_bus_state  # noqa: E402
+from main import CECController  # noqa: E402
+from scheduler import get_scheduler  # noqa: E402
+
+ROUNDS = 50
+
+
+def timed(controller, command, rounds=1):
+    """Last response and the median time of rounds runs, in ms"""
+    times = []
+    for _ in range(rounds):
+        start = time.perf_counter()
+        response = controller.handle_command(dict(command))
+        times.append((time.perf_counter() - start) * 1000.0)
+    return response, sorted(times)[len(times) // 2]
+
+
+def main():
+    controller = CECController()
+    state = get_bus_state()
+    backend = get_scheduler().backend
+    failures = []
+
+    try:
+        # Cold: nothing known, so STATUS asks the TV once and remembers
+        response, cold_ms = timed(controller, {"command": "STATUS"})
+        check(f"cold STATUS asks the TV ({cold_ms:.1f} ms): {response['result'].splitlines()[0]}",
+              response["status"] == "success" and "on" in response["result"]
+              and backend.sent and backend.sent[-1] == bytes([0x40, 0x8F]), failures)
+
+        sent = len(backend.sent)
+        response, warm_ms = timed(controller, {"command": "STATUS"}, ROUNDS)
+        check(f"warm STATUS from memory in {warm_ms * 1000:.0f} us, no frames",
+              len(backend.sent) == sent and warm_ms < 1.0 and "on" in response["result"], failures)
+
+        response, refresh_ms = timed(controller, {"command": "STATUS", "refresh": True})
+        check(f"refresh goes to the bus ({refresh_ms:.1f} ms, {refresh_ms / warm_ms:.0f}x)",
+              len(backend.sent) == sent + 1 and refresh_ms > 10 * warm_ms, failures)
+
+        # Traffic the devices send on their own
+        backend.receive([0x50, 0x90, 0x00])                           # Soundbar reports on
+        backend.receive([0x0F, 0x36])                                 # TV: broadcast standby
+        response, _ = timed(controller, {"command": "STATUS"})
+        check("broadcast standby seen", "standby" in response["result"] and len(backend.sent) == sent + 1,
+              failures)
+        check("soundbar in standby too", state.get(5, "power")[0] == "standby", failures)
+
+        backend.receive([0x50, 0x90, 0x00])                           # Soundbar reports on
+        backend.receive([0x5F, 0x87, 0x00, 0xA0, 0xDE])               # and its vendor
+        backend.receive([0x50, 0x47] + list(b"Soundbar"))             # and its name, to the TV
+        backend.receive([0x4F, 0x82, 0x20, 0x00])                     # Playback 1 takes over on HDMI 2
+        response, _ = timed(controller, {"command": "STATUS"})
+        check(f"active source: {response['result'].splitlines()[-1]}",
+              "#4" in response["result"] and "2.0.0.0" in response["result"], failures)
+        check("soundbar power, vendor and name",
+              [state.get(5, field)[0] if state.get(5, field) else None for field in ("power", "vendor", "name")]
+              == ["on", "Yamaha", "Soundbar"], failures)
+
+        sent = len(backend.sent)
+        answers = {command: timed(controller, {"command": "CUSTOM", "cec_command": command})[0]["result"]
+                   for command in ("pow 5", "ven 5", "name 5")}
+        check(f"pow/ven/name from memory: {' | '.join(answers.values())}",
+              len(backend.sent) == sent and "power status: on" in answers["pow 5"]
+              and "vendor id: Yamaha" in answers["ven 5"] and "'Soundbar'" in answers["name 5"], failures)
+
+        backend.receive([0x0F, 0x80, 0x20, 0x00, 0x10, 0x00])         # TV routes to HDMI 1
+        check("routing change follows the path",
+              state.active_path == "1.0.0.0" and state.active_source is None, failures)
+
+        # Our own power command: the TV's power is unknown until it reports again
+        timed(controller, {"command": "CUSTOM", "cec_command": "on 0"})
+        sent = len(backend.sent)
+        response, _ = timed(controller, {"command": "STATUS"})
+        check("power command makes the next STATUS ask",
+              len(backend.sent) == sent + 1 and "TV: on" in response["result"], failures)
+
+        backend.notify_line("physical address changed to 2.0.0.0")
+        check("hot plug clears the table", not state.devices and state.active_path is None, failures)
+    finally:
+        controller.stop()
+
+    return finish(failures, "bus state")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+CEC backend check
+Runs the commands the daemon sends on each backend and checks what the rest
+of the daemon reads from them: success from ACK/NACK, power, vendor and name
+parsed the way discovery does, scan output through DeviceCache, a power-on
+sequence, and bus traffic reaching listeners. A cec-client that never
+confirms a transmit, and one that does not start, must fail the command.
+Ends with the cost of one transmit on each backend.
+
+  python3 tools/cec_backends.py              fake backend and cec-client (fake_cec_client.py)
+  python3 tools/cec_backends.py --kernel     also the real /dev/cecN (CEC_DEVICE); queries only,
+                                             plus "tx" to the TV if --tx is given
+"""
+import argparse
+import os
+import stat
+import sys
+import tempfile
+import time
+
+from checks import check, finish, use_fake_cec_client
+
+use_fake_cec_client(delay=0.005)
+
+import cec_backend  # noqa: E402
+from cec_session import CECSession, CECSessionError  # noqa: E402
+from device_cache import DeviceCache  # noqa: E402
+from discovery import NAME_PATTERN, POWER_PATTERN, VENDOR_PATTERN, Discovery  # noqa: E402
+from sequence import parse_sequence, run_sequence  # noqa: E402
+
+TRANSMIT_RUNS = 50
+
+
+def field(backend, command, pattern):
+    success, output = backend.execute(command, timeout=5)
+    match = pattern.search(output)
+    return success, match.group(1).strip() if match else None
+
+
+def check_backend(backend, failures, transmit=True):
+    """Checks that hold on every bus with a TV at 0 and nothing at 0xE"""
+    name = backend.name
+    lines = []
+    backend.add_listener(lines.append)
+
+    success, power = field(backend, "pow 0", POWER_PATTERN)
+    check(f"{name}: pow 0 -> {power}", success and power in cec_backend.POWER_NAMES.values(), failures)
+    success, vendor = field(backend, "ven 0", VENDOR_PATTERN)
+    check(f"{name}: ven 0 -> {vendor}", success and vendor and vendor != "Unknown", failures)
+    success, osd = field(backend, "name 0", NAME_PATTERN)
+    check(f"{name}: name 0 -> {osd!r}", success and osd is not None, failures)
+
+    success, output = backend.execute("poll e", timeout=5)
+    check(f"{name}: poll to an empty address fails", not success, failures)
+    if name != "cec-client":
+        # cec-client prints "power status: unknown" and nothing that reads as an error
+        success, output = backend.execute("pow e", timeout=5)
+        check(f"{name}: query to an empty address fails", not success, failures)
+    if transmit:
+        success, output = backend.execute("tx 4E:04", timeout=5)
+        check(f"{name}: tx to an empty address is not acked", not success and "not acked" in output, failures)
+        success, output = backend.execute("on 0", timeout=5)
+        check(f"{name}: on 0 acked", success, failures)
+
+    cache = DeviceCache()
+    success, output = backend.execute("scan", timeout=30)
+    devices = cache.update_from_scan(output) if success else []
+    check(f"{name}: scan lists the TV ({len(devices)} devices)",
+          any(int(device.get("number", "-1"), 16) == 0 for device in devices), failures)
+
+    found, _ = Discovery(backend).run(full=True)
+    check(f"{name}: discovery finds the TV", any(device["logical"] == 0 for device in found), failures)
+    check(f"{name}: listeners see traffic", any("<<" in line or ">>" in line for line in lines), failures)
+
+
+def check_fake(failures):
+    backend = cec_backend.FakeBackend(delay=0)
+    backend.start()
+    check_backend(backend, failures)
+
+    recipe = parse_sequence({"steps": ["tx 40:04"], "attempts": 2,
+                             "until": {"cec": "pow 0", "match": r"power status:\s*on\b"}})
+    backend.devices[0]["power"] = 1
+    success, summary = run_sequence(backend, recipe)
+    check("fake: power-on sequence turns the TV on", success and backend.devices[0]["power"] == 0, failures)
+
+    backend.execute("standby 0", timeout=5)
+    check("fake: standby acked and applied", backend.devices[0]["power"] == 1, failures)
+    success, _ = backend.execute("volup", timeout=5)
+    check("fake: volume goes to the audio system",
+          success and backend.sent[-2][0] & 0xF == cec_backend.AUDIO_SYSTEM, failures)
+
+    discovery = Discovery(backend)
+    discovery.run(full=True)
+    time.sleep(0.4)            # Past the window in which traffic counts as replies to the run
+    backend.receive(bytes([0x0F, cec_backend.OP_REPORT_POWER_STATUS, 0x01]))
+    check("fake: received traffic marks the device dirty", 0 in discovery.dirty, failures)
+    return backend
+
+
+def stand_in(script):
+    """Executable cec-client stand-in running script"""
+    fd, path = tempfile.mkstemp(prefix="cec_client_", suffix=".sh")
+    with os.fdopen(fd, "w") as f:
+        f.write("#!/bin/sh\n" + script)
+    os.chmod(path, os.stat(path).st_mode | stat.S_IXUSR)
+    return path
+
+
+class CountingSession(CECSession):
+    starts = 0
+
+    def start(self):
+        self.starts += 1
+        return super().start()
+
+
+def check_session_failures(failures):
+    # Opens, then swallows every command without a traffic line
+    session = CECSession(binary=stand_in("echo 'waiting for input'\ncat > /dev/null\n"))
+    try:
+        success, output = session.execute("tx 10:04", timeout=5)
+        check(f"cec-client: transmit without a traffic line fails: {output.strip()!r}",
+              not success and "unconfirmed" in output, failures)
+    finally:
+        session.stop()
+        os.remove(session.binary)
+
+    session = CountingSession(binary=stand_in("exit 1\n"))
+    start = time.monotonic()
+    try:
+        session.execute("on 0", timeout=5)
+        failed = False
+    except CECSessionError:
+        failed = True
+    finally:
+        os.remove(session.binary)
+    check(f"cec-client that does not start: fails after {session.starts} start in "
+          f"{time.monotonic() - start:.2f} s", failed and session.starts == 1, failures)
+
+
+def transmit_cost(backend):
+    start = time.perf_counter()
+    for _ in range(TRANSMIT_RUNS):
+        backend.execute("tx 40:8F", timeout=5)
+    return (time.perf_counter() - start) / TRANSMIT_RUNS * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--kernel", action="store_true", help="also check the kernel backend on CEC_DEVICE")
+    parser.add_argument("--tx", action="store_true", help="let the kernel check transmit (wakes the TV)")
+    args = parser.parse_args()
+    failures = []
+
+    fake = check_fake(failures)
+
+    session = CECSession()
+    try:
+        check_backend(session, failures)
+        # Same simulated bus time per frame on both, the rest is backend overhead
+        fake.delay = float(os.environ["FAKE_CEC_CMD_DELAY"])
+        costs = {"fake": transmit_cost(fake), "cec-client": transmit_cost(session)}
+    finally:
+        session.stop()
+    check_session_failures(failures)
+
+    if args.kernel:
+        kernel = cec_backend.KernelBackend()
+        try:
+            kernel.start()
+        except (OSError, cec_backend.CECBackendError) as e:
+            check(f"kernel: open {kernel.device} ({e})", False, failures)
+        else:
+            try:
+                check_backend(kernel, failures, transmit=args.tx)
+                costs["kernel"] = transmit_cost(kernel)
+            finally:
+                kernel.stop()
+
+    print("transmit cost: " + "  ".join(f"{name} {ms:.2f} ms" for name, ms in costs.items()))
+    return finish(failures, "backend")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""
+Shared scaffold of the check tools in this directory
+Importing it puts rpi/ on the path, so the daemon's modules import as they
+do on the Pi. use_fake_backend() and use_fake_cec_client() pick the
+simulated bus; call one before importing anything that opens a backend.
+A tool prints one "ok"/"FAILED" line per check() and returns finish(), so
+it exits non-zero when any check failed.
+"""
+import os
+import sys
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+RPI_DIR = os.path.dirname(TOOLS_DIR)
+FAKE_CEC_CLIENT = os.path.join(TOOLS_DIR, "fake_cec_client.py")
+
+if RPI_DIR not in sys.path:
+    sys.path.insert(0, RPI_DIR)
+
+
+def use_fake_backend(delay=0.005):
+    """The in-memory FakeBackend, delay seconds per frame unless FAKE_CEC_CMD_DELAY says otherwise"""
+    os.environ["CEC_BACKEND"] = "fake"
+    os.environ.setdefault("FAKE_CEC_CMD_DELAY", str(delay))
+
+
+def use_fake_cec_client(delay=None):
+    """The cec-client backend, running fake_cec_client.py as cec-client"""
+    os.environ.setdefault("CEC_BACKEND", "cec-client")
+    os.environ.setdefault("CEC_CLIENT_BIN", FAKE_CEC_CLIENT)
+    os.environ.setdefault("FAKE_CEC_OPEN_DELAY", "0.2")
+    if delay is not None:
+        os.environ.setdefault("FAKE_CEC_CMD_DELAY", str(delay))
+
+
+def check(label, ok, failures):
+    print(("ok      " if ok else "FAILED  ") + label)
+    if not ok:
+        failures.append(label)
+
+
+def finish(failures, name):
+    """Exit code of a tool, after its summary line"""
+    if failures:
+        print(f"{len(failures)} checks failed")
+        return 1
+    print(f"all {name} checks passed")
+    return 0
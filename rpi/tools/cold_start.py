@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Cold start: power-on to first successful command
+Plays a Flipper that powers the Pi and wants to send POWER_ON. The "Pi"
+is main.py on a pty with tools/fake_cec_client.py as cec-client; it is
+started BOOT_DELAY seconds into the run to stand in for the boot, and the
+fake adapter takes OPEN_DELAY seconds to open. The user picks the command
+FIRST_COMMAND_AT seconds after power-on. Three runs:
+
+  old app      fixed 500 ms delay, then three PINGs 1 s apart; the Pi
+               opens the adapter on the first command (CEC_WARM_UP=0)
+  lazy Pi      PING with backoff, again at once when the Pi announces
+               EVENT_READY; commands wait for the link, adapter still lazy
+  warm Pi      the same, with the adapter opened at service start
+
+Reports when the link came up, when the Pi announced itself and when the
+command was answered, and checks the Pi's own STATS startup line.
+"""
+import json
+import os
+import pty
+import select
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+import tty
+
+from checks import FAKE_CEC_CLIENT, RPI_DIR, check, finish
+
+import uart_protocol as proto  # noqa: E402
+
+BOOT_DELAY = 4.0           # Power-on until the daemon starts
+OPEN_DELAY = 1.0           # Fake cec-client opening the adapter
+FIRST_COMMAND_AT = 6.0     # The user has found POWER_ON in the menus
+RUN_LIMIT = 20.0
+
+# The app's handshake (cec_remote.c): first PING at once, then 250 ms doubling up to 4 s
+BACKOFF_MIN = 0.25
+BACKOFF_MAX = 4.0
+
+PING = (json.dumps({"command": "PING", "proto": proto.PROTOCOL_VERSION}) + "\n").encode()
+
+
+class Pi:
+    """The daemon on a pty pair, started when boot() is called"""
+    def __init__(self, workdir, warm_up):
+        self.master, self.slave = pty.openpty()
+        tty.setraw(self.master)
+        tty.setraw(self.slave)
+        self.decoder = proto.FrameDecoder()
+        self.process = None
+        self.log = open(os.path.join(workdir, f"daemon_warm{int(warm_up)}.log"), "w")
+        self.env = dict(os.environ, CEC_UART_PORT=os.ttyname(self.slave), CEC_BACKEND="cec-client",
+                        CEC_CLIENT_BIN=FAKE_CEC_CLIENT,
+                        CEC_JOURNAL_DIR=os.path.join(workdir, "journal"),
+                        CEC_WARM_UP="1" if warm_up else "0",
+                        FAKE_CEC_OPEN_DELAY=str(OPEN_DELAY), FAKE_CEC_CMD_DELAY="0.02")
+
+    def boot(self):
+        self.process = subprocess.Popen([sys.executable, "main.py"], cwd=RPI_DIR, env=self.env,
+                                        stdout=self.log, stderr=subprocess.STDOUT)
+
+    def write(self, data):
+        os.write(self.master, data)
+
+    def messages(self, timeout):
+        ready, _, _ = select.select([self.master], [], [], timeout)
+        if not ready:
+            return []
+        return self.decoder.feed(os.read(self.master, 4096))
+
+    def stats(self):
+        """The daemon's startup record, from a JSON STATS"""
+        self.write((json.dumps({"command": "STATS", "id": 99}) + "\n").encode())
+        deadline = time.monotonic() + 5
+        while time.monotonic() < deadline:
+            for message in self.messages(0.1):
+                if message[0] == "json":
+                    reply = json.loads(message[1])
+                    if reply.get("id") == 99:
+                        return reply
+        return {}
+
+    def close(self):
+        if self.process:
+            self.process.send_signal(signal.SIGTERM)
+            try:
+                self.process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.process.kill()
+        os.close(self.master)
+        os.close(self.slave)
+        self.log.close()
+
+
+def run(pi, old_app):
+    """Times in seconds after power-on: link up, EVENT_READY, command answered; None if never"""
+    result = {"up": None, "ready": None, "done": None, "pings": 0, "success": False}
+    start = time.monotonic()
+    next_ping = 0.5 if old_app else 0.0
+    command_sent = False
+
+    while time.monotonic() - start < RUN_LIMIT:
+        now = time.monotonic() - start
+        if pi.process is None and now >= BOOT_DELAY:
+            pi.boot()
+        if result["up"] is None and now >= next_ping:
+            if old_app and result["pings"] == 3:
+                break                                       # "Connection Failed"
+            pi.write(PING)
+            next_ping = now + (1.0 if old_app else min(BACKOFF_MIN * 2 ** result["pings"], BACKOFF_MAX))
+            result["pings"] += 1
+        if result["up"] is not None and not command_sent and now >= FIRST_COMMAND_AT:
+            pi.write(proto.encode_frame(proto.OP_POWER_ON, 1, bytes([0])))
+            command_sent = True
+
+        for message in pi.messages(0.01):
+            now = time.monotonic() - start
+            if message[0] == "json" and result["up"] is None and json.loads(message[1]).get("status") == "success":
+                result["up"] = now
+            elif message[0] == "frame" and message[1] == proto.OP_EVENT and message[3][0] == proto.EVENT_READY:
+                result["ready"] = now
+                if result["up"] is None and not old_app:
+                    next_ping = now
+            elif message[0] == "frame" and message[1] == proto.OP_RESULT and message[2] == 1:
+                result["done"] = now
+                result["success"] = message[3][0] == proto.STATUS_OK
+        if result["done"] is not None:
+            break
+    return result
+
+
+def describe(name, result):
+    def at(key):
+        return "never" if result[key] is None else f"{result[key]:.2f} s"
+    return (f"{name:<8} link up {at('up')}, Pi ready {at('ready')}, POWER_ON answered {at('done')}"
+            f" ({result['pings']} PINGs)")
+
+
+def main():
+    failures = []
+    results = {}
+    with tempfile.TemporaryDirectory(prefix="cec_cold_") as workdir:
+        for name, old_app, warm_up in (("old app", True, False), ("lazy Pi", False, False),
+                                       ("warm Pi", False, True)):
+            pi = Pi(workdir, warm_up)
+            try:
+                results[name] = run(pi, old_app)
+                print(describe(name, results[name]))
+                if name == "warm Pi":
+                    stats = pi.stats()
+                    startup = stats.get("startup", {})
+                    check(f"STATS reports it: {stats.get('result', '').splitlines()[-1:]}",
+                          startup.get("adapter_ms", 0) >= OPEN_DELAY * 1000 * 0.8
+                          and "first_command_after_boot_s" in startup, failures)
+            finally:
+                pi.close()
+
+    old, lazy, warm = results["old app"], results["lazy Pi"], results["warm Pi"]
+    check(f"old handshake gives up before a {BOOT_DELAY:.0f} s boot is over", old["up"] is None, failures)
+    check("new handshake connects and the command succeeds",
+          lazy["success"] and warm["success"] and warm["up"] is not None, failures)
+    check(f"EVENT_READY cuts the backoff short (link up {warm['up'] - warm['ready']:+.2f} s from ready)"
+          if warm["up"] and warm["ready"] else "EVENT_READY received",
+          warm["ready"] is not None and warm["up"] is not None and warm["up"] - warm["ready"] < 0.5, failures)
+    if lazy["done"] and warm["done"]:
+        lazy_wait = lazy["done"] - FIRST_COMMAND_AT
+        warm_wait = warm["done"] - FIRST_COMMAND_AT
+        check(f"first command waits {warm_wait * 1000:.0f} ms on a warm Pi, {lazy_wait * 1000:.0f} ms on a lazy one",
+              warm_wait < OPEN_DELAY / 2 and lazy_wait >= OPEN_DELAY * 0.8, failures)
+
+    return finish(failures, "cold start")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+Device cache check
+Runs cec_control's vendor-aware commands against fake_cec_client.py and
+times switch_input('hdmi1') with a cold cache (a scan, then the tx) and a
+warm one (the tx alone). Then feeds bus traffic to the cache the way the
+backend does: the TV announcing its own vendor again must keep every
+entry, while another vendor and an unknown physical address must each
+clear the cache. Last, SCAN with "refresh" through the
+daemon's command handling must rescan and warm the cache again.
+"""
+import sys
+import time
+
+from checks import check, finish, use_fake_cec_client
+
+use_fake_cec_client()
+
+import cec_control  # noqa: E402
+from cec_control import DEVICE_CACHE  # noqa: E402
+from main import CECController  # noqa: E402
+
+
+def timed_switch():
+    start = time.monotonic()
+    result = cec_control.switch_input("hdmi1")
+    return result, (time.monotonic() - start) * 1000
+
+
+def traffic(frame):
+    """A received frame as cec-client reports it"""
+    return f"TRAFFIC: [  1234]\t<< {frame}"
+
+
+def main():
+    controller = CECController(uart_port="/dev/null")
+    failures = []
+    try:
+        result, cold = timed_switch()
+        check(f"cold cache: switch_input('hdmi1') in {cold:.0f} ms (scan + tx)",
+              result.startswith("Command executed") and DEVICE_CACHE.is_fresh(), failures)
+        scanned = sorted(DEVICE_CACHE.devices)
+        result, warm = timed_switch()
+        check(f"warm cache: switch_input('hdmi1') in {warm:.0f} ms (tx only)",
+              result.startswith("Command executed") and warm < cold / 3, failures)
+
+        DEVICE_CACHE.on_session_line(traffic("0f:87:00:00:f0"))
+        check("TV announcing its own vendor keeps every entry",
+              DEVICE_CACHE.is_fresh() and sorted(DEVICE_CACHE.devices) == scanned, failures)
+
+        DEVICE_CACHE.on_session_line(traffic("0f:87:00:e0:91"))
+        check("TV announcing another vendor clears the cache",
+              not DEVICE_CACHE.is_fresh() and not DEVICE_CACHE.devices, failures)
+
+        cec_control.scan_devices()
+
+        DEVICE_CACHE.on_session_line(traffic("4f:84:30:00:04"))
+        check("unknown physical address clears the cache", not DEVICE_CACHE.is_fresh(), failures)
+
+        response = controller.handle_command({"command": "SCAN", "refresh": True})
+        check(f"SCAN refresh rescans: {response['result'].splitlines()[0]!r}",
+              response["status"] == "success" and DEVICE_CACHE.is_fresh()
+              and sorted(DEVICE_CACHE.devices) == scanned, failures)
+    finally:
+        controller.stop()
+
+    return finish(failures, "device cache")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Status display latency
+Starts status_display.py on a plain file standing in for /dev/fb0, at
+1920x1080 in 32 bpp and 16 bpp, with a two-colour PPM per status, and
+switches statuses through update_display() the way a caller would. Reports
+the startup time and the time from request to image in the framebuffer,
+and checks the pixels that land there, unknown statuses and a missing
+renderer.
+"""
+import contextlib
+import io
+import mmap
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+from checks import RPI_DIR, check, finish
+
+import status_display  # noqa: E402
+import update_display  # noqa: E402
+
+WIDTH, HEIGHT = 1920, 1080
+ROUNDS = 40
+LATENCY_LIMIT_MS = 50.0
+
+# Status -> (top half, bottom half) colour
+COLOURS = {
+    "idle": ((0x1E, 0x3C, 0x72), (0xFF, 0xFF, 0xFF)),
+    "ready": ((0x00, 0x80, 0x00), (0x1E, 0x3C, 0x72)),
+    "sending": ((0xFF, 0xFF, 0x00), (0x1E, 0x3C, 0x72)),
+    "success": ((0x00, 0xFF, 0x00), (0x10, 0x20, 0x30)),
+    "error": ((0xFF, 0x00, 0x00), (0x1E, 0x3C, 0x72)),
+}
+
+
+def write_images(directory):
+    """PPM data under the names the renderer looks for; it goes by content, not extension"""
+    half = WIDTH * HEIGHT // 2
+    for status, (top, bottom) in COLOURS.items():
+        with open(os.path.join(directory, status_display.STATUS_IMAGES[status]), "wb") as image:
+            image.write(f"P6\n# {status}\n{WIDTH} {HEIGHT}\n255\n".encode())
+            image.write(bytes(top) * half + bytes(bottom) * half)
+
+
+def request(status, wait=True):
+    """update_display() without its console output"""
+    with contextlib.redirect_stdout(io.StringIO()):
+        return update_display.update_display(status, wait=wait)
+
+
+def pixel(colour, bpp):
+    red, green, blue = colour
+    if bpp == 16:
+        return (((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3)).to_bytes(2, "little")
+    return bytes([blue, green, red, 0xFF])
+
+
+def run(bpp, directory, failures):
+    fb_path = os.path.join(directory, f"fb{bpp}")
+    socket_path = os.path.join(directory, f"display{bpp}.sock")
+    open(fb_path, "wb").close()
+    env = dict(os.environ, CEC_FB_DEVICE=fb_path, CEC_FB_GEOMETRY=f"{WIDTH}x{HEIGHT}x{bpp}",
+               CEC_DISPLAY_DIR=directory, CEC_DISPLAY_SOCKET=socket_path)
+    start = time.monotonic()
+    renderer = subprocess.Popen([sys.executable, os.path.join(RPI_DIR, "status_display.py")], env=env,
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        while not os.path.exists(socket_path) and time.monotonic() - start < 30:
+            time.sleep(0.01)
+        startup = time.monotonic() - start
+        check(f"{bpp} bpp: renderer up with {len(COLOURS)} images in {startup:.2f} s",
+              os.path.exists(socket_path), failures)
+        if not os.path.exists(socket_path):
+            return
+
+        update_display.SOCKET_PATH = socket_path
+        step = bpp // 8
+        with open(fb_path, "rb") as fb:
+            screen = mmap.mmap(fb.fileno(), 0, access=mmap.ACCESS_READ)
+            top = (HEIGHT // 4 * WIDTH + WIDTH // 2) * step
+            bottom = (HEIGHT * 3 // 4 * WIDTH + WIDTH // 2) * step
+            check(f"{bpp} bpp: idle image shown at startup",
+                  screen[top:top + step] == pixel(COLOURS["idle"][0], bpp), failures)
+
+            times = []
+            wrong = []
+            statuses = list(COLOURS)
+            for round_ in range(ROUNDS):
+                status = statuses[round_ % len(statuses)]
+                begin = time.perf_counter()
+                ok = request(status)
+                times.append((time.perf_counter() - begin) * 1000.0)
+                colours = (screen[top:top + step], screen[bottom:bottom + step])
+                if not ok or colours != tuple(pixel(colour, bpp) for colour in COLOURS[status]):
+                    wrong.append(status)
+            times.sort()
+            check(f"{bpp} bpp: {ROUNDS} switches, p50 {times[len(times) // 2]:.1f} ms, "
+                  f"p95 {times[int(len(times) * 0.95)]:.1f} ms, max {times[-1]:.1f} ms",
+                  times[int(len(times) * 0.95)] < LATENCY_LIMIT_MS, failures)
+            check(f"{bpp} bpp: every switch shows the right pixels", not wrong, failures)
+
+            check(f"{bpp} bpp: unknown status refused, picture kept",
+                  not request("party")
+                  and screen[top:top + step] == pixel(COLOURS[statuses[(ROUNDS - 1) % len(statuses)]][0], bpp),
+                  failures)
+            screen.close()
+        check(f"{bpp} bpp: renderer still running", renderer.poll() is None, failures)
+    finally:
+        renderer.terminate()
+        renderer.wait(timeout=5)
+
+
+def main():
+    failures = []
+    with tempfile.TemporaryDirectory() as directory:
+        write_images(directory)
+        for bpp in (32, 16):
+            run(bpp, directory, failures)
+
+        update_display.SOCKET_PATH = os.path.join(directory, "nobody.sock")
+        start = time.perf_counter()
+        missing = request("ready", wait=False)
+        check(f"no renderer: fails in {(time.perf_counter() - start) * 1000:.1f} ms",
+              not missing, failures)
+
+    return finish(failures, "display")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Stand-in for cec-client used by the host-side tools
+Mimics the parts of the cec-client text interface the daemon relies on,
+including the adapter open delay, so latency can be measured without a
+CEC adapter. Timing is set through environment variables:
+  FAKE_CEC_OPEN_DELAY  seconds spent "opening the adapter" (default 1.0)
+  FAKE_CEC_CMD_DELAY   seconds per bus command (default 0.03)
+  FAKE_CEC_SCAN_DELAY  extra seconds a "scan" takes (default 15 commands' worth)
+  FAKE_CEC_JITTER      up to this many extra seconds per command, at random
+  FAKE_CEC_SEED        seed for the jitter, so runs can be repeated
+"""
+import os
+import random
+import sys
+import time
+
+OPEN_DELAY = float(os.environ.get("FAKE_CEC_OPEN_DELAY", "1.0"))
+CMD_DELAY = float(os.environ.get("FAKE_CEC_CMD_DELAY", "0.03"))
+SCAN_DELAY = float(os.environ.get("FAKE_CEC_SCAN_DELAY", str(CMD_DELAY * 15)))
+JITTER = float(os.environ.get("FAKE_CEC_JITTER", "0"))
+
+rng = random.Random(os.environ.get("FAKE_CEC_SEED"))
+
+READY = "waiting for input"
+
+# Simulated bus: logical address -> device
+DEVICES = {
+    0: {"name": "TV", "vendor": "Samsung", "vendor_id": 0x0000F0, "power": "on", "physical": "0.0.0.0"},
+    1: {"name": "CECTester", "vendor": "Pulse Eight", "vendor_id": 0x001582, "power": "on", "physical": "1.0.0.0"},
+    0xB: {"name": "Recorder", "vendor": "Panasonic", "vendor_id": 0x008045, "power": "standby",
+          "physical": "2.0.0.0"},
+}
+
+start_time = time.monotonic()
+
+
+def out(line):
+    sys.stdout.write(line + "\n")
+    sys.stdout.flush()
+
+
+def traffic(direction, frame):
+    ms = int((time.monotonic() - start_time) * 1000)
+    out(f"TRAFFIC: [{ms:8d}]\t{direction} {frame}")
+
+
+def parse_address(args, default=0):
+    try:
+        return int(args[0], 16)
+    except (IndexError, ValueError):
+        return default
+
+
+def handle(line):
+    parts = line.strip().split()
+    if not parts:
+        return True
+    verb, args = parts[0].lower(), parts[1:]
+    time.sleep(CMD_DELAY + (rng.uniform(0, JITTER) if JITTER else 0))
+
+    if verb == "q":
+        return False
+    elif verb in ("tx", "txn"):
+        frame = ":".join(args).lower() if args else ""
+        if not frame:
+            out("ERROR:   invalid command")
+            return True
+        dest = int(frame[1], 16)
+        traffic(">>", frame)
+        if dest != 0xF and dest not in DEVICES:
+            out(f"ERROR:   command '{frame}' was not acked by the controller")
+        elif dest in DEVICES and frame[3:5] in ("04", "0d"):
+            DEVICES[dest]["power"] = "on"       # Image View On / Text View On
+        elif dest in DEVICES and frame[3:5] == "36":
+            DEVICES[dest]["power"] = "standby"
+    elif verb == "on":
+        addr = parse_address(args)
+        traffic(">>", f"1{addr:x}:04")
+        if addr in DEVICES:
+            DEVICES[addr]["power"] = "on"
+    elif verb == "standby":
+        addr = parse_address(args)
+        traffic(">>", f"1{addr:x}:36")
+        if addr in DEVICES:
+            DEVICES[addr]["power"] = "standby"
+    elif verb in ("volup", "voldown", "mute"):
+        code = {"volup": "41", "voldown": "42", "mute": "43"}[verb]
+        traffic(">>", f"15:44:{code}")
+        traffic(">>", "15:45")
+    elif verb in ("as", "is"):
+        traffic(">>", "1f:82:10:00" if verb == "as" else "10:9d:10:00")
+    elif verb == "pow":
+        addr = parse_address(args)
+        device = DEVICES.get(addr)
+        out("power status: " + (device["power"] if device else "unknown"))
+    elif verb == "ven":
+        addr = parse_address(args)
+        device = DEVICES.get(addr)
+        out("vendor id: " + (device["vendor"] if device else "Unknown"))
+    elif verb == "name":
+        addr = parse_address(args)
+        device = DEVICES.get(addr)
+        out(f"osd name of device {addr} is '{device['name'] if device else ''}'")
+    elif verb == "poll":
+        addr = parse_address(args)
+        traffic(">>", f"1{addr:x}")
+        out("POLL message sent" if addr in DEVICES else "POLL message failed")
+    elif verb == "scan":
+        time.sleep(SCAN_DELAY)
+        out("requesting CEC bus information ...")
+        out("CEC bus information")
+        out("===================")
+        for addr, device in DEVICES.items():
+            out(f"device #{addr:X}: {device['name']}")
+            out(f"address:       {device['physical']}")
+            out("active source: no")
+            out(f"vendor:        {device['vendor']}")
+            out(f"osd string:    {device['name']}")
+            out("CEC version:   1.4")
+            out(f"power status:  {device['power']}")
+            out("language:      eng")
+            out("")
+        out("currently active source: unknown (-1)")
+    else:
+        out(f"ERROR:   unknown command '{verb}'")
+    return True
+
+
+def main():
+    single = "-s" in sys.argv[1:]
+    time.sleep(OPEN_DELAY)
+    if single:
+        handle(sys.stdin.readline())
+        return 0
+
+    out("opening a connection to the CEC adapter...")
+    out(READY)
+    for line in sys.stdin:
+        if not handle(line):
+            break
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
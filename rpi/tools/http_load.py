@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""
+HTTP endpoint load test
+Starts the daemon's command handling and HTTP server with the fake CEC
+backend on a free port, then drives it from asyncio clients:
+
+  ping        CLIENTS keep-alive connections sending GET /?cmd=PING
+  ping/close  the same with a new connection per request
+  status      POST / {"command": "STATUS"}, answered from the bus state
+  power       POST / POWER_ON, which goes to the (fake) bus through the scheduler
+  batch       POST /batch with BATCH_SIZE commands each
+
+Reports requests/s with p50/p99 latency per run and checks the replies,
+that keep-alive connections are reused, that a batch answers in order,
+that a full batch of bus commands leaves the UART's workers free, and how
+malformed requests are refused.
+"""
+import asyncio
+import json
+import sys
+import time
+
+from checks import check, finish, use_fake_backend
+
+use_fake_backend()
+
+from main import CECController  # noqa: E402
+from http_server import MAX_BATCH  # noqa: E402
+
+CLIENTS = 16
+REQUESTS = 200             # Per client and run
+POWER_REQUESTS = 10        # Per client; every one is a frame on the fake bus
+BATCH_SIZE = 10
+BATCHES = 25               # Per client
+P99_LIMIT_MS = 250.0
+
+
+class Client:
+    """One HTTP/1.1 connection, opened again whenever the server closed it"""
+    def __init__(self, port, keep_alive=True):
+        self.port = port
+        self.keep_alive = keep_alive
+        self.reader = self.writer = None
+
+    async def request(self, method, target, body=None, raw=None):
+        """(status, decoded JSON body)"""
+        if self.writer is None:
+            self.reader, self.writer = await asyncio.open_connection("127.0.0.1", self.port)
+        data = b"" if body is None else json.dumps(body).encode()
+        self.writer.write(raw or (f"{method} {target} HTTP/1.1\r\nHost: pi\r\nContent-Length: {len(data)}\r\n"
+                                  f"Connection: {'keep-alive' if self.keep_alive else 'close'}\r\n\r\n").encode()
+                          + data)
+        head = await self.reader.readuntil(b"\r\n\r\n")
+        lines = head.decode().split("\r\n")
+        headers = {k.lower(): v.strip() for k, _, v in (line.partition(":") for line in lines[1:] if line)}
+        reply = await self.reader.readexactly(int(headers["content-length"]))
+        if headers.get("connection") == "close":
+            await self.close()
+        return int(lines[0].split()[1]), json.loads(reply)
+
+    async def close(self):
+        if self.writer:
+            self.writer.close()
+            self.writer = self.reader = None
+
+
+def percentile(times, p):
+    return times[min(len(times) - 1, int(len(times) * p / 100))]
+
+
+async def load(port, name, count, make_request, keep_alive=True, commands_per_request=1):
+    """count requests per client from CLIENTS clients at once; (stats text, replies, p99)"""
+    times = []
+    replies = []
+
+    async def client_loop(index):
+        client = Client(port, keep_alive)
+        for i in range(count):
+            method, target, body = make_request(index, i)
+            start = time.perf_counter()
+            status, reply = await client.request(method, target, body)
+            times.append((time.perf_counter() - start) * 1000.0)
+            replies.append((status, reply))
+        await client.close()
+
+    start = time.perf_counter()
+    await asyncio.gather(*(client_loop(index) for index in range(CLIENTS)))
+    elapsed = time.perf_counter() - start
+    times.sort()
+    rate = len(times) / elapsed
+    text = (f"{name:<11} {len(times):5d} requests {rate:7.0f} req/s"
+            + (f" ({rate * commands_per_request:.0f} commands/s)" if commands_per_request > 1 else "")
+            + f"  p50 {percentile(times, 50):6.1f} ms  p99 {percentile(times, 99):6.1f} ms")
+    return text, replies, percentile(times, 99)
+
+
+async def run(controller, failures):
+    server = controller.http
+    port = server.port
+
+    def all_ok(replies):
+        return all(status == 200 and reply.get("status") == "success" for status, reply in replies)
+
+    connections = server.connections
+    text, replies, p99 = await load(port, "ping", REQUESTS, lambda c, i: ("GET", "/?cmd=PING", None))
+    check(text, all_ok(replies) and all(r["result"] == "pong" for _, r in replies) and p99 < P99_LIMIT_MS,
+          failures)
+    check(f"keep-alive: {server.connections - connections} connections for {len(replies)} requests",
+          server.connections - connections == CLIENTS, failures)
+
+    text, replies, _ = await load(port, "ping/close", REQUESTS // 4, lambda c, i: ("GET", "/?cmd=PING", None),
+                                  keep_alive=False)
+    check(text, all_ok(replies), failures)
+
+    text, replies, p99 = await load(port, "status", REQUESTS,
+                                    lambda c, i: ("POST", "/", {"command": "STATUS", "id": i}))
+    check(text, all_ok(replies) and all(r["result"].startswith("📺 TV: on") for _, r in replies)
+          and p99 < P99_LIMIT_MS, failures)
+
+    text, replies, _ = await load(port, "power", POWER_REQUESTS, lambda c, i: ("POST", "/", {"command": "POWER_ON"}))
+    check(text, all_ok(replies), failures)
+
+    def batch(client, i):
+        return "POST", "/batch", [{"command": "STATUS" if n % 2 else "PING", "id": n} for n in range(BATCH_SIZE)]
+    text, replies, _ = await load(port, "batch", BATCHES, batch, commands_per_request=BATCH_SIZE)
+    check(text, all(status == 200 and len(reply) == BATCH_SIZE for status, reply in replies), failures)
+    check("batch replies in command order",
+          all([r["id"] for r in reply] == list(range(BATCH_SIZE)) and reply[0]["result"] == "pong"
+              for _, reply in replies), failures)
+
+    # A full batch of bus commands occupies the HTTP workers only; a UART PING is answered meanwhile
+    def uart_ping():
+        start = time.perf_counter()
+        reply = controller.executor.submit(controller.process_request, {"command": "PING"}).result()
+        return reply, (time.perf_counter() - start) * 1000.0
+    client = Client(port)
+    start = time.perf_counter()
+    batch_task = asyncio.ensure_future(client.request(
+        "POST", "/batch", [{"command": "CUSTOM", "cec_command": "tx 10:44:%02X" % n} for n in range(MAX_BATCH)]))
+    await asyncio.sleep(0.05)
+    reply, ping_ms = await asyncio.get_running_loop().run_in_executor(None, uart_ping)
+    status, replies = await batch_task
+    batch_ms = (time.perf_counter() - start) * 1000.0
+    await client.close()
+    check(f"UART PING in {ping_ms:.1f} ms during a {MAX_BATCH}-command batch of {batch_ms:.0f} ms",
+          reply["result"] == "pong" and status == 200 and len(replies) == MAX_BATCH
+          and ping_ms < batch_ms / 4, failures)
+
+    # Requests that cannot be read are answered and, where the stream is lost, closed
+    client = Client(port)
+    cases = [
+        ("GET", "/nowhere", None, 404),
+        ("GET", "/batch", None, 405),
+        ("GET", "/?refresh=1", None, 400),
+        ("POST", "/batch", {"command": "PING"}, 400),
+        ("POST", "/batch", [{"command": "PING"}] * 65, 413),
+    ]
+    got = []
+    for method, target, body, expected in cases:
+        status, reply = await client.request(method, target, body)
+        got.append(status)
+    status, reply = await client.request("POST", "/", raw=b"POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n{nope")
+    got.append(status)
+    await client.close()
+    check(f"bad requests refused: {got}", got == [case[3] for case in cases] + [400], failures)
+
+    client = Client(port)
+    status, reply = await client.request("GET", "/?cmd=POWER_OFF&adapter=kitchen")
+    await client.close()
+    check(f"errors from the command engine keep status 200: {reply['result']!r}",
+          status == 200 and reply["status"] == "error", failures)
+
+
+def main():
+    controller = CECController(uart_port="/dev/null")
+    controller.running = True
+    controller.start_http_interface(port=0)
+    failures = []
+    try:
+        if controller.http is None:
+            print("FAILED  HTTP server did not start")
+            return 1
+        print(f"HTTP server on port {controller.http.port}, {CLIENTS} clients, fake CEC backend")
+        controller.handle_command({"command": "STATUS", "refresh": True})
+        asyncio.run(run(controller, failures))
+    finally:
+        controller.stop()
+
+    return finish(failures, "HTTP")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
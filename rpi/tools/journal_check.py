@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Command journal check
+Runs command_journal.py in a temporary directory with small segments.
+Checks that segments rotate and only the newest are kept, that the .idx
+offsets are rebuilt after a torn line, a line without its index entry and
+a torn index entry, and that "last N" of all and of successful commands
+goes past the in-memory ring to the journal. Last, an export returns at
+most EXPORT_LIMIT records, while write_export() streams every retained one
+to a file without loading them all.
+"""
+import json
+import os
+import sys
+import tempfile
+import tracemalloc
+
+from checks import check, finish
+
+import command_journal  # noqa: E402
+from command_journal import INDEX_ENTRY, CommandHistory, Journal  # noqa: E402
+
+SEGMENT_BYTES = 1024
+SEGMENTS = 3
+RECORDS = 1000
+RING = 10
+
+
+def entry(n, success=True):
+    """A log_command() entry; successful ones are tx commands, so they have a BrightSign record"""
+    command = "tx 4F:82:%02X:00" % (n % 256)
+    return {"timestamp": f"2026-01-01T00:00:{n:05d}", "command": command, "result": "ok" if success else "failed",
+            "success": success, "vendor": "Samsung", "raw_cec_command": command}
+
+
+def offsets_valid(journal):
+    """Every index entry points at the start of a whole JSON line"""
+    for number in journal.segments:
+        data_path, index_path = journal._paths(number)
+        with open(index_path, "rb") as index, open(data_path, "rb") as data:
+            raw = index.read()
+            if len(raw) % INDEX_ENTRY.size:
+                return False
+            for (offset,) in INDEX_ENTRY.iter_unpack(raw):
+                data.seek(offset)
+                line = data.readline()
+                if not line.endswith(b"\n"):
+                    return False
+                json.loads(line)
+    return True
+
+
+def reopen(journal):
+    journal.data.close()
+    journal.index.close()
+    return Journal(journal.directory, journal.name, segment_bytes=journal.segment_bytes, segments=journal.max_segments)
+
+
+def check_rotation(directory, failures):
+    journal = Journal(directory, "rot", segment_bytes=SEGMENT_BYTES, segments=SEGMENTS)
+    for n in range(RECORDS):
+        journal.append({"n": n})
+    files = sorted(name for name in os.listdir(directory) if name.startswith("rot."))
+    check(f"rotation keeps the newest {SEGMENTS} segments: {journal.segments}",
+          len(journal.segments) == SEGMENTS and journal.segments[0] > 1 and len(files) == 2 * SEGMENTS
+          and journal.segments == list(range(journal.segments[0], journal.segments[0] + SEGMENTS))
+          and all(os.path.getsize(journal._paths(number)[0]) <= SEGMENT_BYTES for number in journal.segments),
+          failures)
+    count = journal.count()
+    newest = [record["n"] for record in journal.last(count + 50)]
+    check(f"last() across segments: {count} records, {newest[0]}..{newest[-1]}",
+          newest == list(range(RECORDS - count, RECORDS))
+          and [r["n"] for r in journal.last(5)] == list(range(RECORDS - 5, RECORDS)), failures)
+
+
+def check_recovery(directory, failures):
+    cases = [
+        ("torn line", lambda data, index: data.write(b'{"n": 99, "torn'), 20),
+        ("line without its index entry", lambda data, index: data.write(b'{"n": 20}\n'), 21),
+        ("torn index entry", lambda data, index: index.write(b"\x00\x01\x02"), 20),
+    ]
+    for name, damage, expected in cases:
+        journal = Journal(os.path.join(directory, name.replace(" ", "_")), "rec",
+                          segment_bytes=SEGMENT_BYTES * 4, segments=SEGMENTS)
+        for n in range(20):
+            journal.append({"n": n})
+        data_path, index_path = journal._paths(journal.segments[-1])
+        with open(data_path, "ab") as data, open(index_path, "ab") as index:
+            damage(data, index)
+        journal = reopen(journal)
+        recovered = journal.count()
+        journal.append({"n": 100})
+        last = [record["n"] for record in journal.last(3)]
+        check(f"{name}: index rebuilt with {recovered} records, then {last}",
+              recovered == expected and last == [expected - 2, expected - 1, 100] and offsets_valid(journal),
+              failures)
+
+
+def check_history(directory, failures):
+    history = CommandHistory(directory, ring_size=RING, segment_bytes=SEGMENT_BYTES * 16, segments=SEGMENTS)
+    for n in range(60):
+        history.record(entry(n, success=n % 3 != 0))
+    every = history.last(30)
+    check(f"last(30) past a ring of {RING}: {len(every)} commands",
+          [e["timestamp"] for e in every] == [entry(n)["timestamp"] for n in range(30, 60)], failures)
+    successful = history.last(25, successful_only=True)
+    wanted = [n for n in range(60) if n % 3 != 0][-25:]
+    check(f"last(25, successful_only) past a ring of {RING}: {len(successful)} commands",
+          [e["timestamp"] for e in successful] == [entry(n)["timestamp"] for n in wanted]
+          and all(e["success"] for e in successful), failures)
+    check("a short last() still comes from the ring",
+          history.last(3, successful_only=True) == list(history.recent_successful)[-3:], failures)
+
+
+def check_export(directory, failures):
+    history = CommandHistory(directory, ring_size=RING, segment_bytes=256 * 1024, segments=SEGMENTS)
+    total = 3000
+    for n in range(total):
+        history.record(entry(n))
+    command_journal.EXPORT_LIMIT = 100
+    exported = history.brightsign_export()
+    check(f"export is bounded by default: {len(exported)} of {total} records",
+          len(exported) == 100 and exported[-1]["timestamp"] == entry(total - 1)["timestamp"]
+          and len(history.brightsign_export(7)) == 7 and len(history.brightsign_export(10 ** 6)) == 100, failures)
+
+    path = os.path.join(directory, "export.json")
+    size = sum(os.path.getsize(history.brightsign._paths(number)[0]) for number in history.brightsign.segments)
+    tracemalloc.start()
+    history.write_export(path)
+    _, peak = tracemalloc.get_traced_memory()
+    tracemalloc.stop()
+    with open(path) as f:
+        written = json.load(f)["brightsign_format"]
+    check(f"full export streamed: {len(written)} records, peak {peak // 1024} KiB for {size // 1024} KiB on disk",
+          len(written) == history.brightsign.count() == total and peak < size / 4, failures)
+
+
+def main():
+    failures = []
+    with tempfile.TemporaryDirectory(prefix="cec_journal_") as directory:
+        check_rotation(directory, failures)
+        check_recovery(directory, failures)
+        check_history(os.path.join(directory, "history"), failures)
+        check_export(os.path.join(directory, "export"), failures)
+    return finish(failures, "journal")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
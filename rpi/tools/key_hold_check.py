@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Press-and-hold key check over a pty pair
+Runs the daemon's UART loop on one end of a pty with the fake CEC backend
+and plays the Flipper on the other, streaming OP_KEY events the way the
+app's remote screen does: DOWN on press, REPEAT every 150 ms from 300 ms
+on, UP on release. Checks the <User Control Pressed>/<Released> frames on
+the simulated bus and their timing, the Pi's own release when UP never
+comes, and that key events get no reply.
+"""
+import os
+import pty
+import select
+import sys
+import time
+import tty
+
+from checks import check, finish, use_fake_backend
+
+use_fake_backend()
+
+import key_hold  # noqa: E402
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+from scheduler import get_scheduler  # noqa: E402
+
+# Flipper input timing: long press after 300 ms, then a repeat every 150 ms
+LONG_PRESS = 0.3
+FLIPPER_REPEAT = 0.15
+
+VOLUME_UP = 0x41
+NAV_UP = 0x01
+
+
+class Bus:
+    """Every frame the fake backend puts on the bus, with the time it went out"""
+    def __init__(self, backend):
+        self.frames = []
+        transmit = backend.transmit
+
+        def recorded(frame, *args, **kwargs):
+            self.frames.append((time.monotonic(), bytes(frame)))
+            return transmit(frame, *args, **kwargs)
+        backend.transmit = recorded
+
+    def keys(self, since):
+        """(time, destination, opcode) of the Pressed/Released frames since since"""
+        return [(t, f[0] & 0xF, f[1]) for t, f in self.frames
+                if t >= since and len(f) >= 2 and f[1] in (0x44, 0x45)]
+
+
+def key(fd, action, code, destination=None):
+    payload = bytes([action, code]) + (bytes([destination]) if destination is not None else b"")
+    os.write(fd, proto.encode_frame(proto.OP_KEY, 0, payload))
+
+
+def hold(fd, code, seconds, release=True):
+    """Press code for seconds with the Flipper's repeat pattern"""
+    key(fd, proto.KEY_DOWN, code)
+    start = time.monotonic()
+    next_repeat = start + LONG_PRESS
+    while True:
+        now = time.monotonic()
+        if now - start >= seconds:
+            break
+        if now >= next_repeat:
+            key(fd, proto.KEY_REPEAT, code)
+            next_repeat += FLIPPER_REPEAT
+        time.sleep(0.01)
+    if release:
+        key(fd, proto.KEY_UP, code)
+
+
+def main():
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    controller = CECController(uart_port=os.ttyname(slave))
+    controller.running = True
+    controller.start_uart_interface()
+    bus = Bus(get_scheduler().backend)
+    failures = []
+
+    try:
+        # Tap: one press and its release, to the audio system
+        start = time.monotonic()
+        key(master, proto.KEY_DOWN, VOLUME_UP)
+        key(master, proto.KEY_UP, VOLUME_UP)
+        time.sleep(0.2)
+        frames = bus.keys(start)
+        check(f"tap -> {[hex(f[2]) for f in frames]} to {[f[1] for f in frames]}",
+              [f[2] for f in frames] == [0x44, 0x45] and all(f[1] == key_hold.AUDIO_SYSTEM for f in frames),
+              failures)
+
+        # Hold for 2 s: Pressed at the CEC repeat rate, whatever the Flipper's rate is
+        start = time.monotonic()
+        hold(master, VOLUME_UP, 2.0)
+        time.sleep(0.2)
+        frames = bus.keys(start)
+        pressed = [t for t, _, opcode in frames if opcode == 0x44]
+        gaps = [b - a for a, b in zip(pressed, pressed[1:])]
+        check(f"2 s hold -> {len(pressed)} presses, gaps {min(gaps) * 1000:.0f}-{max(gaps) * 1000:.0f} ms",
+              6 <= len(pressed) <= 8 and all(0.2 <= gap <= 0.5 for gap in gaps), failures)
+        check("hold ends with one release", [f[2] for f in frames].count(0x45) == 1 and frames[-1][2] == 0x45,
+              failures)
+
+        # Navigation goes to the TV
+        start = time.monotonic()
+        hold(master, NAV_UP, 0.5)
+        time.sleep(0.2)
+        frames = bus.keys(start)
+        check("navigation key held on the TV", frames and all(f[1] == 0 for f in frames), failures)
+
+        # UP lost: the Pi releases by itself once repeats stop
+        start = time.monotonic()
+        hold(master, VOLUME_UP, 1.0, release=False)
+        silent = time.monotonic()
+        time.sleep(key_hold.HOLD_TIMEOUT + 0.3)
+        released = [t for t, _, opcode in bus.keys(start) if opcode == 0x45]
+        check("lost key up released after %.0f ms" % ((released[0] - silent) * 1000 if released else -1),
+              len(released) == 1 and released[0] - silent <= key_hold.HOLD_TIMEOUT + 0.1, failures)
+
+        # DOWN lost: repeats alone start the hold, a second key releases the first
+        start = time.monotonic()
+        key(master, proto.KEY_REPEAT, NAV_UP)
+        time.sleep(0.1)
+        key(master, proto.KEY_DOWN, VOLUME_UP)
+        key(master, proto.KEY_UP, VOLUME_UP)
+        time.sleep(0.2)
+        frames = bus.keys(start)
+        check("repeat without down presses, next key releases it",
+              [(f[1], f[2]) for f in frames] == [(0, 0x44), (0, 0x45), (5, 0x44), (5, 0x45)], failures)
+
+        # Explicit destination (nothing at 4 on the fake bus: no ack, so no hold) and a malformed event
+        start = time.monotonic()
+        key(master, proto.KEY_DOWN, NAV_UP, 4)
+        key(master, proto.KEY_UP, NAV_UP)
+        os.write(master, proto.encode_frame(proto.OP_KEY, 0, b"\x07"))
+        time.sleep(0.2)
+        check("destination byte honoured", [(f[1], f[2]) for f in bus.keys(start)] == [(4, 0x44)], failures)
+
+        ready, _, _ = select.select([master], [], [], 0.1)
+        check("key events are not answered", not ready, failures)
+    finally:
+        controller.stop()
+        os.close(master)
+
+    return finish(failures, "key hold")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Command scheduler check
+Puts the scheduler in front of the fake backend, with a delay per frame so
+that commands queue up, and checks ordering and merging: a POWER_OFF sent
+behind a queued scan and a discovery runs first, ten VOLUME_UP presses run
+as one job of ten steps, up and down presses cancel out, a superseded input
+switch is answered as such, and the per-class stats count it all.
+"""
+import sys
+import threading
+import time
+
+from checks import check, finish
+
+import cec_backend  # noqa: E402
+from discovery import Discovery  # noqa: E402
+from scheduler import BULK, CommandScheduler  # noqa: E402
+
+FRAME_DELAY = 0.02
+
+
+class Recorder:
+    """Fake backend that notes the order commands reach it in"""
+    def __init__(self):
+        self.backend = cec_backend.FakeBackend(delay=FRAME_DELAY)
+        self.backend.start()
+        self.name = self.backend.name
+        self.min_gap = self.backend.min_gap
+        self.commands = []
+
+    def add_listener(self, callback):
+        self.backend.add_listener(callback)
+
+    def execute(self, command, timeout=10):
+        self.commands.append(command)
+        return self.backend.execute(command, timeout=timeout)
+
+
+def submit(scheduler, command, results, priority=None):
+    def run():
+        results[command] = scheduler.execute(command, timeout=10, priority=priority)
+    thread = threading.Thread(target=run)
+    thread.start()
+    return thread
+
+
+def presses(scheduler, commands):
+    """Submit commands in order, a moment apart; their replies once all are answered"""
+    replies = []
+    threads = []
+    for command in commands:
+        threads.append(threading.Thread(target=lambda c=command: replies.append(scheduler.execute(c))))
+        threads[-1].start()
+        time.sleep(0.001)
+    for thread in threads:
+        thread.join()
+    return replies
+
+
+def hold(scheduler):
+    """Keep the worker busy for a moment so the next submissions queue up"""
+    thread = submit(scheduler, "tx 4F:8F", {})
+    time.sleep(0.005)
+    return thread
+
+
+def main():
+    failures = []
+    recorder = Recorder()
+    scheduler = CommandScheduler(recorder)
+    try:
+        # Scan and discovery queued first, POWER_OFF last, still runs right after the busy command
+        threads = [hold(scheduler)]
+        results = {}
+        threads.append(submit(scheduler, "scan", results))
+
+        def discover():
+            with scheduler.priority(BULK):
+                Discovery(scheduler).run()
+        threads.append(threading.Thread(target=discover))
+        threads[-1].start()
+        time.sleep(0.005)
+        threads.append(submit(scheduler, "standby 0", results))
+        for thread in threads:
+            thread.join()
+        order = recorder.commands
+        check(f"standby ran before the scan ({order.index('standby 0')} < {order.index('scan')})",
+              order.index("standby 0") < order.index("scan")
+              and all(order.index("standby 0") < i for i, c in enumerate(order) if c.startswith("poll")),
+              failures)
+
+        # Ten VOLUME_UP presses while the bus is busy: one job, ten steps on the bus
+        del recorder.commands[:]
+        jobs = scheduler.stats[0].jobs
+        hold_thread = hold(scheduler)
+        replies = presses(scheduler, ["volup"] * 10)
+        hold_thread.join()
+        volume = [c for c in recorder.commands if c.startswith("vol")]
+        check(f"10 volup -> {scheduler.stats[0].jobs - jobs - 1} job, {len(volume)} steps",
+              scheduler.stats[0].jobs - jobs == 2 and len(volume) == 10
+              and len(replies) == 10 and all(ok for ok, _ in replies), failures)
+
+        # Up and down presses queued together cancel out
+        del recorder.commands[:]
+        hold_thread = hold(scheduler)
+        replies = presses(scheduler, ["volup", "voldown", "volup", "voldown"])
+        hold_thread.join()
+        check("volup/voldown pairs cancel out",
+              not any(c.startswith("vol") for c in recorder.commands)
+              and all("unchanged" in output for _, output in replies), failures)
+
+        # A newer input switch for the same device supersedes the queued one
+        del recorder.commands[:]
+        threads = [hold(scheduler)]
+        results = {}
+        threads.append(submit(scheduler, "tx 4F:82:10:00", results))
+        time.sleep(0.005)
+        threads.append(submit(scheduler, "tx 4F:82:20:00", results))
+        for thread in threads:
+            thread.join()
+        old = results["tx 4F:82:10:00"]
+        check("superseded input switch answered as superseded",
+              old[0] and "Superseded" in old[1] and "tx 4F:82:10:00" not in recorder.commands
+              and "tx 4F:82:20:00" in recorder.commands, failures)
+
+        # Identical queries share one run
+        del recorder.commands[:]
+        hold_thread = hold(scheduler)
+        replies = presses(scheduler, ["pow 0"] * 3)
+        hold_thread.join()
+        check(f"3 identical queries -> {recorder.commands.count('pow 0')} run",
+              recorder.commands.count("pow 0") == 1 and len(replies) == 3, failures)
+
+        stats = scheduler.to_dict()["classes"]
+        check("stats count merges per class",
+              stats["control"]["merged"] >= 9 + 3 and stats["control"]["superseded"] == 1
+              and stats["query"]["merged"] == 2 and stats["bulk"]["jobs"] > 1, failures)
+        check("stats report queue depth and wait",
+              stats["control"]["max_depth"] >= 1 and stats["bulk"]["wait"]["p95"] > 0
+              and all(entry["depth"] == 0 for entry in stats.values()), failures)
+        print(scheduler.format_text())
+    finally:
+        scheduler.stop()
+
+    return finish(failures, "scheduler")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+UART reader latency and idle wakeups over a pty pair
+Runs the daemon's UART reader on one end of a pty and measures, for the
+old 100 ms polling loop and the current select() reader:
+  - round trip of a PING frame (nothing else on the path is slow)
+  - wakeups and CPU time of the reader thread while the link is idle
+Wakeups are the thread's voluntary context switches from /proc, so this
+needs Linux.
+"""
+import argparse
+import os
+import pty
+import select
+import statistics
+import sys
+import time
+import tty
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(TOOLS_DIR))
+os.environ.setdefault("CEC_BACKEND", "cec-client")
+os.environ.setdefault("CEC_CLIENT_BIN", os.path.join(TOOLS_DIR, "fake_cec_client.py"))
+os.environ.setdefault("FAKE_CEC_OPEN_DELAY", "0.2")
+
+import uart_protocol as proto  # noqa: E402
+from main import CECController, logger  # noqa: E402
+
+
+class PollingController(CECController):
+    """The reader as it was before select(): poll in_waiting every 100 ms"""
+
+    def uart_loop(self):
+        while self.running:
+            try:
+                if self.uart_serial and self.uart_serial.in_waiting > 0:
+                    data = self.uart_serial.read(self.uart_serial.in_waiting)
+                    for message in self.decoder.feed(data):
+                        self.executor.submit(self.dispatch_message, message)
+                time.sleep(0.1)
+            except Exception:
+                time.sleep(1)
+
+
+def thread_counters(tid):
+    """(voluntary context switches, CPU ms) of one thread"""
+    with open(f"/proc/self/task/{tid}/status") as f:
+        switches = next(int(line.split()[1]) for line in f if line.startswith("voluntary_ctxt_switches"))
+    with open(f"/proc/self/task/{tid}/stat") as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    ticks = int(fields[11]) + int(fields[12])
+    return switches, ticks * 1000 / os.sysconf("SC_CLK_TCK")
+
+
+def round_trip(master, decoder, seq):
+    start = time.monotonic()
+    os.write(master, proto.encode_frame(proto.OP_PING, seq))
+    while True:
+        ready, _, _ = select.select([master], [], [], 5)
+        if not ready:
+            raise TimeoutError("no reply")
+        if decoder.feed(os.read(master, 4096)):
+            return (time.monotonic() - start) * 1000
+
+
+def measure(controller_class, count, idle):
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    controller = controller_class(uart_port=os.ttyname(slave))
+    controller.running = True
+    controller.start_uart_interface()
+    decoder = proto.FrameDecoder()
+    try:
+        # Spread requests so each lands at a random point of the poll interval
+        samples = []
+        for seq in range(1, count + 1):
+            samples.append(round_trip(master, decoder, seq))
+            time.sleep(0.013 * (seq % 7))
+
+        tid = controller.uart_thread.native_id
+        switches, cpu_ms = thread_counters(tid)
+        time.sleep(idle)
+        end_switches, end_cpu_ms = thread_counters(tid)
+    finally:
+        controller.stop()
+        os.close(master)
+    return samples, (end_switches - switches) / idle, end_cpu_ms - cpu_ms
+
+
+def report(label, samples, wakeups, cpu_ms):
+    ordered = sorted(samples)
+    p95 = ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))]
+    print(f"{label:<16} rtt mean={statistics.mean(samples):6.1f} ms  p95={p95:6.1f} ms  max={ordered[-1]:6.1f} ms"
+          f"  idle wakeups={wakeups:5.1f}/s  idle cpu={cpu_ms:.0f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("-n", "--count", type=int, default=40, help="PING round trips per reader")
+    parser.add_argument("--idle", type=float, default=3.0, help="seconds of idle link to sample")
+    args = parser.parse_args()
+    logger.disabled = True
+
+    before = measure(PollingController, args.count, args.idle)
+    after = measure(CECController, args.count, args.idle)
+    report("poll 100 ms", *before)
+    report("select", *after)
+    print(f"added latency removed: {statistics.mean(before[0]) - statistics.mean(after[0]):.1f} ms per request")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+UART protocol round trip over a pty pair
+Runs the daemon's UART loop on one end of a pty (standing in for
+/dev/ttyAMA0) and plays the Flipper on the other. Every request is sent
+once as a JSON line and once as a binary frame; the script checks that
+both encodings produce the same result and reports bytes on the wire.
+A final burst of pipelined frames checks that replies are matched by
+sequence ID and that a slow SCAN does not block faster requests, and two
+DISCOVER runs check that device records stream ahead of the final result
+and that a re-scan reuses what it already knows. STATS at the end prints
+the daemon's latency breakdown for everything sent.
+Exits non-zero on any mismatch.
+"""
+import json
+import os
+import pty
+import re
+import select
+import sys
+import time
+import tty
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(TOOLS_DIR))
+os.environ.setdefault("CEC_BACKEND", "cec-client")
+os.environ.setdefault("CEC_CLIENT_BIN", os.path.join(TOOLS_DIR, "fake_cec_client.py"))
+os.environ.setdefault("FAKE_CEC_OPEN_DELAY", "0.2")
+os.environ.setdefault("FAKE_CEC_CMD_DELAY", "0.005")
+
+import uart_protocol as proto  # noqa: E402
+from main import CECController  # noqa: E402
+
+# (JSON request as the Flipper command tables send it, equivalent opcode + payload)
+REQUESTS = [
+    ({"command": "PING", "proto": proto.PROTOCOL_VERSION}, proto.OP_PING, b''),
+    ({"command": "CUSTOM", "cec_command": "on 0"}, proto.OP_POWER_ON, bytes([0])),
+    ({"command": "CUSTOM", "cec_command": "standby 0"}, proto.OP_POWER_OFF, bytes([0])),
+    # Addresses past 9 catch a decimal payload decode ("standby 11" instead of "standby b")
+    ({"command": "CUSTOM", "cec_command": "standby b"}, proto.OP_POWER_OFF, bytes([0xB])),
+    ({"command": "CUSTOM", "cec_command": "on b"}, proto.OP_POWER_ON, bytes([0xB])),
+    ({"command": "CUSTOM", "cec_command": "tx 4F:82:10:00"}, proto.OP_TX, bytes([0x4F, 0x82, 0x10, 0x00])),
+    ({"command": "CUSTOM", "cec_command": "volup"}, proto.OP_VOLUME_UP, b''),
+    ({"command": "CUSTOM", "cec_command": "tx 48:82:10:00"}, proto.OP_TX, bytes([0x48, 0x82, 0x10, 0x00])),
+    ({"command": "STATUS"}, proto.OP_STATUS, b''),
+]
+
+# Sent back to back; the slow SCAN must not hold up the others
+PIPELINE = [
+    (proto.OP_SCAN, b''),
+    (proto.OP_PING, b''),
+    (proto.OP_DISPLAY_LOGS, b''),
+    (proto.OP_PING, b''),
+]
+
+
+def normalize(result):
+    """Drop cec-client traffic timestamps so both replies compare equal"""
+    return result[0], re.sub(r"\[\s*\d+\]", "[]", result[1])
+
+
+# Replies decoded ahead of the one asked for, handed out next time
+_pending = []
+
+
+def read_replies(fd, decoder, count, timeout=10):
+    deadline = time.monotonic() + timeout
+    received = 0
+    replies = _pending[:]
+    _pending.clear()
+    while len(replies) < count and time.monotonic() < deadline:
+        ready, _, _ = select.select([fd], [], [], 0.05)
+        if not ready:
+            continue
+        data = os.read(fd, 4096)
+        received += len(data)
+        replies.extend(decoder.feed(data))
+    if len(replies) < count:
+        raise TimeoutError("no reply")
+    _pending.extend(replies[count:])
+    return replies[:count], received
+
+
+def read_reply(fd, decoder, timeout=10):
+    replies, received = read_replies(fd, decoder, 1, timeout)
+    return replies[0], received
+
+
+def decode_json_reply(message, request_id):
+    response = json.loads(message[1])
+    if response.get("id") != request_id:
+        raise ValueError("reply for id %r, expected %r" % (response.get("id"), request_id))
+    return proto.response_succeeded(response), response.get("result", "")
+
+
+def decode_frame_reply(message, seq):
+    if message[0] != "frame" or message[1] != proto.OP_RESULT:
+        raise ValueError("unexpected reply " + repr(message))
+    if message[2] != seq:
+        raise ValueError("reply for seq %d, expected %d" % (message[2], seq))
+    payload = message[3]
+    return payload[0] == proto.STATUS_OK, payload[1:].decode('utf-8')
+
+
+def run_pipeline(master, decoder):
+    """Send several frames back to back and match replies by sequence ID"""
+    start = time.monotonic()
+    for seq, (opcode, payload) in enumerate(PIPELINE, start=100):
+        os.write(master, proto.encode_frame(opcode, seq, payload))
+    replies, _ = read_replies(master, decoder, len(PIPELINE))
+
+    order = [message[2] for message in replies]
+    print(f"pipelined seqs sent {list(range(100, 100 + len(PIPELINE)))}, replies arrived {order}")
+    print(f"all {len(PIPELINE)} replies in {(time.monotonic() - start) * 1000:.0f} ms")
+    if sorted(order) != list(range(100, 100 + len(PIPELINE))):
+        print("FAILED: missing or duplicated sequence IDs")
+        return False
+    if order[0] == 100:
+        print("FAILED: SCAN reply overtook faster requests")
+        return False
+    return True
+
+
+def run_discovery(master, decoder, seq, full):
+    """Send DISCOVER and collect streamed records up to the final result"""
+    start = time.monotonic()
+    os.write(master, proto.encode_frame(proto.OP_DISCOVER, seq, bytes([proto.DISCOVER_FULL if full else 0])))
+    first_part = None
+    parts = []
+    while True:
+        message, _ = read_reply(master, decoder)
+        if message[0] != "frame" or message[2] != seq:
+            raise ValueError("unexpected reply " + repr(message))
+        if message[1] == proto.OP_RESULT_PART:
+            if first_part is None:
+                first_part = (time.monotonic() - start) * 1000
+            parts.append(message[3][1:].decode('utf-8'))
+            continue
+        total = (time.monotonic() - start) * 1000
+        summary = message[3][1:].decode('utf-8').splitlines()[0]
+        label = "full" if full else "incremental"
+        print(f"discover ({label}): {len(parts)} records, first after {first_part or 0:.0f} ms, "
+              f"done in {total:.0f} ms - {summary}")
+        return parts, first_part
+
+
+def run_stats(master, decoder, seq):
+    """Fetch the latency breakdown; long text arrives as several parts"""
+    os.write(master, proto.encode_frame(proto.OP_STATS, seq))
+    text = b''
+    while True:
+        message, _ = read_reply(master, decoder)
+        if message[0] != "frame" or message[2] != seq:
+            raise ValueError("unexpected reply " + repr(message))
+        text += message[3][1:]
+        if message[1] != proto.OP_RESULT_PART:
+            break
+    text = text.decode('utf-8')
+    print(text)
+    return "CUSTOM n=" in text and "\n cec " in text
+
+
+def main():
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    controller = CECController(uart_port=os.ttyname(slave))
+    controller.running = True
+    controller.start_uart_interface()
+
+    decoder = proto.FrameDecoder()
+    failures = 0
+    totals = {"json": [0, 0], "binary": [0, 0]}
+    print(f"{'request':<48} {'json tx/rx':>11} {'bin tx/rx':>10}  result")
+    try:
+        for seq, (json_request, opcode, payload) in enumerate(REQUESTS, start=1):
+            json_request = dict(json_request, id=seq)
+            line = (json.dumps(json_request, separators=(',', ':')) + '\n').encode('utf-8')
+            os.write(master, line)
+            message, json_rx = read_reply(master, decoder)
+            json_result = decode_json_reply(message, seq)
+
+            frame = proto.encode_frame(opcode, seq, payload)
+            os.write(master, frame)
+            message, bin_rx = read_reply(master, decoder)
+            bin_result = decode_frame_reply(message, seq)
+
+            totals["json"][0] += len(line)
+            totals["json"][1] += json_rx
+            totals["binary"][0] += len(frame)
+            totals["binary"][1] += bin_rx
+
+            match = normalize(json_result) == normalize(bin_result)
+            if not match:
+                failures += 1
+            status = "ok" if json_result[0] else "error"
+            print(f"{line.decode('utf-8').strip()[:48]:<48} {len(line):>5}/{json_rx:<5} {len(frame):>4}/{bin_rx:<5} "
+                  f"{status}{'' if match else '  MISMATCH ' + repr((json_result, bin_result))}")
+
+        if not run_pipeline(master, decoder):
+            failures += 1
+
+        full_parts, first_part = run_discovery(master, decoder, 200, True)
+        incremental_parts, _ = run_discovery(master, decoder, 201, False)
+        if not full_parts or first_part is None or full_parts != incremental_parts:
+            print("FAILED: discovery did not stream the same devices twice")
+            failures += 1
+        # Addresses 10-14 go to cec-client in hex like the rest
+        found = [part.split()[0] for part in full_parts]
+        if found != ["#0", "#1", "#B"]:
+            print(f"FAILED: discovery found {found}, expected #0, #1 and #B")
+            failures += 1
+
+        if not run_stats(master, decoder, 202):
+            print("FAILED: STATS has no cec-client timings")
+            failures += 1
+    finally:
+        controller.stop()
+        os.close(master)
+
+    json_tx, json_rx = totals["json"]
+    bin_tx, bin_rx = totals["binary"]
+    print(f"requests on the wire: json {json_tx} B, binary {bin_tx} B ({json_tx / bin_tx:.1f}x smaller)")
+    print(f"replies on the wire:  json {json_rx} B, binary {bin_rx} B ({json_rx / bin_rx:.1f}x smaller)")
+    print(f"crc errors: {decoder.crc_errors}")
+    if failures:
+        print(f"FAILED: {failures} mismatched round trips")
+        return 1
+    print("all round trips matched")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
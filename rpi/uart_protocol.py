@@ -0,0 +1,367 @@
+#!/usr/bin/env python3
+"""
+Flipper <-> Pi UART wire protocol
+Binary frames carry an opcode and raw CEC bytes; newline-terminated JSON is
+still accepted so older Flipper builds keep working. The Flipper asks for
+binary mode by sending {"command":"PING","proto":N} and switches only if
+the reply echoes the same version; any mismatch stays on JSON.
+
+Frame layout (little endian):
+  0xA5 | len (2) | opcode | seq | payload (len - 2) | crc16 (2)
+len counts opcode + seq + payload, the CRC (CCITT-FALSE) covers len..payload.
+
+Every request carries a sequence ID (1-255) that is echoed in its reply, so
+several requests can be in flight and replies may come back out of order.
+JSON requests use an optional "id" field for the same purpose. Sequence 0
+is reserved for messages that do not answer a request.
+
+Long-running requests (DISCOVER) may send any number of OP_RESULT_PART
+frames, or JSON lines with "partial": true, before their final result.
+A result text longer than one payload is sent the same way: its leading
+chunks, cut at line breaks where possible, go out as OP_RESULT_PART and
+the last chunk carries the final opcode.
+
+OP_BAUD moves the link to a faster rate, see baud_rate.py. It is handled
+by the UART thread itself and never queued behind other requests.
+
+OP_KEY streams a held remote key (down, repeats, up), see key_hold.py.
+Key frames go out with sequence 0 and are never answered; the UART thread
+hands them on in arrival order.
+
+OP_WATCH asks for OP_EVENT frames: the Pi sends what it knows of the bus
+right away, then one event whenever a device powers on or off, appears or
+disappears, or the active source changes. Events go out with sequence 0
+in between replies, and stop when the Flipper opens a new session with a
+JSON PING. OP_WATCH itself is not answered.
+
+Once the daemon has opened the CEC adapter at startup it sends one
+EVENT_READY, watched or not, so a Flipper that is still waiting for the Pi
+to boot can PING right away instead of at its next retry. A Flipper that
+is already connected takes it as a sign the daemon restarted.
+"""
+
+FRAME_SYNC = 0xA5
+PROTOCOL_VERSION = 3
+MAX_PAYLOAD = 512
+MAX_JSON_LINE = 1024
+
+# Requests (Flipper -> Pi)
+OP_PING = 0x01
+OP_SCAN = 0x02
+OP_STATUS = 0x03          # payload: optional flags (STATUS_REFRESH)
+OP_POWER_ON = 0x04        # payload: logical address
+OP_POWER_OFF = 0x05       # payload: logical address
+OP_TX = 0x06              # payload: raw CEC frame (header, opcode, operands)
+OP_VOLUME_UP = 0x07
+OP_VOLUME_DOWN = 0x08
+OP_MUTE = 0x09
+OP_CUSTOM = 0x0A          # payload: cec-client command text
+OP_DISPLAY_LOGS = 0x0B
+OP_CLEAR_LOG = 0x0C
+OP_DISCOVER = 0x0D        # payload: optional flags (DISCOVER_FULL)
+OP_SEQUENCE = 0x0E        # payload: see sequence_from_payload()
+OP_STATS = 0x0F           # payload: optional flags (STATS_RESET)
+OP_BAUD = 0x10            # payload: action | rate (4, LE) [| BAUD_PATTERN for BAUD_VERIFY]
+OP_KEY = 0x11             # payload: action | UI command code [| destination]; not answered
+OP_WATCH = 0x12           # payload: 1 to receive OP_EVENT frames, 0 to stop; not answered
+
+# Responses (Pi -> Flipper)
+OP_RESULT = 0x80          # payload: status byte + UTF-8 result text
+OP_RESULT_PART = 0x81     # same payload; more replies follow with this seq
+OP_EVENT = 0x82           # payload: event type | logical address [| data]; unsolicited, seq 0
+
+STATUS_OK = 0x00
+STATUS_ERROR = 0x01
+
+# OP_STATUS flags
+STATUS_REFRESH = 0x01     # ask the TV instead of answering from the bus state
+
+# OP_DISCOVER flags
+DISCOVER_FULL = 0x01      # forget known devices and query everything again
+
+# OP_STATS flags
+STATS_RESET = 0x01        # clear the latency histograms
+
+# OP_BAUD actions
+BAUD_PROPOSE = 0x00       # answered at the current rate, then the Pi switches
+BAUD_VERIFY = 0x01        # sent at the new rate; the reply echoes the pattern
+
+# OP_KEY actions
+KEY_DOWN = 0x00
+KEY_REPEAT = 0x01         # key still held, sent while the Flipper repeats it
+KEY_UP = 0x02
+
+# OP_KEY destination: the Pi picks, the audio system for volume keys and the TV otherwise
+KEY_DEST_AUTO = 0x0F
+
+# OP_EVENT types and their data
+EVENT_POWER = 0x01        # CEC power status (0 on, 1 standby, 2/3 in transition)
+EVENT_SOURCE = 0x02       # physical address (2, BE); address 0x0F when no known device is there
+EVENT_DEVICE = 0x03       # OSD name, may be empty; sent again when the name changes
+EVENT_GONE = 0x04         # none
+EVENT_READY = 0x05        # 1 when the CEC adapter opened, 0 when it failed; address 0x0F
+
+# OP_EVENT logical address of a source nobody announced
+EVENT_NO_DEVICE = 0x0F
+
+# Verification bytes: every bit toggling, runs of ones and zeros
+BAUD_PATTERN = bytes([0x55, 0xAA, 0x00, 0xFF] * 8)
+
+# OP_SEQUENCE completion conditions, checked with "pow <address>"
+UNTIL_NONE = 0x00
+UNTIL_POWER_ON = 0x01
+UNTIL_STANDBY = 0x02
+# Or-ed into the condition: check it during the delays and learn the device's timing
+UNTIL_ADAPTIVE = 0x80
+
+UNTIL_MATCH = {
+    UNTIL_POWER_ON: r"power status:\s*on\b",
+    UNTIL_STANDBY: r"power status:\s*standby",
+}
+
+# Opcodes that map one-to-one onto a JSON command name
+SIMPLE_COMMANDS = {
+    OP_PING: "PING",
+    OP_SCAN: "SCAN",
+    OP_DISPLAY_LOGS: "DISPLAY_LOGS_ON_HDMI",
+    OP_CLEAR_LOG: "CLEAR_FLIPPER_LOG",
+}
+
+# Opcodes that map onto a fixed cec-client command
+CLIENT_COMMANDS = {
+    OP_VOLUME_UP: "volup",
+    OP_VOLUME_DOWN: "voldown",
+    OP_MUTE: "mute",
+}
+
+
+class ProtocolError(Exception):
+    """Raised for frames that decode but cannot be turned into a request"""
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, matches cec_remote_crc16() on the Flipper"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+
+def encode_frame(opcode, seq=0, payload=b''):
+    """Build one wire frame"""
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("payload too large")
+    length = len(payload) + 2
+    body = bytes([length & 0xFF, length >> 8, opcode, seq & 0xFF]) + payload
+    crc = crc16(body)
+    return bytes([FRAME_SYNC]) + body + bytes([crc & 0xFF, crc >> 8])
+
+
+class FrameDecoder:
+    """Incremental decoder for a byte stream mixing frames and JSON lines
+
+    feed() returns a list of messages, each either
+    ("frame", opcode, seq, payload) or ("json", line). Corrupt frames are
+    dropped and the decoder resyncs on the next sync byte, or on a '{'
+    that starts a line so a '{' inside a corrupt frame is not read as JSON.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.line_start = True  # Last byte consumed ended a line or a frame
+        self.crc_errors = 0
+        self.noise = 0          # Bytes dropped that were neither a frame nor JSON
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        messages = []
+        while self.buffer:
+            first = self.buffer[0]
+            if first == FRAME_SYNC:
+                if len(self.buffer) < 3:
+                    break
+                length = self.buffer[1] | (self.buffer[2] << 8)
+                if length < 2 or length > MAX_PAYLOAD + 2:
+                    self.noise += 1
+                    self.line_start = False
+                    del self.buffer[0]
+                    continue
+                total = 3 + length + 2
+                if len(self.buffer) < total:
+                    break
+                body = bytes(self.buffer[1:3 + length])
+                crc = self.buffer[3 + length] | (self.buffer[4 + length] << 8)
+                if crc16(body) != crc:
+                    self.crc_errors += 1
+                    self.line_start = False
+                    del self.buffer[0]
+                    continue
+                messages.append(("frame", body[2], body[3], body[4:]))
+                del self.buffer[:total]
+                self.line_start = True
+            elif first == ord('{') and self.line_start:
+                end = self.buffer.find(b'\n')
+                if end < 0:
+                    if len(self.buffer) > MAX_JSON_LINE:
+                        self.line_start = False
+                        del self.buffer[0]
+                        continue
+                    break
+                line = self.buffer[:end].decode('utf-8', errors='replace').strip()
+                del self.buffer[:end + 1]
+                if line:
+                    messages.append(("json", line))
+            else:
+                # Line noise, CR/LF padding or the tail of a corrupt frame
+                if first not in (0x0A, 0x0D):
+                    self.noise += 1
+                self.line_start = first == 0x0A
+                del self.buffer[0]
+        return messages
+
+
+def format_tx(frame):
+    """Raw CEC bytes as a cec-client tx command"""
+    return "tx " + ":".join("%02X" % b for b in frame)
+
+
+def sequence_from_payload(payload):
+    """Decode an OP_SEQUENCE payload into a SEQUENCE command dict
+
+    attempts | settle (100 ms) | until | until address, then per step:
+    delay after (100 ms) | retries | length | raw CEC frame
+
+    until may carry UNTIL_ADAPTIVE, which makes it an adaptive sequence.
+    """
+    if len(payload) < 4:
+        raise ProtocolError("Short sequence header")
+    attempts, settle, until, address = payload[0], payload[1], payload[2], payload[3]
+    adaptive = bool(until & UNTIL_ADAPTIVE)
+    until &= ~UNTIL_ADAPTIVE
+    steps = []
+    pos = 4
+    while pos < len(payload):
+        if pos + 3 > len(payload):
+            raise ProtocolError("Truncated sequence step")
+        delay, retries, length = payload[pos], payload[pos + 1], payload[pos + 2]
+        frame = payload[pos + 3:pos + 3 + length]
+        if length == 0 or len(frame) != length:
+            raise ProtocolError("Truncated sequence step")
+        steps.append({"cec": format_tx(frame), "delay": delay / 10, "retries": retries})
+        pos += 3 + length
+
+    command = {"command": "SEQUENCE", "steps": steps, "attempts": attempts, "settle": settle / 10}
+    if until in UNTIL_MATCH:
+        command["until"] = {"cec": "pow %x" % address, "match": UNTIL_MATCH[until]}
+    elif until != UNTIL_NONE:
+        raise ProtocolError("Unknown sequence condition: %d" % until)
+    if adaptive:
+        command["adaptive"] = True
+    return command
+
+
+def baud_from_payload(payload):
+    """Decode an OP_BAUD payload into (action, rate, pattern)"""
+    if len(payload) < 5 or payload[0] not in (BAUD_PROPOSE, BAUD_VERIFY):
+        raise ProtocolError("Bad baud request")
+    rate = int.from_bytes(payload[1:5], "little")
+    return payload[0], rate, bytes(payload[5:])
+
+
+def key_from_payload(payload):
+    """Decode an OP_KEY payload into (action, key, destination)"""
+    if len(payload) < 2 or payload[0] not in (KEY_DOWN, KEY_REPEAT, KEY_UP):
+        raise ProtocolError("Bad key event")
+    destination = payload[2] & 0xF if len(payload) > 2 else KEY_DEST_AUTO
+    return payload[0], payload[1], destination
+
+
+def watch_from_payload(payload):
+    """Whether an OP_WATCH payload turns events on"""
+    return not payload or bool(payload[0])
+
+
+def encode_event_frame(kind, logical, value=None):
+    """One OP_EVENT frame; value is the power code, physical address, name or ready flag for kind"""
+    if kind in (EVENT_POWER, EVENT_READY):
+        data = bytes([value])
+    elif kind == EVENT_SOURCE:
+        data = value.to_bytes(2, "big")
+    elif kind == EVENT_DEVICE:
+        data = (value or "").encode("utf-8")[:MAX_PAYLOAD - 2]
+    else:
+        data = b''
+    return encode_frame(OP_EVENT, 0, bytes([kind, logical & 0xF]) + data)
+
+
+def request_from_frame(opcode, payload):
+    """Translate a binary request into the command dict process_command uses"""
+    if opcode in SIMPLE_COMMANDS:
+        return {"command": SIMPLE_COMMANDS[opcode]}
+    if opcode in CLIENT_COMMANDS:
+        return {"command": "CUSTOM", "cec_command": CLIENT_COMMANDS[opcode]}
+    if opcode == OP_POWER_ON:
+        address = payload[0] if payload else 0
+        return {"command": "CUSTOM", "cec_command": "on %x" % address}
+    if opcode == OP_POWER_OFF:
+        address = payload[0] if payload else 0
+        return {"command": "CUSTOM", "cec_command": "standby %x" % address}
+    if opcode == OP_TX:
+        if not payload:
+            raise ProtocolError("Empty CEC frame")
+        return {"command": "CUSTOM", "cec_command": format_tx(payload)}
+    if opcode == OP_CUSTOM:
+        return {"command": "CUSTOM", "cec_command": payload.decode('utf-8', errors='replace')}
+    if opcode == OP_STATUS:
+        flags = payload[0] if payload else 0
+        return {"command": "STATUS", "refresh": bool(flags & STATUS_REFRESH)}
+    if opcode == OP_DISCOVER:
+        flags = payload[0] if payload else 0
+        return {"command": "DISCOVER", "full": bool(flags & DISCOVER_FULL)}
+    if opcode == OP_SEQUENCE:
+        return sequence_from_payload(payload)
+    if opcode == OP_STATS:
+        flags = payload[0] if payload else 0
+        return {"command": "STATS", "reset": bool(flags & STATS_RESET)}
+    raise ProtocolError("Unknown opcode: 0x%02X" % opcode)
+
+
+def response_succeeded(response):
+    """Flatten the JSON response convention into a single success flag"""
+    if response.get("status") != "success":
+        return False
+    return not str(response.get("result", "")).startswith("❌")
+
+
+def split_result_text(text, limit=MAX_PAYLOAD - 1):
+    """Cut UTF-8 text into chunks of at most limit bytes, after a line break where possible"""
+    data = text.encode('utf-8')
+    chunks = []
+    while len(data) > limit:
+        cut = data.rfind(b'\n', 0, limit) + 1
+        if cut == 0:
+            # One long line: cut before a UTF-8 continuation byte, never inside a character
+            cut = limit
+            while cut > 0 and (data[cut] & 0xC0) == 0x80:
+                cut -= 1
+        chunks.append(data[:cut])
+        data = data[cut:]
+    chunks.append(data)
+    return chunks
+
+
+def encode_result_frame(response, seq=0, opcode=OP_RESULT):
+    """Encode a process_command response dict as OP_RESULT frame(s)
+
+    Text that does not fit one payload is streamed as OP_RESULT_PART frames
+    followed by a last frame with opcode, so nothing is truncated.
+    """
+    status = STATUS_OK if response_succeeded(response) else STATUS_ERROR
+    chunks = split_result_text(str(response.get("result", "")))
+    frames = [encode_frame(OP_RESULT_PART, seq, bytes([status]) + chunk) for chunk in chunks[:-1]]
+    frames.append(encode_frame(opcode, seq, bytes([status]) + chunks[-1]))
+    return b''.join(frames)
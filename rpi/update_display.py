@@ -1,41 +1,40 @@
 #!/usr/bin/env python3
-import subprocess
+import socket
 import sys
 import os
 
-def update_display(status):
-    """Update HDMI display with pre-made status image"""
-    user_home = os.path.expanduser('~')
-    image_map = {
-        'ready': f'{user_home}/status_ready.png',
-        'sending': f'{user_home}/status_sending.png',
-        'success': f'{user_home}/status_success.png',
-        'error': f'{user_home}/status_error.png'
-    }
-    
-    if status in image_map:
-        try:
-            env = os.environ.copy()
-            env['DISPLAY'] = ':0'
-            env['HOME'] = user_home
-            
-            # Kill existing feh processes first
-            subprocess.run(['pkill', '-f', 'feh'], check=False)
-            
-            # Start new feh process
-            subprocess.Popen([
-                'feh', '--fullscreen', '--hide-pointer', 
-                image_map[status]
-            ], env=env)
-            
-            print(f"Display updated to: {status}")
-        except Exception as e:
-            print(f"Display update failed: {e}")
-    else:
+SOCKET_PATH = os.environ.get("CEC_DISPLAY_SOCKET", "/run/cec-display.sock")
+STATUSES = ('idle', 'ready', 'sending', 'success', 'error')
+
+def update_display(status, wait=False):
+    """Ask the status renderer (status_display.py) to show a status image
+
+    One datagram, so callers on a hot path do not wait for the screen.
+    With wait, returns only once the image is on screen."""
+    if status not in STATUSES:
         print(f"Unknown status: {status}")
+        return False
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+    try:
+        if wait:
+            sock.bind('')  # Autobind, so the renderer can answer
+            sock.settimeout(2.0)
+        sock.sendto(status.encode(), SOCKET_PATH)
+        if wait and sock.recv(16) != b'ok':
+            print(f"Display has no image for: {status}")
+            return False
+        print(f"Display updated to: {status}")
+        return True
+    except OSError as e:
+        print(f"Display update failed (is status_display.py running?): {e}")
+        return False
+    finally:
+        sock.close()
 
 if __name__ == "__main__":
     if len(sys.argv) > 1:
-        update_display(sys.argv[1])
+        ok = update_display(sys.argv[1], wait=True)
     else:
-        update_display('ready')
+        ok = update_display('ready', wait=True)
+    sys.exit(0 if ok else 1)